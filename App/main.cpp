@@ -2,8 +2,26 @@
 #include "emu6502.h"
 #include "bus.h"
 #include "assembler.h"
+#include "pacer.h"
+#include "metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: exec [MHz] [-n name]
+// Without a clock rate the emulation runs as fast as possible, with one it is paced to it.
+// The statistics are published to the shared memory object name, /emu6502-<pid> by default,
+// Build/stats shows them.
+int main(int argc, char** argv){
+    const char* name = nullptr;
+    const char* mhz = nullptr;
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-n") && i + 1 < argc)
+            name = argv[++i];
+        else
+            mhz = argv[i];
+    }
 
-int main(){
     Bus bus;
     bus.cpu.reset();
 
@@ -28,9 +46,26 @@ int main(){
     
     bus.loadProgram(assambler.convert());
 
-    while(!bus.shouldTerminate()) // Window will close by pressing ESC
+    double frequency = mhz ? atof(mhz) * 1e6 : 1e6;
+    Metrics metrics(&bus, name, frequency);
+    if(metrics.open())
+        printf("Statistics in %s\n", metrics.getName());
+    else
+        printf("Can't create %s, no statistics\n", metrics.getName());
+
+    if(mhz){
+        Pacer pacer(&bus, frequency);
+        pacer.metrics = &metrics;
+        pacer.run(); // Window will close by pressing ESC
+        pacer.report(stdout);
+    }
+    else while(!bus.shouldTerminate()) // Window will close by pressing ESC
     {
+        // A clock can take several cycles with the cycle accurate timing
+        unsigned long long last = bus.clockCount;
         bus.clock();
+        if((bus.clockCount >> 16) != (last >> 16))
+            metrics.publish();
     }
     
 
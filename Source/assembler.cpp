@@ -1,4 +1,8 @@
 #include "assembler.h"
+#include "cpuVariants.h"
+
+#include <stdio.h>
+#include <array>
 
 Assembler::Assembler(std::string in){
     input = std::stringstream(in);
@@ -12,47 +16,53 @@ std::string Assembler::convert(){
     while(!input.eof()){
         token.clear();
         input >> token;
-        if (addressTable.find(token) != addressTable.end()){
+        if(token.empty())   // Trailing whitespace
+            break;
+        if (isMnemonic(token)){
             getAddressmode();
             switch(addressMode){
                 case Implicit:
-                    output << ("0x" + addressTable[token].Implicit + " ");
+                    output << ("0x" + code(Implicit) + " ");
                 break;
                 case Accumulator:
-                    output << ("0x" + addressTable[token].Accumulator + " ");
+                    output << ("0x" + code(Accumulator) + " ");
                 break;
                 case Immediate:
-                    output << ("0x" + addressTable[token].Immediate + " " + value + " ");
+                    output << ("0x" + code(Immediate) + " " + value + " ");
                 break;
                 case ZeroPage:
-                    output << ("0x" + addressTable[token].ZeroPage + " " + value + " ");
+                    output << ("0x" + code(ZeroPage) + " " + value + " ");
                 break;
                 case ZeroPageX:
-                    output << ("0x" + addressTable[token].ZeroPageX + " " + value + " ");
+                    output << ("0x" + code(ZeroPageX) + " " + value + " ");
                 break;
                 case ZeroPageY:
-                    output << ("0x" + addressTable[token].ZeroPageY + " " + value + " ");
+                    output << ("0x" + code(ZeroPageY) + " " + value + " ");
                 break;
                 case Relative:
-                    output << ("0x" + addressTable[token].Relative + " " + value + " ");
+                    output << ("0x" + code(Relative) + " " + value + " ");
                 break;
                 case Absolute:
-                    output << ("0x" + addressTable[token].Absolute + " " + value + " ");
+                    output << ("0x" + code(Absolute) + " " + value + " ");
                 break;
                 case AbsoluteX:
-                    output << ("0x" + addressTable[token].AbsoluteX + " " + value + " ");
+                    output << ("0x" + code(AbsoluteX) + " " + value + " ");
                 break;
                 case AbsoluteY:
-                    output << ("0x" + addressTable[token].AsboluteY + " " + value + " ");
+                    output << ("0x" + code(AbsoluteY) + " " + value + " ");
                 break;
                 case Indirect:
-                    output << ("0x" + addressTable[token].Indirect + " " + value + " ");
+                    output << ("0x" + code(Indirect) + " " + value + " ");
                 break;
                 case IndirectX:
-                    output << ("0x" + addressTable[token].IndirectX + " " + value + " ");
+                    output << ("0x" + code(IndirectX) + " " + value + " ");
                 break;
                 case IndirectY:
-                    output << ("0x" + addressTable[token].IndirectY + " " + value + " ");
+                    output << ("0x" + code(IndirectY) + " " + value + " ");
+                break;
+                case ZeroPageIndirect:
+                case AbsoluteIndirectX:
+                    // Not found by getAddressmode(), only SourceAssembler knows them
                 break;
             };
         }
@@ -68,7 +78,7 @@ std::string Assembler::convert(){
 
 void Assembler::getAddressmode(){
     // Implicit and Relative mode always have to be used if available
-    if(!addressTable[token].Implicit.empty()){
+    if(opcode(token, Implicit) >= 0){
         addressMode = Implicit;
         return;
     }
@@ -76,7 +86,7 @@ void Assembler::getAddressmode(){
     nextToken.clear();
     input >> nextToken;
 
-    if(!addressTable[token].Relative.empty()){
+    if(opcode(token, Relative) >= 0){
         addressMode = Relative;
         if(nextToken[0] == '$' & isHex(nextToken.substr(1)) && nextToken.size() == 3)
             value = "0x" + nextToken.substr(1);
@@ -162,6 +172,46 @@ void Assembler::getAddressmode(){
 }
 
 
+int Assembler::opcode(const std::string& mnemonic, addressModeEnum mode){
+    // Columns in the order of addressModeEnum, built once from the shared table
+    static const std::map<std::string, std::array<int, 15>> table = []{
+        static const BYTE modes[MODE_COUNT] = { Implicit, Accumulator, Immediate, ZeroPage, ZeroPageX, ZeroPageY, Relative,
+                                                Absolute, AbsoluteX, AbsoluteY, Indirect, IndirectX, IndirectY,
+                                                ZeroPageIndirect, AbsoluteIndirectX };
+        std::map<std::string, std::array<int, 15>> table;
+        for(int op = 0; op < 256; op++){
+            if(!CPU_OPCODES[op].legal)
+                continue;
+            auto [entry, added] = table.try_emplace(CPU_OPCODES[op].name);
+            if(added)
+                entry->second.fill(-1);
+            // BRK is written without the byte the CPU skips
+            entry->second[op == 0x00 ? (BYTE) Implicit : modes[CPU_OPCODES[op].mode]] = op;
+        }
+        return table;
+    }();
+
+    auto it = table.find(mnemonic);
+    return it == table.end() ? -1 : it->second[mode];
+}
+
+bool Assembler::isMnemonic(const std::string& mnemonic){
+    for(int mode = Accumulator; mode <= AbsoluteIndirectX; mode++){
+        if(opcode(mnemonic, (addressModeEnum) mode) >= 0)
+            return true;
+    }
+    return false;
+}
+
+std::string Assembler::code(addressModeEnum mode){
+    int op = opcode(token, mode);
+    if(op < 0)
+        return "";
+    char digits[12];
+    snprintf(digits, sizeof(digits), "%02X", op);
+    return digits;
+}
+
 bool Assembler::isHex(std::string inputStr){
     static std::string hexDigits = "0123456789ABCDEFabcdef";
     for(char x : inputStr){
@@ -1,78 +1,494 @@
 #include "bus.h"
 
-Bus::Bus(){
+#include <string.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+Bus::Bus(Layout layout) : layout(layout){
     // Connecting the devices with the bus
     cpu.ConnectBus(this);
     od.ConnectBus(this);
     dd.ConnectBus(this);
+    dma.ConnectBus(this);
+    mmu.ConnectBus(this);
+    vd.ConnectBus(this);
+    in.ConnectBus(this);
+    // A flat bus has no timer, its registers are RAM
+    if(layout == Layout::Devices)
+        timer.ConnectBus(this);
     
-    // Clearing 
-    for(BYTE &i : ram){
-        i = 0x00;
+    // Anonymous memory starts cleared, the OS only backs the 4kB pages which are touched
+    void* data = mmap(nullptr, MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(data == MAP_FAILED)
+        throw std::bad_alloc();
+    memory = (BYTE*) data;
+    for(unsigned page = 0; page < 256; page++)
+        readMap[page] = writeMap[page] = memory + page * 256;
+};
+
+Bus::Bus(std::shared_ptr<const IMAGE> image) : Bus(image->layout){
+    this->image = image;
+    for(unsigned page = 0; page < 256; page++){
+        if(!(image->used[page >> 6] & (1ULL << (page & 63))))
+            continue;
+        cow[page >> 6] |= 1ULL << (page & 63);
+        readMap[page] = (BYTE*) image->data.data() + page * 256;
+        writeMap[page] = nullptr;
     }
+}
+
+Bus::~Bus(){
+    munmap(memory, MEMORY_SIZE);
+};
 
-    for(BYTE &i : stack){
-        i = 0x00;
+// Starting point
+void Bus::clock(){
+    // The cycle accurate CPU clocks the devices itself, after each of its accesses
+    if constexpr(emu6502::accurate){
+        unsigned long long start = clockCount;
+        if(stallCycles > 0)
+            stallCycles--;
+        else{
+            bool interrupt = irqPending() && cpu.completed();
+            if(interrupt && scheduler.irq() && cpu.getFlag(emu6502::I) == 0)
+                scheduler.acknowledge();
+            cpu.step(interrupt);
+        }
+        // A stalled or halted CPU doesn't access the bus
+        if(clockCount == start)
+            tick(1);
+        return;
     }
 
-    for(BYTE &i : zeropage){
-        i = 0x00;
+    if(stallCycles > 0)
+        stallCycles--;
+    else{
+        // Interrupts are taken between instructions
+        if(irqPending() && cpu.completed()){
+            // Taking the interrupt acknowledges the requests of the coroutine devices
+            if(scheduler.irq() && cpu.getFlag(emu6502::I) == 0)
+                scheduler.acknowledge();
+            cpu.irq();
+        }
+        cpu.clock();
     }
+    tick(1);
+}
+
+bool Bus::irqPending(){
+    return dma.irq || mb.irq(0) || in.irq() || scheduler.irq();
+}
+
+void Bus::stall(unsigned long cycles){
+    stallCycles += cycles;
+}
+
+bool Bus::stalled(){
+    return stallCycles > 0;
+}
 
-    for(BYTE &i : odRAM){
-        i = 0x00;
+void Bus::tick(unsigned long cycles){
+    for(unsigned long i = 0; i < cycles; i++){
+        // A flat bus is plain memory, its device windows are RAM
+        if(layout == Layout::Devices){
+            od.clock();
+            dd.clock();
+            dma.clock();
+            scheduler.clock(clockCount);
+        }
+        clockCount++;
     }
+}
 
-    for(BYTE &i : ddRAM){
-        i = 0x00;
+void Bus::run(unsigned long long cycles){
+    unsigned long long target = clockCount + cycles;
+    while(clockCount < target && cpu.stop == emu6502::Stop::None){
+        // A pending interrupt would end the idle loop
+        bool interrupt = irqPending() && cpu.getFlag(emu6502::I) == 0;
+        if(cpu.completed() && !interrupt && !in.waiting() && cpu.isIdle()){
+            unsigned long long next = target - clockCount;
+            // The cycle in which a transfer finishes has to be clocked
+            if(dma.pendingCycles() > 0)
+                next = std::min<unsigned long long>(next, dma.pendingCycles() - 1);
+            // So has the one of the next replayed input event
+            if(in.pendingCycles() > 0)
+                next = std::min<unsigned long long>(next, in.pendingCycles());
+            next = std::min<unsigned long long>(next, scheduler.pendingCycles(clockCount));
+            fastForward(next);
+            if(clockCount >= target)
+                break;
+        }
+        clock();
     }
-};
+}
 
-Bus::~Bus(){
-    // Does nothing
-};
+Bus::STOPINFO Bus::runUntilStop(){
+    const emu6502::TRAPS& traps = cpu.getTraps();
+    unsigned long long startCycle = clockCount;
+    unsigned long long startInstruction = cpu.instructions;
+    unsigned long long cycleEnd = traps.maxCycles ? clockCount + traps.maxCycles : ~0ULL;
+    unsigned long long instructionEnd = traps.maxInstructions ? cpu.instructions + traps.maxInstructions : ~0ULL;
 
-// Starting point
-void Bus::clock(){
-    cpu.clock();
-    od.clock();
-    dd.clock();
+    emu6502::Stop reason = emu6502::Stop::None;
+    while(reason == emu6502::Stop::None){
+        if(cpu.stop != emu6502::Stop::None)
+            reason = cpu.stop;
+        else if(shouldTerminate())
+            reason = emu6502::Stop::Terminated;
+        else if(clockCount >= cycleEnd)
+            reason = emu6502::Stop::CycleBudget;
+        else if(cpu.instructions >= instructionEnd && cpu.completed())
+            reason = emu6502::Stop::InstructionBudget;
+        // An instruction budget is counted one clock at a time, otherwise the idle loops are skipped
+        else if(traps.maxInstructions)
+            clock();
+        else
+            run(std::min<unsigned long long>(cycleEnd - clockCount, 4096));
+    }
+
+    STOPINFO info;
+    info.reason = reason;
+    info.pc = cpu.PC;
+    info.opcode = read(cpu.PC);
+    info.value = cpu.exitValue;
+    info.cycles = clockCount - startCycle;
+    info.instructions = cpu.instructions - startInstruction;
+    info.state = cpu.save();
+    return info;
 }
 
-BYTE Bus::read(WORD addr){
-    if(addr >= 0x1000 && addr <= 0xFFFF) // Checks to which storage the address corresponds
-        return ram[addr - 0x1000];
-    
-    else if(addr >= 0x0100 && addr <= 0x01FF)
-        return stack[addr - 0x0100];
-    
-    else if(addr >= 0x0000 && addr <= 0x0100)
-        return zeropage[addr];
+// Polling devices don't notice skipped cycles, only the timed ones have to be advanced
+void Bus::fastForward(unsigned long long cycles){
+    stallCycles -= std::min<unsigned long long>(stallCycles, cycles);
+    if(dma.pendingCycles() > 0)
+        dma.skip(cycles);
+    clockCount += cycles;
+    skippedCycles += cycles;
+}
 
-    else if(addr >= 0x0400 && addr <= 0x0404)
-        return odRAM[addr - 0x0400];
+// Checks if an address corresponds to one of the storages
+bool Bus::isMapped(WORD addr){
+    if(layout == Layout::Flat)
+        return true;
 
-    else if(addr >= 0x0500 && addr <= 0x0502)
-        return ddRAM[addr - 0x0500];
+    return (addr >= 0x1000)                     // ram
+        || (addr <= 0x01FF)                     // zeropage and stack
+        || (addr >= 0x0200 && addr <= 0x0230)   // vdRAM
+        || (addr >= 0x0250 && addr <= 0x0253)   // timerRAM
+        || (addr >= 0x0400 && addr <= 0x0404)   // odRAM
+        || (addr >= 0x0500 && addr <= 0x0502)   // ddRAM
+        || (addr >= 0x0600 && addr <= 0x0608)   // dmaRAM
+        || (addr >= 0x0800 && addr <= 0x0FFF);  // dlRAM
+}
 
-    return 0;
+bool Bus::isMailbox(WORD addr){
+    return layout == Layout::Devices && addr >= MailboxDevice::START && addr <= MailboxDevice::END;
+}
+
+bool Bus::isMmu(WORD addr){
+    return layout == Layout::Devices && addr >= MmuDevice::START && addr <= MmuDevice::END && mmu.enabled();
+}
+
+bool Bus::isInput(WORD addr){
+    return layout == Layout::Devices && addr >= InputDevice::START && addr <= InputDevice::END;
+}
+
+// A switch changes what the CPU sees like a write does
+void Bus::mapPages(BYTE first, unsigned count, BYTE* data, bool writable){
+    for(unsigned page = first; page < first + count && page < 256; page++){
+        unsigned long long bit = 1ULL << (page & 63);
+        touched[page >> 6] |= bit;
+        if(data){
+            readMap[page] = data + (page - first) * 256;
+            writeMap[page] = writable ? readMap[page] : nullptr;
+            remapped[page >> 6] |= bit;
+        }
+        else{
+            readMap[page] = (BYTE*) home(page);
+            writeMap[page] = (cow[page >> 6] & bit) ? nullptr : readMap[page];
+            remapped[page >> 6] &= ~bit;
+        }
+    }
+    if(shared)
+        std::atomic_ref<unsigned long long>(changes).fetch_add(1, std::memory_order_relaxed);
+    else
+        changes++;
+}
+
+const BYTE* Bus::home(BYTE page){
+    if(cow[page >> 6] & (1ULL << (page & 63)))
+        return image->data.data() + page * 256;
+    return memory + page * 256;
+}
+
+// Gives the bus its own copy of a shared page
+void Bus::privatize(BYTE page){
+    unsigned long long bit = 1ULL << (page & 63);
+    if(!(cow[page >> 6] & bit))
+        return;
+    memcpy(memory + page * 256, image->data.data() + page * 256, 256);
+    cow[page >> 6] &= ~bit;
+    if(!(remapped[page >> 6] & bit))
+        readMap[page] = writeMap[page] = memory + page * 256;
+}
+
+void Bus::changed(WORD addr){
+    unsigned long long bit = 1ULL << ((addr >> 8) & 63);
+    if(shared){
+        std::atomic_ref<unsigned long long>(changes).fetch_add(1, std::memory_order_relaxed);
+        std::atomic_ref<unsigned long long>(dirty[addr >> 14]).fetch_or(bit, std::memory_order_relaxed);
+        std::atomic_ref<unsigned long long>(touched[addr >> 14]).fetch_or(bit, std::memory_order_relaxed);
+    }
+    else{
+        changes++;
+        dirty[addr >> 14] |= bit;
+        touched[addr >> 14] |= bit;
+    }
+}
+
+void Bus::markDirty(WORD addr, unsigned long len){
+    for(unsigned long page = addr >> 8; page <= ((unsigned long) addr + len - 1) >> 8; page++){
+        dirty[page >> 6] |= 1ULL << (page & 63);
+        touched[page >> 6] |= 1ULL << (page & 63);
+    }
+}
+
+unsigned long long Bus::changeCount(){
+    return std::atomic_ref<unsigned long long>(changes).load(std::memory_order_relaxed);
+}
+
+// Relaxed atomics compile to plain loads and stores, they only keep the cores of a
+// MultiCore machine from racing on the memory
+BYTE Bus::read(WORD addr){
+    BYTE data = 0;
+    if(isMapped(addr))
+        data = std::atomic_ref<BYTE>(readMap[addr >> 8][addr & 0xFF]).load(std::memory_order_relaxed);
+    else if(isMailbox(addr))
+        data = mb.read(addr);
+    else if(isMmu(addr))
+        data = mmu.read(addr);
+    else if(isInput(addr))
+        data = in.read(addr);
+    if(accessLog)
+        accessLog->push_back({addr, data, false});
+    return data;
 }
 
 void Bus::write(WORD addr, BYTE data){
-    if(addr >= 0x1000 && addr <= 0xFFFF) // Checks to which storage the address corresponds
-        ram[addr - 0x1000] = data;
+    if(accessLog)
+        accessLog->push_back({addr, data, true});
+    if(isMapped(addr)){
+        // Coroutine devices see every write they wait for, also the ones which change nothing.
+        // They run on the thread of the bus, which drives core 0 of a MultiCore machine.
+        if(scheduler.watches(addr) && MailboxDevice::core == 0)
+            scheduler.written(addr, data);
+        if(std::atomic_ref<BYTE>(readMap[addr >> 8][addr & 0xFF]).load(std::memory_order_relaxed) == data)
+            return;
+        BYTE* page = writeMap[addr >> 8];
+        if(!page){
+            // A shared page is copied on its first write, a ROM bank ignores writes
+            if(remapped[addr >> 14] & (1ULL << ((addr >> 8) & 63)))
+                return;
+            privatize(addr >> 8);
+            page = writeMap[addr >> 8];
+        }
+        std::atomic_ref<BYTE>(page[addr & 0xFF]).store(data, std::memory_order_relaxed);
+        changed(addr);
+    }
+    else if(isMailbox(addr))
+        mb.write(addr, data);
+    else if(isMmu(addr))
+        mmu.write(addr, data);
+    else if(isInput(addr))
+        in.write(addr, data);
+}
 
-    else if(addr >= 0x0100 && addr <= 0x01FF)
-        stack[addr - 0x0100] = data;
-    
-    else if(addr >= 0x0000 && addr <= 0x0100)
-        zeropage[addr] = data;
+// True if the block doesn't wrap and lies in one of the larger storages
+bool Bus::isMappedBlock(WORD addr, unsigned long len){
+    unsigned long end = (unsigned long) addr + len - 1;
+    if(len == 0 || end > 0xFFFF || accessLog || shared)
+        return false;
+    // Switched and shared pages aren't in memory
+    unsigned long long foreign = remapped[0] | remapped[1] | remapped[2] | remapped[3] | cow[0] | cow[1] | cow[2] | cow[3];
+    for(unsigned long page = addr >> 8; page <= end >> 8 && foreign; page++)
+        if((remapped[page >> 6] | cow[page >> 6]) & (1ULL << (page & 63)))
+            return false;
+    if(layout == Layout::Flat)
+        return true;
+    return (addr >= 0x0800)                     // dlRAM and ram are adjacent
+        || (end <= 0x01FF);                     // zeropage and stack
+}
+
+void Bus::copy(WORD dst, WORD src, WORD len){
+    if(isMappedBlock(dst, len) && isMappedBlock(src, len)){
+        memmove(memory + dst, memory + src, len);
+        markDirty(dst, len);
+        changes++;
+        return;
+    }
+    for(unsigned long i = 0; i < len; i++)
+        write(dst + i, read(src + i));
+}
+
+void Bus::fill(WORD dst, BYTE data, WORD len){
+    if(isMappedBlock(dst, len)){
+        memset(memory + dst, data, len);
+        markDirty(dst, len);
+        changes++;
+        return;
+    }
+    for(unsigned long i = 0; i < len; i++)
+        write(dst + i, data);
+}
+
+void Bus::checkpoint(){
+    baseline.resize(MEMORY_SIZE);
+    for(unsigned page = 0; page < 256; page++)
+        memcpy(baseline.data() + page * 256, home(page), 256);
+    baselineState = snapshot();
+    baselineState.pages.clear();
+    baselineState.data.clear();
+    for(unsigned long long& bits : dirty)
+        bits = 0;
+}
+
+unsigned Bus::dirtyPages(){
+    unsigned count = 0;
+    for(unsigned long long bits : dirty)
+        count += __builtin_popcountll(bits);
+    return count;
+}
+
+void Bus::takeWrites(unsigned long long pages[4]){
+    for(unsigned i = 0; i < 4; i++)
+        pages[i] = std::atomic_ref<unsigned long long>(touched[i]).exchange(0, std::memory_order_relaxed);
+}
+
+// Copies the dirty pages back from the baseline
+void Bus::restore(){
+    if(baseline.empty())
+        return;
+    for(unsigned i = 0; i < 4; i++){
+        for(unsigned long long bits = dirty[i]; bits; bits &= bits - 1){
+            unsigned page = i * 64 + __builtin_ctzll(bits);
+            // A shared page only gets dirty through a switched window, it wasn't written itself
+            if(!(cow[i] & (1ULL << (page & 63))))
+                memcpy(memory + page * 256, baseline.data() + page * 256, 256);
+        }
+        touched[i] |= dirty[i];
+        dirty[i] = 0;
+    }
+    cpu.load(baselineState.cpu);
+    dma.load(baselineState.dma);
+    clockCount = baselineState.clockCount;
+    stallCycles = baselineState.stallCycles;
+    changes++;
+    resetDevices();
+}
+
+// The pages of the snapshot stay dirty, they differ from the baseline
+void Bus::restore(const SNAPSHOT& snapshot){
+    if(baseline.empty())
+        return;
+    restore();
+    for(size_t i = 0; i < snapshot.pages.size(); i++){
+        BYTE page = snapshot.pages[i];
+        privatize(page);
+        memcpy(memory + page * 256, snapshot.data.data() + i * 256, 256);
+        dirty[page >> 6] |= 1ULL << (page & 63);
+        touched[page >> 6] |= 1ULL << (page & 63);
+    }
+    cpu.load(snapshot.cpu);
+    dma.load(snapshot.dma);
+    clockCount = snapshot.clockCount;
+    stallCycles = snapshot.stallCycles;
+    resetDevices();
+}
+
+// The devices which aren't part of a checkpoint start over. The coroutines can't be saved, the
+// devices start them again on the restored registers and clock.
+void Bus::resetDevices(){
+    od.reset();
+    mb.reset();
+    in.reset();
+    scheduler.reset(clockCount);
+    if(layout == Layout::Devices)
+        timer.restart();
+    // They run up to their first wait, so they see the writes which follow the restore
+    scheduler.clock(clockCount);
+}
 
+Bus::SNAPSHOT Bus::snapshot(){
+    SNAPSHOT snapshot;
+    snapshot.cpu = cpu.save();
+    snapshot.dma = dma.save();
+    snapshot.clockCount = clockCount;
+    snapshot.stallCycles = stallCycles;
+    for(unsigned i = 0; i < 4; i++){
+        for(unsigned long long bits = dirty[i]; bits; bits &= bits - 1){
+            unsigned page = i * 64 + __builtin_ctzll(bits);
+            snapshot.pages.push_back(page);
+            snapshot.data.insert(snapshot.data.end(), home(page), home(page) + 256);
+        }
+    }
+    return snapshot;
+}
+
+BYTE* Bus::span(WORD addr, unsigned long& len){
+    // One past the end of the storage which holds addr
+    unsigned long end = 0;
+    if(layout == Layout::Flat || addr >= 0x0800)
+        end = 0x10000;                              // dlRAM and ram are adjacent
+    else if(addr <= 0x01FF)
+        end = 0x0200;                               // zeropage and stack
+    else if(addr >= 0x0200 && addr <= 0x0230)
+        end = 0x0231;                               // vdRAM
+    else if(addr >= 0x0250 && addr <= 0x0253)
+        end = 0x0254;                               // timerRAM
     else if(addr >= 0x0400 && addr <= 0x0404)
-        odRAM[addr - 0x0400] = data;
-    
+        end = 0x0405;                               // odRAM
     else if(addr >= 0x0500 && addr <= 0x0502)
-        ddRAM[addr - 0x0500] = data;
+        end = 0x0503;                               // ddRAM
+    else if(addr >= 0x0600 && addr <= 0x0608)
+        end = 0x0609;                               // dmaRAM
+    len = end ? end - addr : 0;
+    if(!end)
+        return nullptr;
+    privatize(addr >> 8);
+
+    // Switched pages only continue into the next page if the bank does, the span also ends
+    // at a page which is still shared
+    BYTE* data = readMap[addr >> 8] + (addr & 0xFF);
+    for(unsigned long page = (addr >> 8) + 1; page * 256 < end; page++){
+        if((cow[page >> 6] & (1ULL << (page & 63))) || readMap[page] != readMap[page - 1] + 256 ||
+           !writeMap[page] != !writeMap[page - 1]){
+            len = (page << 8) - addr;
+            break;
+        }
+    }
+    return data;
+}
+
+void Bus::written(WORD addr, unsigned long len){
+    len = std::min<unsigned long>(len, 0x10000 - addr);
+    if(len == 0)
+        return;
+    markDirty(addr, len);
+    changes++;
+}
+
+void Bus::load(WORD offset, const BYTE* data, unsigned long len){
+    len = std::min<unsigned long>(len, 0x10000 - offset);
+    if(isMappedBlock(offset, len)){
+        memcpy(memory + offset, data, len);
+        markDirty(offset, len);
+        changes++;
+        return;
+    }
+    for(unsigned long i = 0; i < len; i++)
+        write(offset + i, data[i]);
 }
 
 void Bus::loadProgram(std::string program){
@@ -86,6 +502,47 @@ void Bus::loadProgram(std::string program){
     }
 }
 
+long Bus::loadBinary(std::string path, WORD offset){
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+        return -1;
+
+    // The image can't be larger than the address space
+    std::vector<BYTE> image(0x10000 - offset);
+    long size = fread(image.data(), 1, image.size(), file);
+    fclose(file);
+
+    load(offset, image.data(), size);
+    return size;
+}
+
+std::shared_ptr<const Bus::IMAGE> Bus::share(){
+    std::shared_ptr<IMAGE> shared = std::make_shared<IMAGE>();
+    shared->layout = layout;
+    shared->data.resize(MEMORY_SIZE);
+    for(unsigned page = 0; page < 256; page++){
+        const BYTE* data = home(page);
+        memcpy(shared->data.data() + page * 256, data, 256);
+        // Pages of zeros are left to the memory of the bus
+        if(std::any_of(data, data + 256, [](BYTE b){ return b != 0; }))
+            shared->used[page >> 6] |= 1ULL << (page & 63);
+    }
+    return shared;
+}
+
+void Bus::detach(){
+    for(unsigned page = 0; page < 256; page++)
+        privatize(page);
+    image.reset();
+}
+
+unsigned Bus::sharedPages(){
+    unsigned count = 0;
+    for(unsigned long long bits : cow)
+        count += __builtin_popcountll(bits);
+    return count;
+}
+
 bool Bus::shouldTerminate(){
     return terminationFlag;
 }
@@ -2,39 +2,224 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
+#include <memory>
 
 #include "datatypes.h"
 #include "emu6502.h"
 #include "outputDevice.h"
 #include "drawingDevice.h"
+#include "dmaDevice.h"
+#include "mailboxDevice.h"
+#include "mmuDevice.h"
+#include "videoDevice.h"
+#include "inputDevice.h"
+#include "timerDevice.h"
+#include "scheduler.h"
 
 class Bus{
 public:
-    Bus();
+    // Memory layout of the bus
+    enum class Layout{
+        Devices,    // Regions and device windows listed below, everything else is unmapped
+        Flat        // Plain 64kB of RAM, used by the test runners
+    };
+
+    Bus(Layout layout = Layout::Devices);
     ~Bus();
 
+    // Memory which several buses share, for running many machines on the same program.
+    // A bus created from an image maps its pages instead of copying them and copies a page
+    // only when it writes to it (copy on write), so it only owns the pages it changed.
+    struct IMAGE{
+        Layout layout;
+        std::vector<BYTE> data;             // 64kB
+        unsigned long long used[4] = {};    // Pages which aren't all zeros, only these are shared
+    };
+    Bus(std::shared_ptr<const IMAGE> image);
+    // Takes the memory of the bus as an image, the devices aren't part of it
+    std::shared_ptr<const IMAGE> share();
+    // Copies all the shared pages which weren't written yet
+    void detach();
+    unsigned sharedPages();
+
+    // Runs one cycle. With the cycle accurate timing (make TIMING=CYCLE_ACCURATE) it runs a
+    // whole instruction instead, and the devices are clocked after every access of it.
     void clock();
 
     // Devices
     emu6502 cpu;
     OutputDevice od;
     DrawingDevice dd;
+    DmaDevice dma;
+    MailboxDevice mb;
+    MmuDevice mmu;
+    VideoDevice vd;
+    InputDevice in;
+    TimerDevice timer;
+
+    // Runs the devices written as coroutines (TimerDevice), clocked after the other devices
+    Scheduler scheduler;
+
+    // IRQ line of core 0, raised by any of the devices
+    bool irqPending();
+
+    // Number of cycles since the bus was created
+    unsigned long long clockCount = 0;
+    // Halts the CPU for a number of cycles, the devices keep running
+    void stall(unsigned long cycles);
+    bool stalled();
+    // Clocks only the devices, for code which executes the CPU's instructions itself
+    // (the recompiled programs of Tools/recompile.cpp)
+    void tick(unsigned long cycles);
+
+    // Runs a number of cycles. While the CPU is idle, the cycles until the next
+    // device event are skipped instead of executed. The cycle accurate timing can finish the
+    // last instruction beyond them.
+    void run(unsigned long long cycles);
+    unsigned long long skippedCycles = 0;
+
+    // Runs until one of the traps set with cpu.setTraps() fires, a budget is used up or the
+    // termination flag is set. The budgets count from the call on.
+    struct STOPINFO{
+        emu6502::Stop reason;
+        WORD pc;                        // Of the trapping instruction, the next one for the others
+        BYTE opcode;
+        BYTE value;                     // Written to the exit address
+        unsigned long long cycles;      // Run by this call
+        unsigned long long instructions;
+        emu6502::STATE state;
+    };
+    STOPINFO runUntilStop();
+
+    // Number of writes which changed the memory, the CPU uses it to detect idle loops
+    unsigned long long changes = 0;
+    unsigned long long changeCount();
+
+    // Set by MultiCore while several cores access the bus from their own threads. The
+    // memory is always accessed through relaxed atomics, in shared mode the change counter is
+    // incremented atomically and block transfers go byte by byte.
+    bool shared = false;
 
 private:
-    BYTE ram[60 * 1024]; // 60kB of RAM from 0x1000 - 0xFFFF
-    BYTE stack[256];     // 0x0100 - 0x01FF
-    BYTE zeropage[256];  // 0x0000 - 0x00FF
-    BYTE odRAM[5];       // 0x0400 - 0x0404
-    BYTE ddRAM[3];       // 0x0500 - 0x0502
+    Layout layout;
+
+    // All regions live inside one backing store and are indexed by their bus address.
+    // It is mapped from the OS, which only backs the parts in use.
+    static const unsigned long MEMORY_SIZE = 64 * 1024;
+    BYTE* memory;
+    // ram      0x1000 - 0xFFFF  60kB of RAM
+    // stack    0x0100 - 0x01FF
+    // zeropage 0x0000 - 0x00FF
+    // odRAM    0x0400 - 0x0404
+    // ddRAM    0x0500 - 0x0502
+    // dmaRAM   0x0600 - 0x0608  registers of DmaDevice
+    // dlRAM    0x0800 - 0x0FFF  display list window of DrawingDevice
+    // vdRAM    0x0200 - 0x0230  registers and palette of VideoDevice
+    // timerRAM 0x0250 - 0x0253  registers of TimerDevice
+    // The registers of MailboxDevice (0x0700 - 0x0709) aren't part of it, they are atomics,
+    // neither are the ones of MmuDevice (0x0300 - 0x031F) and InputDevice (0x0240 - 0x0247)
+    bool isMapped(WORD addr);
+    bool isMailbox(WORD addr);
+    bool isMmu(WORD addr);
+    bool isInput(WORD addr);
+
+    // Page map, where each 256 byte page of the address space is stored. Normally a page points
+    // into memory, MmuDevice points the pages of a switched window into its banks. Writes to a
+    // page without a write pointer (ROM) are ignored.
+    BYTE* readMap[256];
+    BYTE* writeMap[256];
+    unsigned long long remapped[4] = {};
+
+    // Pages which still point into the image, they have no write pointer
+    std::shared_ptr<const IMAGE> image;
+    unsigned long long cow[4] = {};
+    // Page in memory or in the image, whichever holds the content
+    const BYTE* home(BYTE page);
+    void privatize(BYTE page);
+    void changed(WORD addr);
+    void markDirty(WORD addr, unsigned long len);
+
+    bool isMappedBlock(WORD addr, unsigned long len);
+
+    unsigned long stallCycles = 0;
+    void fastForward(unsigned long long cycles);
 
 public:
     BYTE read(WORD addr);
     void write(WORD addr, BYTE data);
 
+    // Points count pages from first to data, used by MmuDevice. nullptr maps memory back.
+    void mapPages(BYTE first, unsigned count, BYTE* data, bool writable);
+
+    // Block transfers for DmaDevice. Ranges which are mapped as a whole are copied with
+    // memmove/memset, everything else byte by byte through read() and write().
+    void copy(WORD dst, WORD src, WORD len);
+    void fill(WORD dst, BYTE data, WORD len);
+
+    // Checkpoints
+    // Every write which changes the memory marks its 256 byte page as dirty. checkpoint() takes a
+    // baseline and clears the marks, afterwards only the dirty pages have to be copied:
+    // restore() resets the machine to the baseline, snapshot() saves the difference to it.
+    // The state of the CPU, DMA and bus clock is part of it, the other devices, the banks of the
+    // MMU and the private pages of MultiCore cores aren't.
+    // restore() resets the mailbox and the input queue and starts the coroutine devices again on
+    // the restored registers, a running timer begins a new period.
+    struct SNAPSHOT{
+        emu6502::STATE cpu;
+        DmaDevice::STATE dma;
+        unsigned long long clockCount;
+        unsigned long stallCycles;
+        std::vector<BYTE> pages;    // Numbers of the saved pages
+        std::vector<BYTE> data;     // 256 bytes per saved page
+    };
+    void checkpoint();
+    // Do nothing without a checkpoint
+    void restore();
+    void restore(const SNAPSHOT& snapshot);
+    SNAPSHOT snapshot();
+    unsigned dirtyPages();
+
+    // Pages written since the last call, one bit per page like the checkpoint marks but kept
+    // apart from them. VideoDevice uses them to find the rows of its frame which changed.
+    void takeWrites(unsigned long long pages[4]);
+
+    // Direct access to the memory, for embedders (Source/libemu6502.h). Returns a pointer to addr
+    // and in len the number of bytes which follow it in the same storage, nullptr if addr isn't
+    // mapped. Writes through the pointer have to be reported with written(), otherwise
+    // checkpoints and the idle detection miss them. Windows switched to a ROM bank of the MMU
+    // must not be written through it. Only the page of addr is copied into the bus if it is shared,
+    // the span ends before the next shared page.
+    BYTE* span(WORD addr, unsigned long& len);
+    void written(WORD addr, unsigned long len);
+
+    // Copies a block of data onto the bus, like a series of write()s
+    void load(WORD offset, const BYTE* data, unsigned long len);
+
     void loadProgram(std::string program);
+    // Copies a raw binary image from a file onto the bus, starting at offset.
+    // Returns the number of bytes loaded or -1 if the file can't be read.
+    long loadBinary(std::string path, WORD offset = 0x0000);
+
+    // Optional record of every access, used by the conformance runner to
+    // compare the bus activity of an instruction
+    struct ACCESS{
+        WORD addr;
+        BYTE data;
+        bool write;
+    };
+    std::vector<ACCESS>* accessLog = nullptr;
 
     bool shouldTerminate();
     void setTermination();
 private:
     bool terminationFlag = false;
-};
\ No newline at end of file
+
+    // Checkpoints, one dirty bit per page
+    unsigned long long dirty[4] = {};
+    // Same for takeWrites()
+    unsigned long long touched[4] = {};
+    std::vector<BYTE> baseline;
+    SNAPSHOT baselineState;
+    void resetDevices();
+};
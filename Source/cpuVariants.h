@@ -0,0 +1,71 @@
+#pragma once
+
+#include "opcodes.h"
+
+// Variants of the CPU. emu6502Core is a template over one of these, each variant gets its own
+// lookup table built from its opcodes, and its differences are decided at compile time.
+// The build picks the variant of emu6502 with -DCPU_VARIANT=... (make CPU=...).
+//   opcodes       description of the instruction set, see opcodes.h
+//   undocumented  runs the undocumented opcodes of the NMOS chip
+//   cmos          65C02: new instructions, JMP (ind) without the page bug, valid flags in
+//                 decimal mode with an extra cycle, D cleared by interrupts
+//   strict        always stops with Stop::IllegalOpcode on an opcode the variant doesn't define
+
+// The documented opcodes of the NMOS 6502, the others do nothing
+struct NMOS6502{
+    static constexpr const OPCODE* opcodes = OPCODES;
+    static constexpr bool undocumented = false;
+    static constexpr bool cmos = false;
+    static constexpr bool strict = false;
+    static constexpr const char* name = "6502";
+};
+
+struct NMOS6502_UNDOCUMENTED{
+    static constexpr const OPCODE* opcodes = OPCODES_UNDOCUMENTED;
+    static constexpr bool undocumented = true;
+    static constexpr bool cmos = false;
+    static constexpr bool strict = false;
+    static constexpr const char* name = "6502 with undocumented opcodes";
+};
+
+struct CMOS65C02{
+    static constexpr const OPCODE* opcodes = OPCODES_65C02;
+    static constexpr bool undocumented = false;
+    static constexpr bool cmos = true;
+    static constexpr bool strict = false;
+    static constexpr const char* name = "65C02";
+};
+
+struct NMOS6502_STRICT{
+    static constexpr const OPCODE* opcodes = OPCODES;
+    static constexpr bool undocumented = false;
+    static constexpr bool cmos = false;
+    static constexpr bool strict = true;
+    static constexpr const char* name = "6502, strict";
+};
+
+#ifndef CPU_VARIANT
+#define CPU_VARIANT NMOS6502
+#endif
+
+// Timing of the CPU, the second policy of emu6502Core. The build picks it with
+// -DCPU_TIMING=... (make TIMING=...).
+//   accurate      every bus access of an instruction takes one cycle, with the dummy reads
+//                 and writes of the chip, and the devices are clocked between them. Only the
+//                 NMOS variants have it, the 65C02 does different dummy accesses.
+
+// The whole instruction runs in its first cycle, the others only count down. The fastest.
+struct ATOMIC{
+    static constexpr bool accurate = false;
+};
+
+struct CYCLE_ACCURATE{
+    static constexpr bool accurate = true;
+};
+
+#ifndef CPU_TIMING
+#define CPU_TIMING ATOMIC
+#endif
+
+// Instruction set of the build, used by the assemblers and the disassembler
+inline constexpr const OPCODE* CPU_OPCODES = CPU_VARIANT::opcodes;
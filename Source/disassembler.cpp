@@ -0,0 +1,123 @@
+#include "disassembler.h"
+
+size_t Disassembler::decode(const BYTE* memory, size_t size, WORD address, DECODED* out, size_t capacity){
+    size_t count = 0, offset = 0;
+    while(count < capacity && offset < size){
+        if(offset + MODE_LENGTH[CPU_OPCODES[memory[offset]].mode] > size)
+            break;
+        out[count] = decode(memory + offset, (WORD)(address + offset));
+        offset += out[count].length;
+        count++;
+    }
+    return count;
+}
+
+uint32_t Disassembler::store(const std::string& name){
+    names += name;
+    names += '\0';
+    return names.size() - name.size();
+}
+
+void Disassembler::addSymbol(WORD address, const std::string& name){
+    if(symbolAt.empty())
+        symbolAt.assign(0x10000, 0);
+    if(!symbolAt[address])
+        symbolAt[address] = store(name);
+}
+
+void Disassembler::addLine(WORD address, const std::string& where){
+    if(lineAt.empty())
+        lineAt.assign(0x10000, 0);
+    lineAt[address] = store(where);
+}
+
+namespace{
+    // Appends to a buffer of fixed size, drops what doesn't fit
+    struct WRITER{
+        char* p;
+        char* end;
+
+        void put(char c){
+            if(p < end)
+                *p++ = c;
+        }
+        void put(const char* text){
+            while(*text && p < end)
+                *p++ = *text++;
+        }
+        void hex(unsigned value, int digits){
+            static const char digit[] = "0123456789ABCDEF";
+            for(int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+                put(digit[(value >> shift) & 0xF]);
+        }
+        void padTo(char* column){
+            while(p < column && p < end)
+                *p++ = ' ';
+        }
+    };
+}
+
+size_t Disassembler::format(const DECODED& instruction, char* out, size_t size) const{
+    if(size == 0)
+        return 0;
+    WRITER w{ out, out + size - 1 };
+    const OPCODE& info = CPU_OPCODES[instruction.opcode];
+
+    if(!symbolAt.empty() && symbolAt[instruction.address]){
+        w.put(names.c_str() + symbolAt[instruction.address] - 1);
+        w.put(":\n");
+    }
+    char* start = w.p;
+    w.hex(instruction.address, 4);
+    w.put("  ");
+    w.hex(instruction.opcode, 2);
+    for(int i = 1; i < 3; i++){
+        w.put(' ');
+        if(i < instruction.length)
+            w.hex((instruction.operand >> (8 * (i - 1))) & 0xFF, 2);
+        else
+            w.put("  ");
+    }
+    w.put("  ");
+    w.put(info.legal ? ' ' : '*');
+    w.put(info.name);
+
+    // Addresses with a symbol are written as the symbol
+    const char* symbol = nullptr;
+    if(!symbolAt.empty() && info.mode != ModeIMM && info.mode != ModeIMP && info.mode != ModeACC && symbolAt[instruction.target])
+        symbol = names.c_str() + symbolAt[instruction.target] - 1;
+    auto address = [&](int digits){
+        if(symbol)
+            w.put(symbol);
+        else{
+            w.put('$');
+            w.hex(instruction.target, digits);
+        }
+    };
+    switch(info.mode){
+        case ModeIMP:                                                       break;
+        case ModeACC: w.put(" A");                                          break;
+        case ModeIMM: w.put(" #$"); w.hex(instruction.operand, 2);          break;
+        case ModeZP0: w.put(' '); address(2);                               break;
+        case ModeZPX: w.put(' '); address(2); w.put(",X");                  break;
+        case ModeZPY: w.put(' '); address(2); w.put(",Y");                  break;
+        case ModeREL: w.put(' '); address(4);                               break;
+        case ModeABS: w.put(' '); address(4);                               break;
+        case ModeABX: w.put(' '); address(4); w.put(",X");                  break;
+        case ModeABY: w.put(' '); address(4); w.put(",Y");                  break;
+        case ModeIND: w.put(" ("); address(4); w.put(')');                  break;
+        case ModeIZX: w.put(" ("); address(2); w.put(",X)");                break;
+        case ModeIZY: w.put(" ("); address(2); w.put("),Y");                break;
+        case ModeZPI: w.put(" ("); address(2); w.put(')');                  break;
+        case ModeIAX: w.put(" ("); address(4); w.put(",X)");                break;
+    }
+
+    if(!lineAt.empty() && lineAt[instruction.address]){
+        w.padTo(start + 44);
+        w.put("; ");
+        w.put(names.c_str() + lineAt[instruction.address] - 1);
+    }
+    w.put('\n');
+    *w.p = '\0';
+    return w.p - out;
+}
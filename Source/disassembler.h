@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "datatypes.h"
+#include "cpuVariants.h"
+
+// Turns machine code back into assembly, with the description of the build's CPU variant.
+// Decoding only fills DECODED entries with a table lookup per instruction, format() writes
+// the text of one of them into a buffer of the caller. Neither allocates, so trace buffers
+// of millions of instructions can be run through them without the disassembler becoming the
+// bottleneck. Symbols and source lines (from Linker::IMAGE or the map of Tools/asm) are kept
+// in tables over the whole address space and replace the addresses of operands.
+class Disassembler{
+public:
+    struct DECODED{
+        WORD address;
+        BYTE opcode;
+        BYTE length;
+        WORD operand;       // The byte or word after the opcode
+        WORD target;        // Destination of a branch, otherwise the operand
+    };
+
+    // One instruction from its bytes, only the ones it uses are read
+    static DECODED decode(const BYTE* bytes, WORD address){
+        const OPCODE& info = CPU_OPCODES[bytes[0]];
+        DECODED decoded{ address, bytes[0], MODE_LENGTH[info.mode], 0, 0 };
+        if(decoded.length > 1)
+            decoded.operand = bytes[1];
+        if(decoded.length > 2)
+            decoded.operand |= bytes[2] << 8;
+        decoded.target = info.mode == ModeREL ? (WORD)(address + 2 + (BYTE_S) decoded.operand) : decoded.operand;
+        return decoded;
+    }
+
+    // The instructions of memory[0..size), which starts at address, one after the other.
+    // Stops before an instruction which doesn't fit into the span or when out is full,
+    // returns the number of entries written.
+    static size_t decode(const BYTE* memory, size_t size, WORD address, DECODED* out, size_t capacity);
+
+    // The first symbol added for an address is kept
+    void addSymbol(WORD address, const std::string& name);
+    void addLine(WORD address, const std::string& where);
+
+    // A line like "2000  A9 40     LDA #<operand>                ; main.asm:3" and a newline.
+    // Symbols at the address of the instruction come first on a line of their own, the
+    // undocumented opcodes are marked with *. Returns the length, the text is cut off at
+    // size - 1 and always terminated.
+    size_t format(const DECODED& instruction, char* out, size_t size) const;
+
+private:
+    // Offset + 1 into names for every address, 0 if there is none
+    std::vector<uint32_t> symbolAt;
+    std::vector<uint32_t> lineAt;
+    std::string names;
+
+    uint32_t store(const std::string& name);
+};
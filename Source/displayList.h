@@ -0,0 +1,8 @@
+#pragma once
+
+// Vertex of a display list frame as it is handed to the rendering backends.
+// Coordinates are already normalized to -1.0 to 1.0, colors to 0.0 to 1.0.
+struct DISPLAY_VERTEX{
+    float x, y;
+    float r, g, b;
+};
@@ -0,0 +1,61 @@
+#include "dmaDevice.h"
+#include "bus.h"
+
+DmaDevice::DmaDevice(){
+    // Does nothing
+}
+
+DmaDevice::~DmaDevice(){
+    // Does nothing
+}
+
+BYTE DmaDevice::read(WORD addr){
+    return bus->read(addr);
+}
+
+void DmaDevice::write(WORD addr, BYTE data){
+    bus->write(addr, data);
+}
+
+void DmaDevice::clock(){
+    // Finishing the running transfer
+    if(remaining > 0){
+        remaining--;
+        if(remaining == 0)
+            finish();
+    }
+
+    BYTE control = read(0x0607);
+    if(control == 0x01 && remaining == 0)
+        start();
+    else if(control == 0x02){
+        write(0x0608, 0x00);
+        irq = false;
+    }
+    if(control != 0x00)
+        write(0x0607, 0x00);
+}
+
+void DmaDevice::start(){
+    WORD src = read(0x0600) | (read(0x0601) << 8);
+    WORD dst = read(0x0602) | (read(0x0603) << 8);
+    WORD len = read(0x0604) | (read(0x0605) << 8);
+    BYTE mode = read(0x0606);
+
+    if(mode & Fill)
+        bus->fill(dst, read(src), len);
+    else
+        bus->copy(dst, src, len);
+
+    // The CPU can't use the bus while the controller owns it
+    remaining = setupCycles + (unsigned long) len * cyclesPerByte;
+    write(0x0608, 0x80);
+    bus->stall(remaining);
+    if(remaining == 0)
+        finish();
+}
+
+void DmaDevice::finish(){
+    write(0x0608, 0x01);
+    irq = read(0x0606) & Irq;
+}
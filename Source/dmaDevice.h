@@ -0,0 +1,58 @@
+#pragma once
+
+#include "datatypes.h"
+
+class Bus;
+
+// Copies blocks of memory on behalf of the CPU.
+// Registers (0x0600 - 0x0608):
+//   0x0600 - 0x0601  source address (lo, hi)
+//   0x0602 - 0x0603  destination address (lo, hi)
+//   0x0604 - 0x0605  length in bytes (lo, hi)
+//   0x0606          mode, see MODES
+//   0x0607          control, 0x01 starts a transfer, 0x02 acknowledges the completion
+//   0x0608          status, bit 7 busy, bit 0 done
+// The transfer itself is done at once, the CPU is halted for the cycles it costs.
+class DmaDevice{
+public:
+    DmaDevice();
+    ~DmaDevice();
+
+    void ConnectBus(Bus* ptr) { bus = ptr; }
+    void clock();
+
+    enum MODES{
+        Fill = 0x01,    // Source address is not incremented, fills the destination with one byte
+        Irq  = 0x02     // Requests an interrupt when the transfer has finished
+    };
+
+    // Cost of a transfer in CPU cycles: setupCycles + length * cyclesPerByte
+    unsigned int setupCycles = 4;
+    unsigned int cyclesPerByte = 1;
+
+    // Interrupt line, stays set until the completion is acknowledged
+    bool irq = false;
+
+    // Cycles until the running transfer is done, 0 if there is none
+    unsigned long pendingCycles() { return remaining; }
+    // Lets cycles pass without clocking, used by Bus::run() to skip idle time
+    void skip(unsigned long cycles) { remaining -= cycles; }
+
+    // Progress of a transfer, used by Bus checkpoints
+    struct STATE{
+        unsigned long remaining;
+        bool irq;
+    };
+    STATE save() { return { remaining, irq }; }
+    void load(const STATE& state) { remaining = state.remaining; irq = state.irq; }
+
+private:
+    Bus* bus = nullptr;
+    unsigned long remaining = 0;
+
+    BYTE read(WORD addr);
+    void write(WORD addr, BYTE data);
+
+    void start();
+    void finish();
+};
@@ -20,13 +20,23 @@ DrawingDevice::~DrawingDevice(){
     // Does nothing
 }
 
+void DrawingDevice::ConnectBus(Bus* t){
+    bus = t;
+#ifndef HEADLESS
+    glDev.attachInput(&t->in);
+#endif
+}
+
 void DrawingDevice::clock(){
     // Process events first
     throwTermination();
     // Updates a vertex if 0x0502 is 0x01, uploads it into OpenGLDevice if it is 0x02
     updateVerticies();
     // Render
+#ifndef HEADLESS
+    presentBitmap();
     glDev.render();
+#endif
 
 }
 
@@ -46,14 +56,16 @@ void DrawingDevice::reset(){
 }
 
 void DrawingDevice::throwTermination(){
+#ifndef HEADLESS
     if(glDev.shouldTerminate)
         bus->setTermination();
+#endif
 }
 
 void DrawingDevice::updateVerticies(){
     BYTE currentValue = bus->read(0x0502);
     // Updates a vertex
-    if(currentValue == 0x0001){
+    if(currentValue == SetVertex){
         vertexData[counter] = bus->read(0x0500);
         counter++;
         vertexData[counter] = bus->read(0x0501);
@@ -61,7 +73,7 @@ void DrawingDevice::updateVerticies(){
         counter %= 8;
     }
     // Uploads the current buffer into OpenGLDevice
-    else if(currentValue == 0x0002){
+    else if(currentValue == CommitQuad){
         // Normalizing the coords to a range from -1.0 to 1.0 and converting them into floats
         float tempData[8] = {
             vertexData[0] / 128.0f, vertexData[1] / 128.0f,
@@ -69,8 +81,132 @@ void DrawingDevice::updateVerticies(){
             vertexData[4] / 128.0f, vertexData[5] / 128.0f,
             vertexData[6] / 128.0f, vertexData[7] / 128.0f
         };
+#ifndef HEADLESS
         glDev.update(tempData);
+#endif
+        for(int i = 0; i < 8; i++)
+            quad[i] = tempData[i];
+        rasterize();
         counter = 0;
     }
+    // Display list mode
+    else if(currentValue == AppendList){
+        appendList();
+    }
+    else if(currentValue == PresentFrame){
+        presentFrame();
+    }
+    else if(currentValue == ClearFrame){
+        clearFrame();
+    }
+    if(currentValue != 0)
+        commands++;
     bus->write(0x0502, 0x0000);
-}
\ No newline at end of file
+}
+
+unsigned long long DrawingDevice::frames(){
+#ifndef HEADLESS
+    return glDev.frames;
+#else
+    return 0;
+#endif
+}
+
+// Walks through the display list window and appends its primitives to the frame.
+// The list ends with End, an unknown opcode or at the end of the window.
+void DrawingDevice::appendList(){
+    WORD addr = LIST_START;
+    while(addr <= LIST_END){
+        BYTE op = read(addr++);
+        int operands = 0;
+        switch(op){
+            case Color:    operands = 3; break;
+            case Line:     operands = 4; break;
+            case Triangle: operands = 6; break;
+            case Quad:     operands = 8; break;
+        }
+        if(operands == 0 || addr + operands - 1 > LIST_END)
+            return;
+
+        BYTE data[8];
+        for(int i = 0; i < operands; i++)
+            data[i] = read(addr++);
+
+        if(op == Color){
+            color[0] = data[0] / 255.0f;
+            color[1] = data[1] / 255.0f;
+            color[2] = data[2] / 255.0f;
+            continue;
+        }
+
+        // Drops everything that doesn't fit into the frame anymore
+        if(lines.size() + triangles.size() + 8 > MAX_FRAME_VERTICES)
+            return;
+
+        // Same coordinate system as the single quad
+        DISPLAY_VERTEX v[4];
+        for(int i = 0; i < operands / 2; i++)
+            v[i] = { (BYTE_S) data[2 * i] / 128.0f, (BYTE_S) data[2 * i + 1] / 128.0f, color[0], color[1], color[2] };
+
+        if(op == Line){
+            lines.push_back(v[0]);
+            lines.push_back(v[1]);
+        }
+        else if(op == Triangle){
+            triangles.push_back(v[0]);
+            triangles.push_back(v[1]);
+            triangles.push_back(v[2]);
+        }
+        else{
+            // The outline of a quad consists of four lines
+            for(int i = 0; i < 4; i++){
+                lines.push_back(v[i]);
+                lines.push_back(v[(i + 1) % 4]);
+            }
+        }
+    }
+}
+
+// Hands the frame to the backends at once, the vectors are swapped and keep
+// their capacity so the next frame doesn't allocate again
+void DrawingDevice::presentFrame(){
+    presentedLines.swap(lines);
+    presentedTriangles.swap(triangles);
+#ifndef HEADLESS
+    glDev.present(presentedLines.data(), presentedLines.size(), presentedTriangles.data(), presentedTriangles.size());
+#endif
+    rasterize();
+    clearFrame();
+}
+
+void DrawingDevice::rasterize(){
+    if(raster)
+        raster->render(quad, presentedLines.data(), presentedLines.size(), presentedTriangles.data(), presentedTriangles.size());
+}
+
+void DrawingDevice::clearFrame(){
+    lines.clear();
+    triangles.clear();
+}
+
+// Uploads the rows of VideoDevice which changed since the last frame, a run of adjacent
+// rows at a time
+void DrawingDevice::presentBitmap(){
+#ifndef HEADLESS
+    VideoDevice& video = bus->vd;
+    if(video.refresh()){
+        for(unsigned row = 0; row < VideoDevice::HEIGHT;){
+            if(!video.dirty(row)){
+                row++;
+                continue;
+            }
+            unsigned first = row;
+            while(row < VideoDevice::HEIGHT && video.dirty(row))
+                row++;
+            glDev.updateBitmap(video.pixels(), VideoDevice::WIDTH, VideoDevice::HEIGHT, first, row - first);
+        }
+        video.clean();
+    }
+    glDev.showBitmap(video.enabled());
+#endif
+}
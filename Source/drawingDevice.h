@@ -1,7 +1,17 @@
 #pragma once
 
+#include <stddef.h>
+#include <vector>
+
 #include "datatypes.h"
+#include "displayList.h"
+#include "softRasterizer.h"
+
+// Building with -DHEADLESS leaves out the OpenGL window, so the bus can be
+// used on machines without a display (test runners, batch jobs)
+#ifndef HEADLESS
 #include "openGLDevice.h"
+#endif
 
 class Bus;
 
@@ -12,18 +22,71 @@ public:
 
     void clock();
 
+    // Commands written into 0x0502
+    enum COMMANDS{
+        SetVertex    = 0x01,  // Stores the coordinates from 0x0500 - 0x0501 as next vertex
+        CommitQuad   = 0x02,  // Uploads the four stored vertices as quadrilateral
+        AppendList   = 0x03,  // Appends the display list in 0x0800 - 0x0FFF to the frame
+        PresentFrame = 0x04,  // Uploads the collected frame and starts a new one
+        ClearFrame   = 0x05   // Drops the collected frame
+    };
+
+    // Opcodes of the display list, each followed by its operands
+    enum DISPLAY_OPS{
+        End      = 0x00,  // Ends the list
+        Color    = 0x01,  // r g b, used for all following primitives
+        Line     = 0x02,  // x0 y0 x1 y1
+        Triangle = 0x03,  // x0 y0 x1 y1 x2 y2, filled
+        Quad     = 0x04   // x0 y0 .. x3 y3, outline like CommitQuad
+    };
+
+    static const WORD LIST_START = 0x0800;
+    static const WORD LIST_END   = 0x0FFF;
+    static const size_t MAX_FRAME_VERTICES = 1 << 20;
+
+    // Number of commands handled, for Metrics
+    unsigned long long commands = 0;
+    // Frames presented by the OpenGL window, 0 without it
+    unsigned long long frames();
+
 private:
     Bus* bus;
+#ifndef HEADLESS
     OpenGLDevice glDev;
+#endif
     BYTE_S vertexData[8]; // Used for storing up to 8 signed coordinates from -128 to 127
     char counter = 0;   // Holds the position of vertexData
 
+    // Frame collected from the display lists, lines are stored as pairs and
+    // triangles as triples of vertices, so every type needs only one draw call
+    std::vector<DISPLAY_VERTEX> lines;
+    std::vector<DISPLAY_VERTEX> triangles;
+    float color[3] = { 1.0f, 0.5f, 0.2f };
+
+    // What is currently shown, needed to redraw the whole frame in the software rasterizer
+    float quad[8] = {
+        -0.5f, -0.5f,
+        -0.5f,  0.5f,
+         0.5f,  0.5f,
+         0.5f, -0.5f
+    };
+    std::vector<DISPLAY_VERTEX> presentedLines;
+    std::vector<DISPLAY_VERTEX> presentedTriangles;
+    SoftRasterizer* raster = nullptr;
+    void rasterize();
+
     BYTE read(WORD addr);
     void write(WORD addr, BYTE data);
 
     void reset();
     void updateVerticies();
+    void appendList();
+    void presentFrame();
+    void clearFrame();
+    void presentBitmap();
 public:    
-    void ConnectBus(Bus *t) { bus = t; }
+    void ConnectBus(Bus *t);
+    // Additionally renders every committed quad and presented frame on the CPU
+    void attachRasterizer(SoftRasterizer* r) { raster = r; }
     void throwTermination(); 
 };
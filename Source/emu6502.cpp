@@ -1,31 +1,205 @@
 #include "emu6502.h"
 #include "bus.h"
+#include "metrics.h"
+#include "opcodes.h"
+
+#include <string_view>
+
+// The operation of an opcode is found by its name in the table of the variant, ModeACC runs
+// as IMP. JSR of the cycle accurate timing reads its high byte itself.
+template<class VARIANT, class TIMING>
+constexpr std::array<typename emu6502Core<VARIANT, TIMING>::INSTRUCTION, 256> emu6502Core<VARIANT, TIMING>::buildLookup(){
+	struct OPERATION{
+		std::string_view name;
+		BYTE (emu6502Core::*operate)(void);
+	};
+	const OPERATION operations[] = {
+		{ "ADC", &emu6502Core::ADC },{ "AND", &emu6502Core::AND },{ "ASL", &emu6502Core::ASL },{ "BCC", &emu6502Core::BCC },
+		{ "BCS", &emu6502Core::BCS },{ "BEQ", &emu6502Core::BEQ },{ "BIT", &emu6502Core::BIT },{ "BMI", &emu6502Core::BMI },
+		{ "BNE", &emu6502Core::BNE },{ "BPL", &emu6502Core::BPL },{ "BRK", &emu6502Core::BRK },{ "BVC", &emu6502Core::BVC },
+		{ "BVS", &emu6502Core::BVS },{ "CLC", &emu6502Core::CLC },{ "CLD", &emu6502Core::CLD },{ "CLI", &emu6502Core::CLI },
+		{ "CLV", &emu6502Core::CLV },{ "CMP", &emu6502Core::CMP },{ "CPX", &emu6502Core::CPX },{ "CPY", &emu6502Core::CPY },
+		{ "DEC", &emu6502Core::DEC },{ "DEX", &emu6502Core::DEX },{ "DEY", &emu6502Core::DEY },{ "EOR", &emu6502Core::EOR },
+		{ "INC", &emu6502Core::INC },{ "INX", &emu6502Core::INX },{ "INY", &emu6502Core::INY },{ "JMP", &emu6502Core::JMP },
+		{ "JSR", &emu6502Core::JSR },{ "LDA", &emu6502Core::LDA },{ "LDX", &emu6502Core::LDX },{ "LDY", &emu6502Core::LDY },
+		{ "LSR", &emu6502Core::LSR },{ "NOP", &emu6502Core::NOP },{ "ORA", &emu6502Core::ORA },{ "PHA", &emu6502Core::PHA },
+		{ "PHP", &emu6502Core::PHP },{ "PLA", &emu6502Core::PLA },{ "PLP", &emu6502Core::PLP },{ "ROL", &emu6502Core::ROL },
+		{ "ROR", &emu6502Core::ROR },{ "RTI", &emu6502Core::RTI },{ "RTS", &emu6502Core::RTS },{ "SBC", &emu6502Core::SBC },
+		{ "SEC", &emu6502Core::SEC },{ "SED", &emu6502Core::SED },{ "SEI", &emu6502Core::SEI },{ "STA", &emu6502Core::STA },
+		{ "STX", &emu6502Core::STX },{ "STY", &emu6502Core::STY },{ "TAX", &emu6502Core::TAX },{ "TAY", &emu6502Core::TAY },
+		{ "TSX", &emu6502Core::TSX },{ "TXA", &emu6502Core::TXA },{ "TXS", &emu6502Core::TXS },{ "TYA", &emu6502Core::TYA },
+
+		{ "SLO", &emu6502Core::SLO },{ "RLA", &emu6502Core::RLA },{ "SRE", &emu6502Core::SRE },{ "RRA", &emu6502Core::RRA },
+		{ "SAX", &emu6502Core::SAX },{ "LAX", &emu6502Core::LAX },{ "DCP", &emu6502Core::DCP },{ "ISC", &emu6502Core::ISC },
+		{ "ANC", &emu6502Core::ANC },{ "ALR", &emu6502Core::ALR },{ "ARR", &emu6502Core::ARR },{ "SBX", &emu6502Core::SBX },
+		{ "XAA", &emu6502Core::XAA },{ "LXA", &emu6502Core::LXA },{ "SHA", &emu6502Core::SHA },{ "TAS", &emu6502Core::TAS },
+		{ "SHY", &emu6502Core::SHY },{ "SHX", &emu6502Core::SHX },{ "LAS", &emu6502Core::LAS },{ "JAM", &emu6502Core::JAM },
+
+		{ "BRA", &emu6502Core::BRA },{ "PHX", &emu6502Core::PHX },{ "PHY", &emu6502Core::PHY },{ "PLX", &emu6502Core::PLX },
+		{ "PLY", &emu6502Core::PLY },{ "STZ", &emu6502Core::STZ },{ "TRB", &emu6502Core::TRB },{ "TSB", &emu6502Core::TSB }
+	};
+	BYTE (emu6502Core::*const modes[MODE_COUNT])(void) = {
+		&emu6502Core::IMP, &emu6502Core::IMP, &emu6502Core::IMM, &emu6502Core::ZP0, &emu6502Core::ZPX, &emu6502Core::ZPY, &emu6502Core::REL,
+		&emu6502Core::ABS, &emu6502Core::ABX, &emu6502Core::ABY, &emu6502Core::IND, &emu6502Core::IZX, &emu6502Core::IZY,
+		&emu6502Core::ZPI, &emu6502Core::IAX
+	};
+
+	const std::string_view stores[] = {
+		"STA", "STX", "STY", "STZ", "SAX", "SHA", "SHX", "SHY", "TAS",
+		"ASL", "LSR", "ROL", "ROR", "INC", "DEC", "SLO", "RLA", "SRE", "RRA", "DCP", "ISC", "TRB", "TSB"
+	};
+
+	const OPCODE* opcodes = VARIANT::opcodes;
+	std::array<INSTRUCTION, 256> table{};
+	for(int op = 0; op < 256; op++){
+		table[op] = { &emu6502Core::XXX, modes[opcodes[op].mode], opcodes[op].cycles };
+		for(const OPERATION& operation : operations){
+			if(operation.name == opcodes[op].name)
+				table[op].operate = operation.operate;
+		}
+		for(std::string_view name : stores)
+			table[op].stores |= name == opcodes[op].name;
+		if(TIMING::accurate && opcodes[op].name == std::string_view("JSR"))
+			table[op].addrmode = &emu6502Core::IMM;
+	}
+	return table;
+}
+
+template<class VARIANT, class TIMING>
+constinit const std::array<typename emu6502Core<VARIANT, TIMING>::INSTRUCTION, 256> emu6502Core<VARIANT, TIMING>::lookup = emu6502Core<VARIANT, TIMING>::buildLookup();
 
 // Constructor
-emu6502::emu6502(){
-	// Does nothing
+template<class VARIANT, class TIMING>
+emu6502Core<VARIANT, TIMING>::emu6502Core(){
+	// The strict variant traps from the start
+	setTraps(traps);
 }
 
-emu6502::~emu6502(){
+template<class VARIANT, class TIMING>
+emu6502Core<VARIANT, TIMING>::~emu6502Core(){
 	// The destructor does nothing.
 }
 
 // Interacting with the bus
-BYTE emu6502::read(WORD addr){
+BYTE emu6502Base::read(WORD addr){
+	if(counters)
+		counters->reads[regionOf(addr)]++;
+	if(local && addr < 0x0200)
+		return local[addr];
 	return bus->read(addr);
 };
 
-void emu6502::write(WORD addr, BYTE data){
+void emu6502Base::write(WORD addr, BYTE data){
+	if(trapping && traps.exitWrite && addr == traps.exitAddress){
+		stop = Stop::ExitWrite;
+		exitValue = data;
+	}
+	if(counters)
+		counters->writes[regionOf(addr)]++;
+	if(local && addr < 0x0200){
+		if(local[addr] != data)
+			localChanges++;
+		local[addr] = data;
+		return;
+	}
 	bus->write(addr, data);
 }
 
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::read(WORD addr){
+	BYTE data = emu6502Base::read(addr);
+	if constexpr(TIMING::accurate)
+		busCycle();
+	return data;
+}
+
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::write(WORD addr, BYTE data){
+	emu6502Base::write(addr, data);
+	if constexpr(TIMING::accurate)
+		busCycle();
+}
+
+// The cycle of the access has passed, the devices run through it after the CPU like in
+// Bus::clock()
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::busCycle(){
+	cycles++;
+	if(ticking)
+		bus->tick(1);
+}
+
 // Reporting if an operation has finished
-bool emu6502::completed(){
+bool emu6502Base::completed(){
 	return cycles == 0;
 }
 
+emu6502Base::STATE emu6502Base::save(){
+	return { PC, SP, X, Y, A, getStatus(), cycles };
+}
+
+// The idle detection starts over, the loop state belongs to the old timeline
+void emu6502Base::load(const STATE& state){
+	PC = state.PC;
+	SP = state.SP;
+	X  = state.X;
+	Y  = state.Y;
+	A  = state.A;
+	setStatus(state.status);
+	cycles = state.cycles;
+	loop = LOOPSTATE();
+	idle = false;
+	stop = Stop::None;
+	exitValue = 0;
+}
+
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::setTraps(const TRAPS& t){
+	traps = t;
+	trapping = VARIANT::strict || t.illegalOpcode || t.brk || t.selfLoop || t.stackWrap || t.exitWrite;
+
+	// The opcode traps are checked before the instruction runs, the PC stays on it
+	for(int op = 0; op < 256; op++){
+		bool illegal = !VARIANT::opcodes[op].legal;
+		opcodeTraps[op] = Stop::None;
+		if(t.brk && op == 0x00)
+			opcodeTraps[op] = Stop::Break;
+		else if((VARIANT::strict || t.illegalOpcode) && illegal)
+			opcodeTraps[op] = Stop::IllegalOpcode;
+	}
+}
+
+const char* emu6502Base::describe(Stop stop){
+	switch(stop){
+		case Stop::None:              return "none";
+		case Stop::IllegalOpcode:     return "illegal opcode";
+		case Stop::Break:             return "BRK";
+		case Stop::SelfLoop:          return "jump onto itself";
+		case Stop::ExitWrite:         return "write to the exit address";
+		case Stop::StackWrap:         return "stack wrapped around";
+		case Stop::CycleBudget:       return "cycle budget used up";
+		case Stop::InstructionBudget: return "instruction budget used up";
+		case Stop::Terminated:        return "terminated";
+	}
+	return "";
+}
+
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::trapAfter(WORD start, BYTE startSP){
+	// A write to the exit address came first
+	if(stop != Stop::None)
+		return;
+	if(traps.selfLoop && PC == start)
+		stop = Stop::SelfLoop;
+	// Pushes and pulls move the stack pointer by 3 at most, TXS (and TAS, LAS) set it freely
+	int moved = (int) SP - (int) startSP;
+	bool sets = opcode == 0x9A || (VARIANT::undocumented && (opcode == 0x9B || opcode == 0xBB));
+	if(traps.stackWrap && !sets && (moved > 3 || moved < -3))
+		stop = Stop::StackWrap;
+}
+
 // Setting flags
-void emu6502::setFlag(FLAGS flag, bool val){
+void emu6502Base::setFlag(FLAGS flag, bool val){
 	switch(flag){
 		case C : Cf = val; break;
 		case Z : Zf = val; break;
@@ -38,7 +212,7 @@ void emu6502::setFlag(FLAGS flag, bool val){
 	}
 }
 
-BYTE emu6502::getFlag(FLAGS flag){
+BYTE emu6502Base::getFlag(FLAGS flag){
 	switch(flag){
 		case C : return Cf; break;
 		case Z : return Zf; break;
@@ -49,9 +223,26 @@ BYTE emu6502::getFlag(FLAGS flag){
 		case N : return Nf; break;
 		case U : return Uf; break;
 	}
+	return 0;
+}
+
+// Packing the flags into the layout of the status register
+BYTE emu6502Base::getStatus(){
+	return (Nf << N) | (Vf << V) | (Uf << U) | (Bf << B) | (Df << D) | (If << I) | (Zf << Z) | (Cf << C);
+}
+
+void emu6502Base::setStatus(BYTE status){
+	Cf = (status >> C) & 0x01;
+	Zf = (status >> Z) & 0x01;
+	If = (status >> I) & 0x01;
+	Df = (status >> D) & 0x01;
+	Bf = (status >> B) & 0x01;
+	Uf = (status >> U) & 0x01;
+	Vf = (status >> V) & 0x01;
+	Nf = (status >> N) & 0x01;
 }
 
-void emu6502::reset(){
+void emu6502Base::reset(){
 	// Setting PC to start location
 	PC = 0xFFFC;
 	// Setting SP to start location
@@ -77,50 +268,166 @@ void emu6502::reset(){
 	addr_rel    = 0x0000;
 
 	cycles = 8;
+	stop = Stop::None;
+}
+
+bool emu6502Base::isIdle(){
+	return idle && loop.changes == bus->changeCount() + localChanges;
+}
+
+// If the state at this backward jump equals the one at the last, the loop in between is
+// deterministic and didn't change anything. It will repeat until a device or an interrupt
+// changes something.
+void emu6502Base::detectIdle(){
+	LOOPSTATE now;
+	now.PC = PC;
+	now.A  = A;
+	now.X  = X;
+	now.Y  = Y;
+	now.SP = SP;
+	now.status  = getStatus();
+	now.changes = bus->changeCount() + localChanges;
+
+	idle = now.PC == loop.PC && now.A == loop.A && now.X == loop.X && now.Y == loop.Y
+		&& now.SP == loop.SP && now.status == loop.status && now.changes == loop.changes;
+	loop = now;
+}
+
+// Branches record both outcomes, the not taken one continues at from + 2
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::traceEdge(WORD from){
+	bool transfer = lookup[opcode].addrmode == &emu6502Core::REL
+		|| opcode == 0x4C || opcode == 0x6C     // JMP
+		|| (VARIANT::cmos && opcode == 0x7C)
+		|| opcode == 0x20 || opcode == 0x60     // JSR, RTS
+		|| opcode == 0x40 || opcode == 0x00;    // RTI, BRK
+	if(transfer){
+		BYTE& hits = coverage[(((from * 0x9E3779B1u) >> 16) ^ PC) & coverageMask];
+		if(hits < 0xFF)
+			hits++;
+	}
+}
+
+// Interrupt request, ignored while the interrupt disable flag is set
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::irq(){
+	if(getFlag(I) == 0){
+		// Two reads of the opcode which is put off
+		if constexpr(TIMING::accurate){
+			read(PC);
+			read(PC);
+		}
+		write(0x0100 + SP, (PC >> 8) & 0x00FF);
+		SP--;
+		write(0x0100 + SP, PC & 0x00FF);
+		SP--;
+
+		// Unlike BRK the pushed status has B cleared
+		write(0x0100 + SP, (getStatus() & ~(1 << B)) | (1 << U));
+		SP--;
+		setFlag(I, 1);
+		// The 65C02 starts every handler in binary mode
+		if constexpr(VARIANT::cmos)
+			setFlag(D, 0);
+		PC = read(0xFFFE);
+		PC |= (WORD) read(0xFFFF) << 8;
+
+		if constexpr(!TIMING::accurate)
+			cycles = 7;
+	}
 }
 
 // The clock function works atomicly. So, instead of executing a tiny bit of code per cycle,
 // it will execute the whole operation at one go. To still have predictable length of operations
 // the cycles are decremented accordingly 
-void emu6502::clock(){
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::clock(){
 	if(cycles == 0){
+		WORD start = PC;
+		BYTE startSP = SP;
+
 		// If cycles equals 0, the last execution has finished and a new opcode is read
-		opcode = read(PC);
+		opcode = emu6502Base::read(PC);
+		// A halted CPU doesn't count cycles
+		if(trapping){
+			if(stop == Stop::None)
+				stop = opcodeTraps[opcode];
+			if(stop != Stop::None)
+				return;
+		}
+		if constexpr(TIMING::accurate)
+			busCycle();
 		PC++;
+		if(counters)
+			counters->opcodes[opcode]++;
 
 		// Setting the corresponding cycles
-		cycles = lookup[opcode].cycles;
+		if constexpr(!TIMING::accurate)
+			cycles = lookup[opcode].cycles;
 
 		// If the address mode und operation require an extra cycle, they return 1, else 0
 		// Here the operation will be executed
 		BYTE additional_cycle1 = (this->*lookup[opcode].addrmode)();
 		BYTE additional_cycle2 = (this->*lookup[opcode].operate)();
 
-		cycles += (additional_cycle1 & additional_cycle2);
+		if constexpr(!TIMING::accurate)
+			cycles += (additional_cycle1 & additional_cycle2);
+
+		// Every loop ends with a jump backwards (or onto itself)
+		if(PC <= start)
+			detectIdle();
+		if(coverage)
+			traceEdge(start);
+		instructions++;
+		if(trapping)
+			trapAfter(start, startSP);
 	}
 
 	// Decrement the current number of cycles
 	cycles--;
 }
 
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::step(bool interrupt){
+	// Cycles left by reset() or a checkpoint
+	if(cycles > 0){
+		bus->tick(cycles);
+		cycles = 0;
+		return;
+	}
+	ticking = true;
+	if(interrupt)
+		irq();
+	if(cycles == 0)
+		clock();
+	ticking = false;
+	cycles = 0;
+}
+
 
 // Address modes
 // The porpose of these address mode is, to set the absolute address to the right address.
 // In the opcode functions, the data from this address will be fetched.
 // Mode: Implied
-BYTE emu6502::IMP(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::IMP(){
+	// The byte after the opcode is read and ignored
+	if constexpr(TIMING::accurate)
+		read(PC);
 	fetched = A;
 	return 0;
 } 
 
 // Mode: Immediate
-BYTE emu6502::IMM(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::IMM(){
 	addr_abs = PC++;
 	return 0;
 }
 
 // Mode: Zero Page
-BYTE emu6502::ZP0(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ZP0(){
 	addr_abs = read(PC);
 	PC++;
 	addr_abs &= 0x00FF;
@@ -128,23 +435,34 @@ BYTE emu6502::ZP0(){
 } 
 
 // Mode: Zero Page X
-BYTE emu6502::ZPX(){
-	addr_abs = read(PC) + X;
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ZPX(){
+	addr_abs = read(PC);
 	PC++;
+	// The base is read while the index is added
+	if constexpr(TIMING::accurate)
+		read(addr_abs);
+	addr_abs += X;
 	addr_abs &= 0x00FF;
 	return 0;
 }
 
 // Mode: Zero Page Y
-BYTE emu6502::ZPY(){
-	addr_abs = read(PC) + Y;
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ZPY(){
+	addr_abs = read(PC);
 	PC++;
+	// The base is read while the index is added
+	if constexpr(TIMING::accurate)
+		read(addr_abs);
+	addr_abs += Y;
 	addr_abs &= 0x00FF;
 	return 0;
 }
 
 // Mode: Relative
-BYTE emu6502::REL(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::REL(){
 	addr_rel = read(PC);
 	PC++;
 	if(addr_rel & 0x80)
@@ -153,7 +471,8 @@ BYTE emu6502::REL(){
 }
 
 // Mode: Ansolute
-BYTE emu6502::ABS(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ABS(){
 	// Little Endian
 	WORD lo = read(PC);
 	PC++;
@@ -164,7 +483,8 @@ BYTE emu6502::ABS(){
 } 
 
 // Mode: Absolute X
-BYTE emu6502::ABX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ABX(){
 	WORD lo = read(PC);
 	PC++;
 	WORD hi = read(PC);
@@ -172,6 +492,12 @@ BYTE emu6502::ABX(){
 	addr_abs = (hi << 8) | lo;
 	addr_abs += X;
 
+	// The address is read before its high byte is fixed
+	if constexpr(TIMING::accurate){
+		if((addr_abs & 0xFF00) != (hi << 8) || lookup[opcode].stores)
+			read((hi << 8) | (addr_abs & 0x00FF));
+	}
+
 	if((addr_abs & 0xFF00) != (hi << 8)) // If the first byte has changed, the page is turned
 		return 1;
 	else
@@ -179,7 +505,8 @@ BYTE emu6502::ABX(){
 }
 
 // Mode: Absolute Y
-BYTE emu6502::ABY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ABY(){
 	WORD lo = read(PC);
 	PC++;
 	WORD hi = read(PC);
@@ -187,6 +514,12 @@ BYTE emu6502::ABY(){
 	addr_abs = (hi << 8) | lo;
 	addr_abs += Y;
 
+	// The address is read before its high byte is fixed
+	if constexpr(TIMING::accurate){
+		if((addr_abs & 0xFF00) != (hi << 8) || lookup[opcode].stores)
+			read((hi << 8) | (addr_abs & 0x00FF));
+	}
+
 	if((addr_abs & 0xFF00) != (hi << 8)) // If the first byte has changed, the page is turned
 		return 1;
 	else
@@ -194,27 +527,33 @@ BYTE emu6502::ABY(){
 } 
 
 // Mode: Indirect
-BYTE emu6502::IND(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::IND(){
 	WORD lo = read(PC);
 	PC++;
 	WORD hi = read(PC);
 	PC++;
 	WORD ptr = (hi << 8) | lo;
 
-	if(lo == 0x00FF){ // Simulate bug in the hardware
-		addr_abs = (read(ptr & 0xFF00) << 8) | read(ptr);
+	// The 65C02 fixed the bug, and pays a cycle for it in the table
+	addr_abs = read(ptr);
+	if(!VARIANT::cmos && lo == 0x00FF){ // Simulate bug in the hardware
+		addr_abs |= read(ptr & 0xFF00) << 8;
 	}
 	else{
-		addr_abs = (read(ptr + 1) << 8) | read(ptr);
+		addr_abs |= read(ptr + 1) << 8;
 	}
 
 	return 0;
 }
 
 // Mode: Indirect X
-BYTE emu6502::IZX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::IZX(){
 	WORD temp = read(PC);
 	PC++;
+	if constexpr(TIMING::accurate)
+		read(temp & 0x00FF);
 
 	WORD lo = read((temp + X) & 0x00FF);
 	WORD hi = read((temp + X + 1) & 0x00FF);
@@ -224,7 +563,8 @@ BYTE emu6502::IZX(){
 } 
 
 // Mode: Indirect Y
-BYTE emu6502::IZY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::IZY(){
 	WORD temp = read(PC);
 	PC++;
 
@@ -233,6 +573,11 @@ BYTE emu6502::IZY(){
 
 	addr_abs = (hi << 8) | lo;
 	addr_abs += Y;
+
+	if constexpr(TIMING::accurate){
+		if((addr_abs & 0xFF00) != (hi << 8) || lookup[opcode].stores)
+			read((hi << 8) | (addr_abs & 0x00FF));
+	}
 	
 	if ((addr_abs & 0xFF00) != (hi << 8))
 		return 1;
@@ -240,8 +585,37 @@ BYTE emu6502::IZY(){
 		return 0;
 }
 
-BYTE emu6502::fetch(){
-	if(!(lookup[opcode].addrmode == &emu6502::IMP)){
+// Mode: Zero Page Indirect (65C02)
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ZPI(){
+	WORD temp = read(PC);
+	PC++;
+
+	WORD lo = read(temp & 0x00FF);
+	WORD hi = read((temp + 1) & 0x00FF);
+	addr_abs = (hi << 8) | lo;
+
+	return 0;
+}
+
+// Mode: Absolute Indexed Indirect (65C02), only used by JMP
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::IAX(){
+	WORD lo = read(PC);
+	PC++;
+	WORD hi = read(PC);
+	PC++;
+	WORD ptr = ((hi << 8) | lo) + X;
+
+	addr_abs = read(ptr);
+	addr_abs |= read(ptr + 1) << 8;
+
+	return 0;
+}
+
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::fetch(){
+	if(!(lookup[opcode].addrmode == &emu6502Core::IMP)){
 		fetched = read(addr_abs);
 	}
 	return fetched;
@@ -252,8 +626,40 @@ BYTE emu6502::fetch(){
 // for more info
 
 // Addition with Carry
-BYTE emu6502::ADC(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ADC(){
 	fetch();
+	add();
+
+	// Can require an additional cycle
+	return 1;
+}
+
+// Adds fetched to the accumulator, shared by ADC and RRA
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::add(){
+	if(getFlag(D)){
+		// Decimal mode, each nibble is corrected separately. Like on the NMOS chip
+		// Z comes from the binary sum, N and V from the sum before the high nibble correction.
+		WORD lo = (A & 0x0F) + (fetched & 0x0F) + getFlag(C);
+		if(lo >= 0x0A)
+			lo = ((lo + 0x06) & 0x0F) + 0x10;
+		tempVal = (A & 0xF0) + (fetched & 0xF0) + lo;
+		setFlag(Z, ((A + fetched + getFlag(C)) & 0x00FF) == 0);
+		setFlag(N, tempVal & 0x80);
+		setFlag(V, (~((WORD) A ^ (WORD) fetched) & ((WORD) A ^ (WORD) tempVal)) & 0x0080);
+		if(tempVal >= 0xA0)
+			tempVal += 0x60;
+		setFlag(C, tempVal > 0xFF);
+		A = tempVal & 0x00FF;
+		// The 65C02 takes a cycle more and sets N and Z from the decimal result
+		if constexpr(VARIANT::cmos){
+			setFlag(Z, A == 0x00);
+			setFlag(N, A & 0x80);
+			cycles++;
+		}
+		return;
+	}
 
 	tempVal = (WORD) A + (WORD) fetched + (WORD) getFlag(C); 
 	setFlag(C, tempVal > 0xFF);
@@ -261,30 +667,56 @@ BYTE emu6502::ADC(){
 	setFlag(V, (~((WORD) A ^ (WORD) fetched) & ((WORD) A ^ (WORD) tempVal)) & 0x0080);
 	setFlag(N, tempVal & 0x80);
 	A = tempVal & 0x00FF;
-
-	// Can require an additional cycle
-	return 1;
 }
 
 // Subtraction with Carry
-BYTE emu6502::SBC(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SBC(){
 	fetch();
+	subtract();
+
+	// Can require an additional cycle
+	return 1;
+}
 
+// Subtracts fetched from the accumulator, shared by SBC and ISC
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::subtract(){
 	WORD value = ((WORD) fetched) ^ 0x00FF;
 
 	tempVal = (WORD) A + value + (WORD) getFlag(C); 
+	BYTE result = tempVal & 0x00FF;
+
+	// Decimal mode only changes the result, the flags are the binary ones on the NMOS chip
+	if(getFlag(D)){
+		int lo = (A & 0x0F) - (fetched & 0x0F) + getFlag(C) - 1;
+		if(lo < 0)
+			lo = ((lo - 0x06) & 0x0F) - 0x10;
+		int sum = (A & 0xF0) - (fetched & 0xF0) + lo;
+		if(sum < 0)
+			sum -= 0x60;
+		result = sum & 0xFF;
+	}
+
 	setFlag(C, tempVal & 0xFF00);
 	setFlag(Z, (tempVal & 0x00FF) == 0);
 	setFlag(V, (tempVal ^ (WORD) A) & (tempVal ^ value) & 0x0080);
 	setFlag(N, tempVal & 0x80);
-	A = tempVal & 0x00FF;
+	A = result;
 
-	// Can require an additional cycle
-	return 1;
+	// Like ADC on the 65C02
+	if constexpr(VARIANT::cmos){
+		if(getFlag(D)){
+			setFlag(Z, A == 0x00);
+			setFlag(N, A & 0x80);
+			cycles++;
+		}
+	}
 }
 
 // Bitwise Logic AND
-BYTE emu6502::AND(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::AND(){
 	fetch();
 	A = A & fetched;
 	setFlag(Z, A == 0x00);
@@ -292,200 +724,194 @@ BYTE emu6502::AND(){
 	return 1;
 }
 
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::modify(BYTE data){
+	if constexpr(TIMING::accurate)
+		write(addr_abs, fetched);
+	write(addr_abs, data);
+}
+
 // Arithmetic Shift Left
-BYTE emu6502::ASL(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ASL(){
 	fetch();
-	tempVal = (WORD) fetched < 2;
+	tempVal = (WORD) fetched << 1;
 	setFlag(C, (tempVal & 0x0100));
 	setFlag(Z, (tempVal & 0x00FF) == 0x0000);
 	setFlag(N, tempVal & 0x0080);
-	if(lookup[opcode].addrmode == & emu6502::IMP)
+	if(lookup[opcode].addrmode == &emu6502Core::IMP)
 		A = tempVal & 0x00FF;
 	else
-		write(addr_abs, tempVal & 0x00FF);
-	return 0;
-}
-
-// Branch if Carry Clear
-BYTE emu6502::BCC(){
-	if(getFlag(C) == 0){
+		modify(tempVal & 0x00FF);
+	// The 65C02 saves the cycle of abs,X without a page crossing
+	return VARIANT::cmos;
+}
+
+// The target is taken, one cycle more and another one for a page crossing. The chip reads
+// the next opcode, and on a crossing the target before its high byte is fixed.
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::branch(){
+	addr_abs = PC + addr_rel;
+	if constexpr(TIMING::accurate){
+		read(PC);
+		if((addr_abs & 0xFF00) != (PC & 0xFF00))
+			read((PC & 0xFF00) | (addr_abs & 0x00FF));
+	}
+	else{
 		cycles++;
-		addr_abs = PC + addr_rel;
-
 		if((addr_abs & 0xFF00) != (PC & 0xFF00))
 			cycles++;
-		
-		PC = addr_abs;
 	}
+	PC = addr_abs;
+}
+
+// Branch if Carry Clear
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BCC(){
+	if(getFlag(C) == 0)
+		branch();
 	return 0;
 }
 
 // Branch if Carry Set
-BYTE emu6502::BCS(){
-	if(getFlag(C) == 1){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BCS(){
+	if(getFlag(C) == 1)
+		branch();
 	return 0;
 }
 
 // Branch if Equal
-BYTE emu6502::BEQ(){
-	if(getFlag(Z) == 1){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BEQ(){
+	if(getFlag(Z) == 1)
+		branch();
 	return 0;
 }
 
 // Bit Test
-BYTE emu6502::BIT(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BIT(){
 	fetch();
 
 	tempVal = A & fetched;
 	setFlag(Z, tempVal == 0x0000);
+	// BIT # of the 65C02 only sets Z
+	if(VARIANT::cmos && lookup[opcode].addrmode == &emu6502Core::IMM)
+		return 0;
 	setFlag(N, fetched & 0x80);
 	setFlag(V, fetched & 0x40);
 
-	return 0;
+	// BIT abs,X of the 65C02 can require an additional cycle
+	return VARIANT::cmos;
 }
 
 // Branch if Minus
-BYTE emu6502::BMI(){
-	if(getFlag(N) == 1){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BMI(){
+	if(getFlag(N) == 1)
+		branch();
 	return 0;
 }
 
 // Branch if Not Equal
-BYTE emu6502::BNE(){
-	if(getFlag(Z) == 0){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BNE(){
+	if(getFlag(Z) == 0)
+		branch();
 	return 0;
 }
 
 // Branch if Positive
-BYTE emu6502::BPL(){
-	if(getFlag(N) == 0){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BPL(){
+	if(getFlag(N) == 0)
+		branch();
 	return 0;
 }
 
 // Break
-BYTE emu6502::BRK(){
-	PC++;
-
-	setFlag(I, 1);
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BRK(){
+	// The padding byte has already been skipped by the address mode
+	if constexpr(TIMING::accurate)
+		fetch();
 	write(0x0100 + SP, (PC >> 8) & 0x00FF);
 	SP--;
 	write(0x0100 + SP, PC & 0x00FF);
 	SP--;
 
-	setFlag(B, 1);
-	write(0x0100 + SP, (((((((((((((Uf < 1) | Nf) < 1) | Vf) < 1) | Bf) < 1) | Df) < 1) | If) < 1) | Zf) < 1) | Cf);
+	// The pushed copy of the status has the B and U bit set
+	write(0x0100 + SP, getStatus() | (1 << B) | (1 << U));
 	SP--;
-	setFlag(B, 0);
-	PC = ((WORD) read(0xFFFF) << 8) | ((WORD) read(0xFFFE));
+	setFlag(I, 1);
+	if constexpr(VARIANT::cmos)
+		setFlag(D, 0);
+	PC = read(0xFFFE);
+	PC |= (WORD) read(0xFFFF) << 8;
 
 	return 0;
 }
 
 // Branch if Overflow Clear
-BYTE emu6502::BVC(){
-	if(getFlag(V) == 0){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BVC(){
+	if(getFlag(V) == 0)
+		branch();
 	return 0;
 }
 
 // Branch if Overflow Set
-BYTE emu6502::BVS(){
-	if(getFlag(V) == 1){
-		cycles++;
-		addr_abs = PC + addr_rel;
-
-		if((addr_abs & 0xFF00) != (PC & 0xFF00))
-			cycles++;
-		
-		PC = addr_abs;
-	}
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BVS(){
+	if(getFlag(V) == 1)
+		branch();
 
 	return 0;
 }
 
 // Clear Carry Flag
-BYTE emu6502::CLC(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CLC(){
 	setFlag(C, 0);
 	return 0;
 }
 
 // Clear Decimal Flag
-BYTE emu6502::CLD(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CLD(){
 	setFlag(D, 0);
 	return 0;
 }
 
 // Clear Interrupt Flag / Disable Interrupts
-BYTE emu6502::CLI(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CLI(){
 	setFlag(I, 0);
 	return 0;
 }
 
 // Clear Overflow Flag
-BYTE emu6502::CLV(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CLV(){
 	setFlag(V, 0);
 	return 0;
 }
 
 // Compare Accumulator Flag
-BYTE emu6502::CMP(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CMP(){
 	fetch();
 	tempVal = (WORD) A - (WORD) fetched;
 	setFlag(C, A >= fetched);
 	setFlag(Z, (tempVal & 0x00FF) == 0x0000);
 	setFlag(N, tempVal & 0x0080);
-	return 0;
+	return 1;
 }
 
 // Compare X Register
-BYTE emu6502::CPX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CPX(){
 	fetch();
 	tempVal = (WORD) X - (WORD) fetched;
 	setFlag(C, X >= fetched);
@@ -495,7 +921,8 @@ BYTE emu6502::CPX(){
 }
 
 // Compare Y Register
-BYTE emu6502::CPY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::CPY(){
 	fetch();
 	tempVal = (WORD) Y - (WORD) fetched;
 	setFlag(C, Y >= fetched);
@@ -505,17 +932,23 @@ BYTE emu6502::CPY(){
 }
 
 // Decrement Value at Memory Location
-BYTE emu6502::DEC(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::DEC(){
 	fetch();
 	tempVal = fetched - 1;
-	write(addr_abs, tempVal & 0x00FF);
+	// DEC A of the 65C02
+	if(VARIANT::cmos && lookup[opcode].addrmode == &emu6502Core::IMP)
+		A = tempVal & 0x00FF;
+	else
+		modify(tempVal & 0x00FF);
 	setFlag(Z, (tempVal & 0x00FF) == 0);
 	setFlag(N, tempVal & 0x0080);
 	return 0;
 }
 
 // Decrement X Register
-BYTE emu6502::DEX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::DEX(){
 	X--;
 	setFlag(Z, X == 0x00);
 	setFlag(N, X & 0x80);
@@ -523,7 +956,8 @@ BYTE emu6502::DEX(){
 }
 
 // Decrement Y Register
-BYTE emu6502::DEY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::DEY(){
 	Y--;
 	setFlag(Z, Y == 0x00);
 	setFlag(N, Y & 0x80);
@@ -531,26 +965,33 @@ BYTE emu6502::DEY(){
 }
 
 // Bitwise Logic OR
-BYTE emu6502::EOR(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::EOR(){
 	fetch();
 	A = A ^ fetched;
 	setFlag(Z, A == 0x00);
 	setFlag(N, A & 0x80);
-	return 0;
+	return 1;
 }
 
 // Increment Value at Memory Location
-BYTE emu6502::INC(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::INC(){
 	fetch();
 	tempVal = fetched + 1;
-	write(addr_abs, tempVal & 0x00FF);
+	// INC A of the 65C02
+	if(VARIANT::cmos && lookup[opcode].addrmode == &emu6502Core::IMP)
+		A = tempVal & 0x00FF;
+	else
+		modify(tempVal & 0x00FF);
 	setFlag(Z, (tempVal & 0x00FF) == 0x0000);
 	setFlag(N, tempVal & 0x0080);
 	return 0;
 }
 
 // Increment X Register
-BYTE emu6502::INX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::INX(){
 	X++;
 	setFlag(Z, X == 0x00);
 	setFlag(N, X & 0x80);
@@ -558,7 +999,8 @@ BYTE emu6502::INX(){
 }
 
 // Increment Y Register
-BYTE emu6502::INY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::INY(){
 	Y++;
 	setFlag(Z, Y == 0x00);
 	setFlag(N, Y & 0x80);
@@ -566,13 +1008,27 @@ BYTE emu6502::INY(){
 }
 
 // Jump to Location
-BYTE emu6502::JMP(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::JMP(){
 	PC = addr_abs;
 	return 0;
 }
 
 // Jump to Sub-Routine
-BYTE emu6502::JSR(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::JSR(){
+	// The address mode only skipped the low byte, the high byte is read after the pushes
+	if constexpr(TIMING::accurate){
+		WORD lo = read(addr_abs);
+		read(0x0100 + SP);
+		write(0x0100 + SP, (PC >> 8) & 0x00FF);
+		SP--;
+		write(0x0100 + SP, PC & 0x00FF);
+		SP--;
+		PC = (read(PC) << 8) | lo;
+		return 0;
+	}
+
 	PC--;
 
 	write(0x0100 + SP, (PC >> 8) & 0x00FF);
@@ -585,7 +1041,8 @@ BYTE emu6502::JSR(){
 }
 
 // Load the Accumulator
-BYTE emu6502::LDA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LDA(){
 	fetch();
 	A = fetched;
 	setFlag(Z, A == 0x00);
@@ -594,7 +1051,8 @@ BYTE emu6502::LDA(){
 }
 
 // Load X Register
-BYTE emu6502::LDX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LDX(){
 	fetch();
 	X = fetched;
 	setFlag(Z, X == 0x00);
@@ -603,7 +1061,8 @@ BYTE emu6502::LDX(){
 }
 
 // Load Y Register
-BYTE emu6502::LDY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LDY(){
 	fetch();
 	Y = fetched;
 	setFlag(Z, Y == 0x00);
@@ -613,27 +1072,33 @@ BYTE emu6502::LDY(){
 
 
 // Logical Shift Right
-BYTE emu6502::LSR(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LSR(){
 	fetch();
 	setFlag(C, fetched & 0x0001);
 	tempVal = fetched >> 1;
 	setFlag(Z, tempVal == 0x0000);
 	setFlag(N, tempVal & 0x0080);
-	if(lookup[opcode].addrmode == &emu6502::IMP)
+	if(lookup[opcode].addrmode == &emu6502Core::IMP)
 		A = tempVal & 0x00FF;
 	else
-		write(addr_abs, tempVal & 0x00FF);
-	return 0;
+		modify(tempVal & 0x00FF);
+	return VARIANT::cmos;
 }
 
 // No Operation
-BYTE emu6502::NOP(){
-	// Does nothing
-	return 0;
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::NOP(){
+	// Does nothing, the undocumented NOP abs,X can require an additional cycle. The ones with
+	// an operand read it.
+	if constexpr(TIMING::accurate)
+		fetch();
+	return 1;
 }
 
 // Bitwise Logic OR
-BYTE emu6502::ORA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ORA(){
 	fetch();
 	A = A | fetched;
 	setFlag(Z, A == 0x00);
@@ -642,83 +1107,81 @@ BYTE emu6502::ORA(){
 }
 
 // Push Accumulator to stack
-BYTE emu6502::PHA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PHA(){
 	write(0x0100 + SP, A);
 	SP--;
 	return 0;
 }
 
 // Push Status Register to stack
-BYTE emu6502::PHP(){
-	write(0x0100 + SP, (((((((((((((Uf < 1) | Nf) < 1) | Vf) < 1) | Bf) < 1) | Df) < 1) | If) < 1) | Zf) < 1) | Cf);
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PHP(){
+	write(0x0100 + SP, getStatus() | (1 << B) | (1 << U));
 	SP--;
 	return 0;
 }
 
 // Pop Accumulator of stack
-BYTE emu6502::PLA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PLA(){
+	if constexpr(TIMING::accurate)
+		read(0x0100 + SP);
 	SP++;
 	A = read(0x0100 + SP);
-	setFlag(Z, A = 0x00);
+	setFlag(Z, A == 0x00);
 	setFlag(N, A & 0x80);
 	return 0;
 }
 
 // Pop Status of the stack
-BYTE emu6502::PLP(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PLP(){
+	if constexpr(TIMING::accurate)
+		read(0x0100 + SP);
 	SP++;
-	tempVal = read(0x0100 + SP);
-	Cf = (tempVal & 0x01) > 0;
-	Zf = (tempVal & 0x02) > 0;
-	If = (tempVal & 0x04) > 0;
-	Df = (tempVal & 0x08) > 0;
-	Bf = (tempVal & 0x10) > 0;
-	Vf = (tempVal & 0x20) > 0;
-	Nf = (tempVal & 0x40) > 0;
-	Uf = (tempVal & 0x80) > 0;
+	setStatus(read(0x0100 + SP));
 	return 0;
 }
 
 // Rotate Left
-BYTE emu6502::ROL(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ROL(){
 	fetch();
 	tempVal = (fetched << 1) | getFlag(C);
 	setFlag(C, tempVal & 0x0100);
 	setFlag(Z, (tempVal & 0x00FF) == 0x0000);
 	setFlag(N, tempVal & 0x0080);
-	if(lookup[opcode].addrmode == &emu6502::IMP)
+	if(lookup[opcode].addrmode == &emu6502Core::IMP)
 		A = tempVal & 0x00FF;
 	else
-		write(addr_abs, tempVal & 0x00FF);
-	return 0;
+		modify(tempVal & 0x00FF);
+	return VARIANT::cmos;
 }
 
 // Rotate Right
-BYTE emu6502::ROR(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ROR(){
 	fetch();
 	tempVal = (fetched >> 1) | ((WORD) getFlag(C) << 7);
-	setFlag(C, tempVal & 0x0001);
+	setFlag(C, fetched & 0x0001);
 	setFlag(Z, (tempVal & 0x00FF) == 0x0000);
 	setFlag(N, tempVal & 0x0080);
-	if(lookup[opcode].addrmode == &emu6502::IMP)
+	if(lookup[opcode].addrmode == &emu6502Core::IMP)
 		A = tempVal & 0x00FF;
 	else
-		write(addr_abs, tempVal & 0x00FF);
-	return 0;
+		modify(tempVal & 0x00FF);
+	return VARIANT::cmos;
 }
 
 // Return from Interrupt
-BYTE emu6502::RTI(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::RTI(){
+	// The stack is read once before the pulls
+	if constexpr(TIMING::accurate)
+		read(0x0100 + SP);
 	SP++;
-	tempVal = read(0x0100 + SP);
-	Cf = (tempVal & 0x01) > 0;
-	Zf = (tempVal & 0x02) > 0;
-	If = (tempVal & 0x04) > 0;
-	Df = (tempVal & 0x08) > 0;
-	Bf = (tempVal & 0x10) > 0;
-	Vf = (tempVal & 0x20) > 0;
-	Nf = (tempVal & 0x40) > 0;
-	Uf = (tempVal & 0x80) > 0;
+	setStatus(read(0x0100 + SP));
 	
 	SP++;
 	PC = read(0x0100 + SP);
@@ -728,52 +1191,66 @@ BYTE emu6502::RTI(){
 }
 
 // Return from Subroutine
-BYTE emu6502::RTS(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::RTS(){
+	if constexpr(TIMING::accurate)
+		read(0x0100 + SP);
 	SP++;
 	PC = read(0x0100 + SP);
 	SP++;
 	PC |= (read(0x0100 + SP) << 8);
+	// JSR pushed the address of its last byte, it is read once more
+	if constexpr(TIMING::accurate)
+		read(PC);
+	PC++;
 	return 0;
 }
 
 // Set Carry Flag
-BYTE emu6502::SEC(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SEC(){
 	setFlag(C, 1);
 	return 0;
 }
 
 // Set Decimal Flag
-BYTE emu6502::SED(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SED(){
 	setFlag(D, 1);
 	return 0;
 }
 
 // Set Interrupt Flag
-BYTE emu6502::SEI(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SEI(){
 	setFlag(I, 1);
 	return 0;
 }
 
 // Store Accumulator at address
-BYTE emu6502::STA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::STA(){
 	write(addr_abs, A);
 	return 0;
 }
 
 // Store X at address
-BYTE emu6502::STX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::STX(){
 	write(addr_abs, X);
 	return 0;
 }
 
 // Store Y at address
-BYTE emu6502::STY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::STY(){
 	write(addr_abs, Y);
 	return 0;
 }
 
 // Transfer Accumulator to X
-BYTE emu6502::TAX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TAX(){
 	X = A;
 	setFlag(Z, X == 0x00);
 	setFlag(N, X & 0x80);
@@ -781,7 +1258,8 @@ BYTE emu6502::TAX(){
 }
 
 // Transfer Accumulator to Y
-BYTE emu6502::TAY(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TAY(){
 	Y = A;
 	setFlag(Z, Y == 0x00);
 	setFlag(N, Y & 0x80);
@@ -789,7 +1267,8 @@ BYTE emu6502::TAY(){
 }
 
 // Transfer SP to X
-BYTE emu6502::TSX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TSX(){
 	X = SP;
 	setFlag(Z, X == 0x00);
 	setFlag(N, X & 0x80);
@@ -797,7 +1276,8 @@ BYTE emu6502::TSX(){
 }
 
 // Transfer X to Accumulator
-BYTE emu6502::TXA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TXA(){
 	A = X;
 	setFlag(Z, A == 0x00);
 	setFlag(N, A & 0x80);
@@ -805,13 +1285,15 @@ BYTE emu6502::TXA(){
 }
 
 // Transfer X to SP
-BYTE emu6502::TXS(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TXS(){
 	SP = X;
 	return 0;
 }
 
 // Transfer Y to Accumulator
-BYTE emu6502::TYA(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TYA(){
 	A = Y;
 	setFlag(Z, Y == 0x00);
 	setFlag(N, Y & 0x80);
@@ -819,6 +1301,308 @@ BYTE emu6502::TYA(){
 }
 
 // Illegal opcodes
-BYTE emu6502::XXX(){
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::XXX(){
+	return 0;
+}
+
+
+// Undocumented opcodes of the NMOS 6502
+// See https://www.masswerk.at/6502/6502_instruction_set.html#illegals
+
+// ASL and ORA
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SLO(){
+	ASL();
+	A = A | (tempVal & 0x00FF);
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 0;
+}
+
+// ROL and AND
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::RLA(){
+	ROL();
+	A = A & (tempVal & 0x00FF);
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 0;
+}
+
+// LSR and EOR
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SRE(){
+	LSR();
+	A = A ^ (tempVal & 0x00FF);
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 0;
+}
+
+// ROR and ADC, the carry of the rotation goes into the addition
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::RRA(){
+	ROR();
+	fetched = tempVal & 0x00FF;
+	add();
+	return 0;
+}
+
+// Store A & X
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SAX(){
+	write(addr_abs, A & X);
+	return 0;
+}
+
+// Load A and X
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LAX(){
+	fetch();
+	A = fetched;
+	X = fetched;
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 1;
+}
+
+// DEC and CMP
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::DCP(){
+	DEC();
+	BYTE value = tempVal & 0x00FF;
+	tempVal = (WORD) A - (WORD) value;
+	setFlag(C, A >= value);
+	setFlag(Z, (tempVal & 0x00FF) == 0x0000);
+	setFlag(N, tempVal & 0x0080);
+	return 0;
+}
+
+// INC and SBC
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ISC(){
+	INC();
+	fetched = tempVal & 0x00FF;
+	subtract();
+	return 0;
+}
+
+// AND, then C like N
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ANC(){
+	AND();
+	setFlag(C, A & 0x80);
+	return 0;
+}
+
+// AND and LSR A
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ALR(){
+	fetch();
+	A = A & fetched;
+	setFlag(C, A & 0x01);
+	A = A >> 1;
+	setFlag(Z, A == 0x00);
+	setFlag(N, 0);
+	return 0;
+}
+
+// AND and ROR A, with the flags of the adder. In decimal mode the result is corrected
+// like the nibbles of ADC.
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::ARR(){
+	fetch();
+	BYTE value = A & fetched;
+	A = (value >> 1) | (getFlag(C) << 7);
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	if(getFlag(D)){
+		setFlag(V, (value ^ A) & 0x40);
+		if((value & 0x0F) + (value & 0x01) > 0x05)
+			A = (A & 0xF0) | ((A + 0x06) & 0x0F);
+		setFlag(C, (value & 0xF0) + (value & 0x10) > 0x50);
+		if(getFlag(C))
+			A += 0x60;
+		return 0;
+	}
+	setFlag(C, A & 0x40);
+	setFlag(V, ((A >> 6) ^ (A >> 5)) & 0x01);
+	return 0;
+}
+
+// X = (A & X) - value, without the carry, with the flags of CMP
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SBX(){
+	fetch();
+	BYTE value = A & X;
+	tempVal = (WORD) value - (WORD) fetched;
+	setFlag(C, value >= fetched);
+	X = tempVal & 0x00FF;
+	setFlag(Z, X == 0x00);
+	setFlag(N, X & 0x80);
+	return 0;
+}
+
+// Unstable, emulated with the constant 0xEE most chips show
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::XAA(){
+	fetch();
+	A = (A | 0xEE) & X & fetched;
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 0;
+}
+
+// Unstable like XAA
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LXA(){
+	fetch();
+	A = (A | 0xEE) & fetched;
+	X = A;
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 0;
+}
+
+// The index is Y for all modes of SHA
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SHA(){
+	storeUnstable(A & X, Y);
+	return 0;
+}
+
+// SP = A & X, then stored like SHA
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TAS(){
+	SP = A & X;
+	storeUnstable(SP, Y);
+	return 0;
+}
+
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SHY(){
+	storeUnstable(Y, X);
+	return 0;
+}
+
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::SHX(){
+	storeUnstable(X, Y);
+	return 0;
+}
+
+// A, X and SP are loaded with the value & SP
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::LAS(){
+	fetch();
+	A = fetched & SP;
+	X = A;
+	SP = A;
+	setFlag(Z, A == 0x00);
+	setFlag(N, A & 0x80);
+	return 1;
+}
+
+// Freezes the CPU: it stays on the opcode until a reset, the idle detection lets the bus
+// skip the time
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::JAM(){
+	PC--;
+	return 0;
+}
+
+// When the indexing crosses a page, the stored value replaces the high byte of the address
+template<class VARIANT, class TIMING>
+void emu6502Core<VARIANT, TIMING>::storeUnstable(BYTE value, BYTE index){
+	WORD base = addr_abs - index;
+	BYTE data = value & ((base >> 8) + 1);
+	if((base & 0xFF00) != (addr_abs & 0xFF00))
+		addr_abs = (data << 8) | (addr_abs & 0x00FF);
+	write(addr_abs, data);
+}
+
+
+// Opcodes added by the 65C02
+// See http://www.6502.org/tutorials/65c02opcodes.html
+
+// Branch Always
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::BRA(){
+	branch();
+	return 0;
+}
+
+// Push X to stack
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PHX(){
+	write(0x0100 + SP, X);
+	SP--;
 	return 0;
-}
\ No newline at end of file
+}
+
+// Push Y to stack
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PHY(){
+	write(0x0100 + SP, Y);
+	SP--;
+	return 0;
+}
+
+// Pop X of stack
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PLX(){
+	if constexpr(TIMING::accurate)
+		read(0x0100 + SP);
+	SP++;
+	X = read(0x0100 + SP);
+	setFlag(Z, X == 0x00);
+	setFlag(N, X & 0x80);
+	return 0;
+}
+
+// Pop Y of stack
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::PLY(){
+	if constexpr(TIMING::accurate)
+		read(0x0100 + SP);
+	SP++;
+	Y = read(0x0100 + SP);
+	setFlag(Z, Y == 0x00);
+	setFlag(N, Y & 0x80);
+	return 0;
+}
+
+// Store Zero at address
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::STZ(){
+	write(addr_abs, 0x00);
+	return 0;
+}
+
+// Test and Reset Bits: clears the bits of A in memory, Z like BIT
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TRB(){
+	fetch();
+	setFlag(Z, (A & fetched) == 0x00);
+	write(addr_abs, fetched & ~A);
+	return 0;
+}
+
+// Test and Set Bits: sets the bits of A in memory, Z like BIT
+template<class VARIANT, class TIMING>
+BYTE emu6502Core<VARIANT, TIMING>::TSB(){
+	fetch();
+	setFlag(Z, (A & fetched) == 0x00);
+	write(addr_abs, fetched | A);
+	return 0;
+}
+
+
+template class emu6502Core<NMOS6502>;
+template class emu6502Core<NMOS6502_UNDOCUMENTED>;
+template class emu6502Core<CMOS65C02>;
+template class emu6502Core<NMOS6502_STRICT>;
+template class emu6502Core<NMOS6502, CYCLE_ACCURATE>;
+template class emu6502Core<NMOS6502_UNDOCUMENTED, CYCLE_ACCURATE>;
+template class emu6502Core<NMOS6502_STRICT, CYCLE_ACCURATE>;
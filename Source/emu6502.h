@@ -11,20 +11,23 @@
 
 #pragma once
 
+#include <array>
+
 #include "datatypes.h"
+#include "cpuVariants.h"
 
 // http://www.6502.org/users/obelisk/6502/architecturew.html
 
 
 // Forward declaration of the bus class to avoid circular inclusions
 class Bus;
+struct CPU_COUNTERS;
 
 
-class emu6502{
+// Everything of the CPU which is the same on all variants. The instructions are in
+// emu6502Core, the CPU of the build is emu6502 (see the end of this file).
+class emu6502Base{
 public:
-    emu6502();
-    ~emu6502();
-
     // CPU registers
     WORD PC = 0x0000;   // Program counter
     BYTE SP = 0x00;     // Stack pointer (points to 0x0100 - 0x01FF)
@@ -36,39 +39,99 @@ public:
     BYTE Cf : 1 = 0;     // Carry bit
     BYTE Zf : 1 = 0;     // Zero
     BYTE If : 1 = 0;     // Disable interupts
-    BYTE Df : 1 = 0;     // Decimal mode !!not implemented!!
+    BYTE Df : 1 = 0;     // Decimal mode
     BYTE Bf : 1 = 0;     // Break
     BYTE Vf : 1 = 0;     // Overflow
     BYTE Nf : 1 = 0;     // Negative
     BYTE Uf : 1 = 0;     // Unused bit
 
     // Enums for accessing flags
+    // The values match the bit positions inside the status register
     enum FLAGS{
         C = 0,
         Z = 1,
         I = 2,
         D = 3,
         B = 4,
-        V = 5,
-        N = 6,
-        U = 7
+        U = 5,
+        V = 6,
+        N = 7
     };
 
     // Flags
     void setFlag(FLAGS flag, bool val);
     BYTE getFlag(FLAGS flag);
 
+    // Status register as one byte (NV-BDIZC), used by the stack operations
+    BYTE getStatus();
+    void setStatus(BYTE status);
+
     void reset();
-    void clock();
-    // irq, nmi
 
     bool completed();
 
+    // Number of executed instructions
+    unsigned long long instructions = 0;
+
+    // Traps
+    // A trap halts the CPU: the instruction which caused it is left unexecuted (illegal opcode,
+    // BRK) or completed (the others), afterwards clock() does nothing until reset() or load().
+    enum class Stop : BYTE{
+        None,
+        IllegalOpcode,      // An opcode the variant doesn't define
+        Break,              // BRK
+        SelfLoop,           // A jump or branch onto itself
+        ExitWrite,          // A write to traps.exitAddress
+        StackWrap,          // The stack pointer wrapped around
+        CycleBudget,        // Budgets and termination are checked by Bus::runUntilStop()
+        InstructionBudget,
+        Terminated
+    };
+    struct TRAPS{
+        bool illegalOpcode = false;
+        bool brk = false;
+        bool selfLoop = false;
+        bool stackWrap = false;
+        bool exitWrite = false;
+        WORD exitAddress = 0x0000;
+        unsigned long long maxCycles = 0;          // 0: no budget
+        unsigned long long maxInstructions = 0;
+    };
+    const TRAPS& getTraps() { return traps; }
+    Stop stop = Stop::None;
+    BYTE exitValue = 0x00;      // Data of the write which stopped with ExitWrite
+    static const char* describe(Stop stop);
+
+    // Registers and the progress of the current instruction, used by Bus checkpoints
+    struct STATE{
+        WORD PC;
+        BYTE SP, X, Y, A, status;
+        BYTE cycles;
+    };
+    STATE save();
+    void load(const STATE& state);
+
+    // True while the CPU spins in a loop which can't leave on its own: the last two
+    // backward jumps found the same registers and the memory didn't change since.
+    bool isIdle();
+
     // Connecting the CPU with the bus
     void ConnectBus(Bus* t) { bus = t; }
+
+    // Optional edge coverage map for the fuzzer (coverageMask + 1 counters). Every branch,
+    // jump, call and return counts the pair of its address and the new PC.
+    BYTE* coverage = nullptr;
+    WORD coverageMask = 0x0FFF;
+
+    // Optional counters of the executed opcodes and the accesses per region, set by Metrics
+    CPU_COUNTERS* counters = nullptr;
+
+    // Optional private zero page and stack (0x0000 - 0x01FF) of this core, set by MultiCore.
+    // Accesses to them don't reach the bus.
+    BYTE* local = nullptr;
     
     
-private:
+protected:
     // Components for the bus
     Bus* bus = nullptr;
     BYTE read(WORD addr);
@@ -82,37 +145,73 @@ private:
     WORD addr_rel    = 0x0000;   // Holds the relative address 
     BYTE cycles      = 0;        // Counts the remaining cycles
 
+    // State at the last backward jump, used for the idle loop detection
+    struct LOOPSTATE{
+        WORD PC = 0x0000;
+        BYTE A = 0x00, X = 0x00, Y = 0x00, SP = 0x00, status = 0x00;
+        unsigned long long changes = 0;
+    };
+    LOOPSTATE loop;
+    bool idle = false;
+    unsigned long long localChanges = 0;   // Writes into the private pages
+    void detectIdle();
+
+    TRAPS traps;
+    bool trapping = false;      // Any of the CPU traps is set
+    Stop opcodeTraps[256] = {}; // Trap of each opcode, set up by setTraps()
+};
+
+
+// The CPU, VARIANT and TIMING are policies of cpuVariants.h. Everything that differs between
+// them is decided at compile time, so a build pays nothing for the others.
+template<class VARIANT, class TIMING = ATOMIC>
+class emu6502Core : public emu6502Base{
+    static_assert(!(TIMING::accurate && VARIANT::cmos), "The cycle accurate timing only knows the NMOS chip");
+
+public:
+    emu6502Core();
+    ~emu6502Core();
+
+    static constexpr bool accurate = TIMING::accurate;
+
+    // With the cycle accurate timing the instruction runs in the first clock() as well, but it
+    // counts its bus accesses instead of taking the cycles of the table
+    void clock();
+    // Bus::clock() of the cycle accurate timing: takes the interrupt if requested or runs the
+    // next instruction, and clocks the devices of the bus after each of its accesses
+    void step(bool interrupt);
+    // Interrupt request, only call it between instructions (completed() is true)
+    void irq();
+
+    void setTraps(const TRAPS& traps);
+
+private:
+    // Every access of the cycle accurate timing takes a cycle
+    BYTE read(WORD addr);
+    void write(WORD addr, BYTE data);
+    void busCycle();
+    bool ticking = false;       // Set by step(), the accesses clock the devices
+
     BYTE fetch();
 
+    void traceEdge(WORD from);
+    void trapAfter(WORD start, BYTE startSP);
+
     struct INSTRUCTION{
-        BYTE (emu6502::*operate ) (void) = nullptr; // Function pointer to the current operation
-        BYTE (emu6502::*addrmode) (void) = nullptr; // Function pointer to the current addressing mode
+        BYTE (emu6502Core::*operate ) (void) = nullptr; // Function pointer to the current operation
+        BYTE (emu6502Core::*addrmode) (void) = nullptr; // Function pointer to the current addressing mode
         BYTE cycles = 0;
+        bool stores = false;    // Writes or read-modify-writes, indexing always costs their cycle
     };
 
     // Lookup table for the instructions
     // Each entry consists of a pointer to the corresponding function, a pointer to the mode
-    // and the associated number of cycles. The positon in the table corresponds to the opcode
-    // table.
+    // and the associated number of cycles. The positon in the table corresponds to the opcode.
+    // It is built at compile time from the description of the variant in opcodes.h and shared
+    // by all instances.
     // For more info visit page 10 of https://web.archive.org/web/20221112231348if_/http://archive.6502.org/datasheets/rockwell_r650x_r651x.pdf
-    INSTRUCTION lookup[256] = {
-        { &emu6502::BRK, &emu6502::IMM, 7 },{ &emu6502::ORA, &emu6502::IZX, 6 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 3 },{ &emu6502::ORA, &emu6502::ZP0, 3 },{ &emu6502::ASL, &emu6502::ZP0, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::PHP, &emu6502::IMP, 3 },{ &emu6502::ORA, &emu6502::IMM, 2 },{ &emu6502::ASL, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::ORA, &emu6502::ABS, 4 },{ &emu6502::ASL, &emu6502::ABS, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },
-        { &emu6502::BPL, &emu6502::REL, 2 },{ &emu6502::ORA, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::ORA, &emu6502::ZPX, 4 },{ &emu6502::ASL, &emu6502::ZPX, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::CLC, &emu6502::IMP, 2 },{ &emu6502::ORA, &emu6502::ABY, 4 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 7 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::ORA, &emu6502::ABX, 4 },{ &emu6502::ASL, &emu6502::ABX, 7 },{ &emu6502::XXX, &emu6502::IMP, 7 },
-		{ &emu6502::JSR, &emu6502::ABS, 6 },{ &emu6502::AND, &emu6502::IZX, 6 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::BIT, &emu6502::ZP0, 3 },{ &emu6502::AND, &emu6502::ZP0, 3 },{ &emu6502::ROL, &emu6502::ZP0, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::PLP, &emu6502::IMP, 4 },{ &emu6502::AND, &emu6502::IMM, 2 },{ &emu6502::ROL, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::BIT, &emu6502::ABS, 4 },{ &emu6502::AND, &emu6502::ABS, 4 },{ &emu6502::ROL, &emu6502::ABS, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },
-		{ &emu6502::BMI, &emu6502::REL, 2 },{ &emu6502::AND, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::AND, &emu6502::ZPX, 4 },{ &emu6502::ROL, &emu6502::ZPX, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::SEC, &emu6502::IMP, 2 },{ &emu6502::AND, &emu6502::ABY, 4 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 7 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::AND, &emu6502::ABX, 4 },{ &emu6502::ROL, &emu6502::ABX, 7 },{ &emu6502::XXX, &emu6502::IMP, 7 },
-		{ &emu6502::RTI, &emu6502::IMP, 6 },{ &emu6502::EOR, &emu6502::IZX, 6 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 3 },{ &emu6502::EOR, &emu6502::ZP0, 3 },{ &emu6502::LSR, &emu6502::ZP0, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::PHA, &emu6502::IMP, 3 },{ &emu6502::EOR, &emu6502::IMM, 2 },{ &emu6502::LSR, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::JMP, &emu6502::ABS, 3 },{ &emu6502::EOR, &emu6502::ABS, 4 },{ &emu6502::LSR, &emu6502::ABS, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },
-		{ &emu6502::BVC, &emu6502::REL, 2 },{ &emu6502::EOR, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::EOR, &emu6502::ZPX, 4 },{ &emu6502::LSR, &emu6502::ZPX, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::CLI, &emu6502::IMP, 2 },{ &emu6502::EOR, &emu6502::ABY, 4 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 7 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::EOR, &emu6502::ABX, 4 },{ &emu6502::LSR, &emu6502::ABX, 7 },{ &emu6502::XXX, &emu6502::IMP, 7 },
-		{ &emu6502::RTS, &emu6502::IMP, 6 },{ &emu6502::ADC, &emu6502::IZX, 6 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 3 },{ &emu6502::ADC, &emu6502::ZP0, 3 },{ &emu6502::ROR, &emu6502::ZP0, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::PLA, &emu6502::IMP, 4 },{ &emu6502::ADC, &emu6502::IMM, 2 },{ &emu6502::ROR, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::JMP, &emu6502::IND, 5 },{ &emu6502::ADC, &emu6502::ABS, 4 },{ &emu6502::ROR, &emu6502::ABS, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },
-		{ &emu6502::BVS, &emu6502::REL, 2 },{ &emu6502::ADC, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::ADC, &emu6502::ZPX, 4 },{ &emu6502::ROR, &emu6502::ZPX, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::SEI, &emu6502::IMP, 2 },{ &emu6502::ADC, &emu6502::ABY, 4 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 7 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::ADC, &emu6502::ABX, 4 },{ &emu6502::ROR, &emu6502::ABX, 7 },{ &emu6502::XXX, &emu6502::IMP, 7 },
-		{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::STA, &emu6502::IZX, 6 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::STY, &emu6502::ZP0, 3 },{ &emu6502::STA, &emu6502::ZP0, 3 },{ &emu6502::STX, &emu6502::ZP0, 3 },{ &emu6502::XXX, &emu6502::IMP, 3 },{ &emu6502::DEY, &emu6502::IMP, 2 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::TXA, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::STY, &emu6502::ABS, 4 },{ &emu6502::STA, &emu6502::ABS, 4 },{ &emu6502::STX, &emu6502::ABS, 4 },{ &emu6502::XXX, &emu6502::IMP, 4 },
-		{ &emu6502::BCC, &emu6502::REL, 2 },{ &emu6502::STA, &emu6502::IZY, 6 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::STY, &emu6502::ZPX, 4 },{ &emu6502::STA, &emu6502::ZPX, 4 },{ &emu6502::STX, &emu6502::ZPY, 4 },{ &emu6502::XXX, &emu6502::IMP, 4 },{ &emu6502::TYA, &emu6502::IMP, 2 },{ &emu6502::STA, &emu6502::ABY, 5 },{ &emu6502::TXS, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::NOP, &emu6502::IMP, 5 },{ &emu6502::STA, &emu6502::ABX, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },
-		{ &emu6502::LDY, &emu6502::IMM, 2 },{ &emu6502::LDA, &emu6502::IZX, 6 },{ &emu6502::LDX, &emu6502::IMM, 2 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::LDY, &emu6502::ZP0, 3 },{ &emu6502::LDA, &emu6502::ZP0, 3 },{ &emu6502::LDX, &emu6502::ZP0, 3 },{ &emu6502::XXX, &emu6502::IMP, 3 },{ &emu6502::TAY, &emu6502::IMP, 2 },{ &emu6502::LDA, &emu6502::IMM, 2 },{ &emu6502::TAX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::LDY, &emu6502::ABS, 4 },{ &emu6502::LDA, &emu6502::ABS, 4 },{ &emu6502::LDX, &emu6502::ABS, 4 },{ &emu6502::XXX, &emu6502::IMP, 4 },
-		{ &emu6502::BCS, &emu6502::REL, 2 },{ &emu6502::LDA, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::LDY, &emu6502::ZPX, 4 },{ &emu6502::LDA, &emu6502::ZPX, 4 },{ &emu6502::LDX, &emu6502::ZPY, 4 },{ &emu6502::XXX, &emu6502::IMP, 4 },{ &emu6502::CLV, &emu6502::IMP, 2 },{ &emu6502::LDA, &emu6502::ABY, 4 },{ &emu6502::TSX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 4 },{ &emu6502::LDY, &emu6502::ABX, 4 },{ &emu6502::LDA, &emu6502::ABX, 4 },{ &emu6502::LDX, &emu6502::ABY, 4 },{ &emu6502::XXX, &emu6502::IMP, 4 },
-		{ &emu6502::CPY, &emu6502::IMM, 2 },{ &emu6502::CMP, &emu6502::IZX, 6 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::CPY, &emu6502::ZP0, 3 },{ &emu6502::CMP, &emu6502::ZP0, 3 },{ &emu6502::DEC, &emu6502::ZP0, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::INY, &emu6502::IMP, 2 },{ &emu6502::CMP, &emu6502::IMM, 2 },{ &emu6502::DEX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::CPY, &emu6502::ABS, 4 },{ &emu6502::CMP, &emu6502::ABS, 4 },{ &emu6502::DEC, &emu6502::ABS, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },
-		{ &emu6502::BNE, &emu6502::REL, 2 },{ &emu6502::CMP, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::CMP, &emu6502::ZPX, 4 },{ &emu6502::DEC, &emu6502::ZPX, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::CLD, &emu6502::IMP, 2 },{ &emu6502::CMP, &emu6502::ABY, 4 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 7 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::CMP, &emu6502::ABX, 4 },{ &emu6502::DEC, &emu6502::ABX, 7 },{ &emu6502::XXX, &emu6502::IMP, 7 },
-		{ &emu6502::CPX, &emu6502::IMM, 2 },{ &emu6502::SBC, &emu6502::IZX, 6 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::CPX, &emu6502::ZP0, 3 },{ &emu6502::SBC, &emu6502::ZP0, 3 },{ &emu6502::INC, &emu6502::ZP0, 5 },{ &emu6502::XXX, &emu6502::IMP, 5 },{ &emu6502::INX, &emu6502::IMP, 2 },{ &emu6502::SBC, &emu6502::IMM, 2 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::SBC, &emu6502::IMP, 2 },{ &emu6502::CPX, &emu6502::ABS, 4 },{ &emu6502::SBC, &emu6502::ABS, 4 },{ &emu6502::INC, &emu6502::ABS, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },
-		{ &emu6502::BEQ, &emu6502::REL, 2 },{ &emu6502::SBC, &emu6502::IZY, 5 },{ &emu6502::XXX, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 8 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::SBC, &emu6502::ZPX, 4 },{ &emu6502::INC, &emu6502::ZPX, 6 },{ &emu6502::XXX, &emu6502::IMP, 6 },{ &emu6502::SED, &emu6502::IMP, 2 },{ &emu6502::SBC, &emu6502::ABY, 4 },{ &emu6502::NOP, &emu6502::IMP, 2 },{ &emu6502::XXX, &emu6502::IMP, 7 },{ &emu6502::NOP, &emu6502::IMP, 4 },{ &emu6502::SBC, &emu6502::ABX, 4 },{ &emu6502::INC, &emu6502::ABX, 7 },{ &emu6502::XXX, &emu6502::IMP, 7 }
-    };
+    static const std::array<INSTRUCTION, 256> lookup;
+    static constexpr std::array<INSTRUCTION, 256> buildLookup();
 
     // Addressing modes
     // Each type of addressing has a number of cycles associated with it.
@@ -125,6 +224,7 @@ private:
     BYTE ABS(); BYTE ABX();
     BYTE ABY(); BYTE IND();
     BYTE IZX(); BYTE IZY();
+    BYTE ZPI(); BYTE IAX();     // 65C02
 
     // Opcodes
     // These are the 56 official opcodes of the 6502.
@@ -149,8 +249,42 @@ private:
 	BYTE STX();	BYTE STY();	BYTE TAX();	BYTE TAY();
 	BYTE TSX();	BYTE TXA();	BYTE TXS();	BYTE TYA();
 
+    // Undocumented opcodes of the NMOS 6502
+    BYTE SLO();	BYTE RLA();	BYTE SRE();	BYTE RRA();
+	BYTE SAX();	BYTE LAX();	BYTE DCP();	BYTE ISC();
+	BYTE ANC();	BYTE ALR();	BYTE ARR();	BYTE SBX();
+	BYTE XAA();	BYTE LXA();	BYTE SHA();	BYTE TAS();
+	BYTE SHY();	BYTE SHX();	BYTE LAS();	BYTE JAM();
+
+    // Opcodes added by the 65C02
+    BYTE BRA();	BYTE PHX();	BYTE PHY();	BYTE PLX();
+	BYTE PLY();	BYTE STZ();	BYTE TRB();	BYTE TSB();
+
     // This function captures all unofficial opcodes.
     // It does nothing and is implemented identical to the NOP
     BYTE XXX();
 
-};
\ No newline at end of file
+    // Taken branch
+    void branch();
+    // Writes the result of a read-modify-write, the NMOS chip writes the old value first
+    void modify(BYTE data);
+
+    // Helpers of ADC, SBC and the undocumented opcodes, they work on fetched
+    void add();
+    void subtract();
+    // Stores value & (high byte of the address before indexing + 1), like SHA, SHX, SHY, TAS
+    void storeUnstable(BYTE value, BYTE index);
+
+};
+
+// The CPU of this build
+using emu6502 = emu6502Core<CPU_VARIANT, CPU_TIMING>;
+
+// All variants are compiled into emu6502.cpp
+extern template class emu6502Core<NMOS6502>;
+extern template class emu6502Core<NMOS6502_UNDOCUMENTED>;
+extern template class emu6502Core<CMOS65C02>;
+extern template class emu6502Core<NMOS6502_STRICT>;
+extern template class emu6502Core<NMOS6502, CYCLE_ACCURATE>;
+extern template class emu6502Core<NMOS6502_UNDOCUMENTED, CYCLE_ACCURATE>;
+extern template class emu6502Core<NMOS6502_STRICT, CYCLE_ACCURATE>;
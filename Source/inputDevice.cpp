@@ -0,0 +1,152 @@
+#include "inputDevice.h"
+#include "bus.h"
+
+#include <chrono>
+
+InputDevice::InputDevice(){
+    // Does nothing
+}
+
+InputDevice::~InputDevice(){
+    if(recordFile)
+        fclose(recordFile);
+}
+
+void InputDevice::reset(){
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    lost.store(false, std::memory_order_relaxed);
+    present = false;
+    enabled = false;
+    while(scriptPosition > 0 && script[scriptPosition - 1].cycle >= bus->clockCount)
+        scriptPosition--;
+}
+
+bool InputDevice::push(BYTE type, WORD code, BYTE mods, BYTE x, BYTE y){
+    size_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) == RING_SIZE){
+        lost.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    unsigned long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    ring[h & (RING_SIZE - 1)] = { now, 0, type, code, mods, x, y };
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+// Moves the next event into the registers
+void InputDevice::deliver(){
+    if(replaying){
+        if(scriptPosition == script.size() || script[scriptPosition].cycle > bus->clockCount)
+            return;
+        current = script[scriptPosition++];
+    }
+    else{
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t == head.load(std::memory_order_acquire))
+            return;
+        current = ring[t & (RING_SIZE - 1)];
+        tail.store(t + 1, std::memory_order_release);
+    }
+    current.cycle = bus->clockCount;
+    present = true;
+    delivered++;
+
+    // The registers changed, a loop which polls them isn't idle anymore
+    if(bus->shared)
+        std::atomic_ref<unsigned long long>(bus->changes).fetch_add(1, std::memory_order_relaxed);
+    else
+        bus->changes++;
+
+    // 8 bytes host time, 8 bytes cycle, type, 2 bytes code, modifiers, x, y (little endian)
+    if(recordFile){
+        BYTE data[22];
+        for(int i = 0; i < 8; i++){
+            data[i] = current.hostNs >> (8 * i);
+            data[8 + i] = current.cycle >> (8 * i);
+        }
+        data[16] = current.type;
+        data[17] = current.code & 0xFF;
+        data[18] = current.code >> 8;
+        data[19] = current.mods;
+        data[20] = current.x;
+        data[21] = current.y;
+        fwrite(data, 1, sizeof(data), recordFile);
+    }
+}
+
+bool InputDevice::waiting(){
+    if(present)
+        return false;
+    if(replaying)
+        return scriptPosition < script.size() && script[scriptPosition].cycle <= bus->clockCount;
+    return tail.load(std::memory_order_relaxed) != head.load(std::memory_order_acquire);
+}
+
+unsigned long long InputDevice::pendingCycles(){
+    if(!replaying || scriptPosition == script.size() || script[scriptPosition].cycle <= bus->clockCount)
+        return 0;
+    return script[scriptPosition].cycle - bus->clockCount;
+}
+
+BYTE InputDevice::read(WORD addr){
+    if(!present)
+        deliver();
+    switch(addr){
+        case STATUS:     return (present ? 0x01 : 0x00) | (lost.load(std::memory_order_relaxed) ? 0x40 : 0x00) | (enabled ? 0x80 : 0x00);
+        case START + 1:  return current.type;
+        case START + 2:  return current.code & 0xFF;
+        case START + 3:  return current.code >> 8;
+        case START + 4:  return current.mods;
+        case START + 5:  return current.x;
+        case START + 6:  return current.y;
+    }
+    return 0x00;
+}
+
+void InputDevice::write(WORD addr, BYTE data){
+    if(addr == STATUS){
+        enabled = data & 0x80;
+        if(data & 0x40)
+            lost.store(false, std::memory_order_relaxed);
+    }
+    else if(addr == NEXT){
+        current = {};
+        present = false;
+    }
+}
+
+bool InputDevice::record(std::string path){
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+        return false;
+    if(recordFile)
+        fclose(recordFile);
+    recordFile = file;
+    return true;
+}
+
+bool InputDevice::replay(std::string path){
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+        return false;
+    script.clear();
+    BYTE data[22];
+    while(fread(data, 1, sizeof(data), file) == sizeof(data)){
+        EVENT event = {};
+        for(int i = 0; i < 8; i++){
+            event.hostNs |= (unsigned long long) data[i] << (8 * i);
+            event.cycle |= (unsigned long long) data[8 + i] << (8 * i);
+        }
+        event.type = data[16];
+        event.code = data[17] | data[18] << 8;
+        event.mods = data[19];
+        event.x = data[20];
+        event.y = data[21];
+        script.push_back(event);
+    }
+    fclose(file);
+    scriptPosition = 0;
+    replaying = true;
+    return true;
+}
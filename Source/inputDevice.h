@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "datatypes.h"
+
+class Bus;
+
+// Keyboard and mouse.
+// Registers (0x0240 - 0x0247):
+//   0x0240          status: bit 0 an event is in the registers below, bit 6 events were lost
+//                   because the queue was full, bit 7 the interrupt is enabled.
+//                   A write sets the interrupt enable from bit 7, a set bit 6 clears the lost flag
+//   0x0241          type of the event (EVENTS)
+//   0x0242, 0x0243  code (lo, hi): GLFW key code, character or mouse button
+//   0x0244          modifiers, GLFW_MOD_* bits (shift 1, control 2, alt 4, super 8)
+//   0x0245, 0x0246  mouse position, 0 - 255 across the window
+//   0x0247          a write drops the event, the next one follows
+// The window pushes events from its GLFW callbacks into a single producer/single consumer ring,
+// nothing is polled. The emulation thread takes the next event only when a register is read or
+// the interrupt line is checked, and stamps it with the bus cycle. While an event is in the
+// registers and the interrupt is enabled the IRQ stays raised.
+// Like MailboxDevice the registers are handled at the time of the access, they aren't in memory.
+// With record() every delivered event is written to a file, replay() delivers the events of such
+// a file at the same cycles instead of the ones of the window, so a run can be repeated exactly.
+class InputDevice{
+public:
+    InputDevice();
+    ~InputDevice();
+
+    void ConnectBus(Bus* ptr) { bus = ptr; }
+
+    static const WORD START   = 0x0240;
+    static const WORD END     = 0x0247;
+    static const WORD STATUS  = 0x0240;
+    static const WORD NEXT    = 0x0247;
+
+    enum EVENTS{
+        None      = 0x00,
+        KeyDown   = 0x01,  // Also sent while the key repeats
+        KeyUp     = 0x02,
+        Char      = 0x03,  // Code is the Unicode character, cut to 16 bits
+        MouseDown = 0x04,  // Code is the button
+        MouseUp   = 0x05,
+        MouseMove = 0x06
+    };
+
+    struct EVENT{
+        unsigned long long hostNs;  // When it was pushed, steady clock
+        unsigned long long cycle;   // When it was delivered
+        BYTE type;
+        WORD code;
+        BYTE mods;
+        BYTE x, y;
+    };
+
+    // Called by the window or an embedder, from one thread at a time. Returns false if the queue
+    // is full, the event is lost then.
+    bool push(BYTE type, WORD code, BYTE mods = 0, BYTE x = 0, BYTE y = 0);
+
+    BYTE read(WORD addr);
+    void write(WORD addr, BYTE data);
+
+    // Drops the queued events and the one in the registers and disables the interrupt, used by
+    // Bus::restore(). A replay continues with the events from the restored cycle on.
+    void reset();
+
+    // Interrupt line, checked by the bus every cycle
+    bool irq(){
+        if(!enabled)
+            return false;
+        if(!present)
+            deliver();
+        return present;
+    }
+    // An event could be delivered now, the bus doesn't skip idle cycles then
+    bool waiting();
+    // Cycles until the next replayed event, 0 if there is none
+    unsigned long long pendingCycles();
+
+    // Return false if the file can't be opened
+    bool record(std::string path);
+    bool replay(std::string path);
+
+    // Events delivered, for Metrics
+    unsigned long long delivered = 0;
+
+private:
+    Bus* bus = nullptr;
+
+    static const size_t RING_SIZE = 256;        // Has to be a power of two
+    EVENT ring[RING_SIZE];
+    std::atomic<size_t> head{0};                // Next slot written by push()
+    std::atomic<size_t> tail{0};                // Next slot read by the emulation thread
+    std::atomic<bool> lost{false};
+
+    EVENT current = {};
+    bool present = false;
+    bool enabled = false;
+
+    FILE* recordFile = nullptr;
+    std::vector<EVENT> script;                  // Events of replay()
+    size_t scriptPosition = 0;
+    bool replaying = false;
+
+    void deliver();
+};
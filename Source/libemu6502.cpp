@@ -0,0 +1,155 @@
+#include "libemu6502.h"
+
+#include <algorithm>
+
+#include "bus.h"
+
+struct emu6502_machine{
+    Bus bus;
+    emu6502_machine(Bus::Layout layout) : bus(layout) {}
+    emu6502_machine(std::shared_ptr<const Bus::IMAGE> image) : bus(image) {}
+};
+
+struct emu6502_image{
+    std::shared_ptr<const Bus::IMAGE> image;
+};
+
+int emu6502_api_version(void){
+    return EMU6502_API_VERSION;
+}
+
+// No exception may leave through the C interface
+emu6502_machine* emu6502_create(int flat){
+    try{
+        return new emu6502_machine(flat ? Bus::Layout::Flat : Bus::Layout::Devices);
+    }
+    catch(...){
+        return nullptr;
+    }
+}
+
+void emu6502_destroy(emu6502_machine* machine){
+    delete machine;
+}
+
+emu6502_image* emu6502_share(emu6502_machine* machine){
+    try{
+        return new emu6502_image{ machine->bus.share() };
+    }
+    catch(...){
+        return nullptr;
+    }
+}
+
+emu6502_machine* emu6502_create_from(const emu6502_image* image){
+    try{
+        return new emu6502_machine(image->image);
+    }
+    catch(...){
+        return nullptr;
+    }
+}
+
+void emu6502_release(emu6502_image* image){
+    delete image;
+}
+
+long emu6502_load_file(emu6502_machine* machine, const char* path, uint16_t offset){
+    try{
+        return machine->bus.loadBinary(path, offset);
+    }
+    catch(...){
+        return -1;
+    }
+}
+
+void emu6502_load(emu6502_machine* machine, uint16_t offset, const uint8_t* data, size_t len){
+    machine->bus.load(offset, data, std::min<size_t>(len, 0x10000 - offset));
+}
+
+void emu6502_reset(emu6502_machine* machine){
+    machine->bus.cpu.reset();
+}
+
+uint64_t emu6502_run(emu6502_machine* machine, uint64_t cycles){
+    machine->bus.run(cycles);
+    return machine->bus.clockCount;
+}
+
+void emu6502_run_until_stop(emu6502_machine* machine, const emu6502_traps* traps, emu6502_stop* stop){
+    emu6502::TRAPS t;
+    t.illegalOpcode = traps->illegal_opcode;
+    t.brk = traps->brk;
+    t.selfLoop = traps->self_loop;
+    t.stackWrap = traps->stack_wrap;
+    t.exitWrite = traps->exit_write;
+    t.exitAddress = traps->exit_address;
+    t.maxCycles = traps->max_cycles;
+    t.maxInstructions = traps->max_instructions;
+    machine->bus.cpu.setTraps(t);
+
+    Bus::STOPINFO info = machine->bus.runUntilStop();
+    stop->reason = (int) info.reason;
+    stop->pc = info.pc;
+    stop->opcode = info.opcode;
+    stop->value = info.value;
+    stop->cycles = info.cycles;
+    stop->instructions = info.instructions;
+}
+
+uint64_t emu6502_cycles(emu6502_machine* machine){
+    return machine->bus.clockCount;
+}
+
+void emu6502_get_registers(emu6502_machine* machine, emu6502_registers* registers){
+    emu6502::STATE state = machine->bus.cpu.save();
+    registers->pc = state.PC;
+    registers->a = state.A;
+    registers->x = state.X;
+    registers->y = state.Y;
+    registers->sp = state.SP;
+    registers->p = state.status;
+}
+
+// Also clears a stop, the CPU continues at the new PC
+void emu6502_set_registers(emu6502_machine* machine, const emu6502_registers* registers){
+    emu6502::STATE state = machine->bus.cpu.save();
+    state.PC = registers->pc;
+    state.A = registers->a;
+    state.X = registers->x;
+    state.Y = registers->y;
+    state.SP = registers->sp;
+    state.status = registers->p;
+    machine->bus.cpu.load(state);
+}
+
+uint8_t* emu6502_memory(emu6502_machine* machine, uint16_t addr, size_t* len){
+    unsigned long size = 0;
+    BYTE* data = machine->bus.span(addr, size);
+    *len = size;
+    return data;
+}
+
+void emu6502_written(emu6502_machine* machine, uint16_t addr, size_t len){
+    machine->bus.written(addr, len);
+}
+
+uint8_t emu6502_read(emu6502_machine* machine, uint16_t addr){
+    return machine->bus.read(addr);
+}
+
+void emu6502_write(emu6502_machine* machine, uint16_t addr, uint8_t data){
+    machine->bus.write(addr, data);
+}
+
+int emu6502_input(emu6502_machine* machine, int type, uint16_t code, uint8_t mods, uint8_t x, uint8_t y){
+    return machine->bus.in.push(type, code, mods, x, y);
+}
+
+void emu6502_checkpoint(emu6502_machine* machine){
+    machine->bus.checkpoint();
+}
+
+void emu6502_restore(emu6502_machine* machine){
+    machine->bus.restore();
+}
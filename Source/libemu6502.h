@@ -0,0 +1,129 @@
+/* C interface of the emulator, built as Build/libemu6502.a and Build/libemu6502.so (make lib).
+ * A machine is a headless bus with its CPU and devices. Machines are independent, but one
+ * machine must not be used by two threads at the same time.
+ * The header is plain C, so it can be used from cgo, ctypes/cffi and other FFIs. */
+#ifndef LIBEMU6502_H
+#define LIBEMU6502_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EMU6502_API_VERSION 2
+
+/* The library is built with hidden visibility, only these functions are exported */
+#if defined(__GNUC__)
+#define EMU6502_EXPORT __attribute__((visibility("default")))
+#else
+#define EMU6502_EXPORT
+#endif
+
+typedef struct emu6502_machine emu6502_machine;
+/* Memory shared by several machines, see Bus::IMAGE */
+typedef struct emu6502_image emu6502_image;
+
+typedef struct emu6502_registers{
+    uint16_t pc;
+    uint8_t a, x, y, sp;
+    uint8_t p;                      /* NV-BDIZC */
+} emu6502_registers;
+
+/* Flags are 0 or 1, a budget of 0 is unlimited */
+typedef struct emu6502_traps{
+    uint8_t illegal_opcode;
+    uint8_t brk;
+    uint8_t self_loop;
+    uint8_t stack_wrap;
+    uint8_t exit_write;
+    uint16_t exit_address;
+    uint64_t max_cycles;
+    uint64_t max_instructions;
+} emu6502_traps;
+
+/* Values of emu6502_stop.reason */
+enum{
+    EMU6502_STOP_NONE,
+    EMU6502_STOP_ILLEGAL_OPCODE,
+    EMU6502_STOP_BREAK,
+    EMU6502_STOP_SELF_LOOP,
+    EMU6502_STOP_EXIT_WRITE,
+    EMU6502_STOP_STACK_WRAP,
+    EMU6502_STOP_CYCLE_BUDGET,
+    EMU6502_STOP_INSTRUCTION_BUDGET,
+    EMU6502_STOP_TERMINATED
+};
+
+typedef struct emu6502_stop{
+    int reason;
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t value;                  /* Written to the exit address */
+    uint64_t cycles;
+    uint64_t instructions;
+} emu6502_stop;
+
+EMU6502_EXPORT int emu6502_api_version(void);
+
+/* flat: 0 for the device layout, 1 for 64kB of plain RAM. NULL if out of memory. */
+EMU6502_EXPORT emu6502_machine* emu6502_create(int flat);
+EMU6502_EXPORT void emu6502_destroy(emu6502_machine* machine);
+
+/* Takes the memory of a machine as an image. Machines created from it share its pages until
+ * they write to them, so they only own the pages they change. The image can be released while
+ * machines still use it. */
+EMU6502_EXPORT emu6502_image* emu6502_share(emu6502_machine* machine);
+EMU6502_EXPORT emu6502_machine* emu6502_create_from(const emu6502_image* image);
+EMU6502_EXPORT void emu6502_release(emu6502_image* image);
+
+/* Returns the number of bytes loaded, -1 if the file can't be read */
+EMU6502_EXPORT long emu6502_load_file(emu6502_machine* machine, const char* path, uint16_t offset);
+/* Like a series of writes, the end is cut off at 0xFFFF */
+EMU6502_EXPORT void emu6502_load(emu6502_machine* machine, uint16_t offset, const uint8_t* data, size_t len);
+
+EMU6502_EXPORT void emu6502_reset(emu6502_machine* machine);
+/* Runs a number of cycles, idle loops are skipped. Returns the cycle count of the machine. */
+EMU6502_EXPORT uint64_t emu6502_run(emu6502_machine* machine, uint64_t cycles);
+/* Runs until a trap fires or a budget is used up, the budgets count from the call on */
+EMU6502_EXPORT void emu6502_run_until_stop(emu6502_machine* machine, const emu6502_traps* traps, emu6502_stop* stop);
+EMU6502_EXPORT uint64_t emu6502_cycles(emu6502_machine* machine);
+
+EMU6502_EXPORT void emu6502_get_registers(emu6502_machine* machine, emu6502_registers* registers);
+EMU6502_EXPORT void emu6502_set_registers(emu6502_machine* machine, const emu6502_registers* registers);
+
+/* Pointer to the memory at addr, *len is set to the number of bytes which may be accessed
+ * through it. NULL (and *len 0) if nothing is mapped at addr. The pointer stays valid until the
+ * machine is destroyed. Device registers and the mailbox aren't plain memory, writes through
+ * the pointer don't trigger any device. */
+EMU6502_EXPORT uint8_t* emu6502_memory(emu6502_machine* machine, uint16_t addr, size_t* len);
+/* Has to be called after writing through the pointer, so checkpoints and the idle detection
+ * notice the change */
+EMU6502_EXPORT void emu6502_written(emu6502_machine* machine, uint16_t addr, size_t len);
+EMU6502_EXPORT uint8_t emu6502_read(emu6502_machine* machine, uint16_t addr);
+EMU6502_EXPORT void emu6502_write(emu6502_machine* machine, uint16_t addr, uint8_t data);
+
+/* Values of the type of emu6502_input(), see Source/inputDevice.h */
+enum{
+    EMU6502_INPUT_KEY_DOWN = 1,
+    EMU6502_INPUT_KEY_UP,
+    EMU6502_INPUT_CHAR,
+    EMU6502_INPUT_MOUSE_DOWN,
+    EMU6502_INPUT_MOUSE_UP,
+    EMU6502_INPUT_MOUSE_MOVE
+};
+
+/* Queues an input event for the machine. Unlike the other functions it may be called from another
+ * thread while the machine runs, by one thread at a time. Returns 0 if the queue is full. */
+EMU6502_EXPORT int emu6502_input(emu6502_machine* machine, int type, uint16_t code, uint8_t mods, uint8_t x, uint8_t y);
+
+/* See Bus::checkpoint() and Bus::restore() */
+EMU6502_EXPORT void emu6502_checkpoint(emu6502_machine* machine);
+EMU6502_EXPORT void emu6502_restore(emu6502_machine* machine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
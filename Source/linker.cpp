@@ -0,0 +1,144 @@
+#include "linker.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+void Linker::place(const std::string& section, WORD address){
+    bases[section] = address;
+}
+
+Linker::IMAGE Linker::link(const std::vector<OBJECT>& objects){
+    IMAGE image;
+
+    // Address of every section of every object
+    std::vector<std::vector<long>> addresses(objects.size());
+    std::vector<std::string> order;
+    for(size_t o = 0; o < objects.size(); o++){
+        for(const OBJECT::SECTION& section : objects[o].sections){
+            addresses[o].push_back(section.org);
+            if(section.org < 0 && std::find(order.begin(), order.end(), section.name) == order.end())
+                order.push_back(section.name);
+        }
+    }
+    long cursor = DEFAULT_BASE;
+    for(const std::string& name : order){
+        if(bases.count(name))
+            cursor = bases[name];
+        for(size_t o = 0; o < objects.size(); o++){
+            for(size_t s = 0; s < objects[o].sections.size(); s++){
+                const OBJECT::SECTION& section = objects[o].sections[s];
+                if(section.org >= 0 || section.name != name)
+                    continue;
+                addresses[o][s] = cursor;
+                cursor += section.data.size();
+                if(cursor > 0x10000)
+                    throw std::invalid_argument{"section " + name + " of " + objects[o].source + " doesn't fit into the address space"};
+            }
+        }
+    }
+
+    long low = 0x10000, high = 0;
+    for(size_t o = 0; o < objects.size(); o++){
+        for(size_t s = 0; s < objects[o].sections.size(); s++){
+            unsigned size = objects[o].sections[s].data.size();
+            if(size == 0)
+                continue;
+            image.placements.push_back({objects[o].sections[s].name, objects[o].source, (WORD) addresses[o][s], size});
+            low = std::min(low, addresses[o][s]);
+            high = std::max(high, addresses[o][s] + (long) size);
+        }
+    }
+    std::sort(image.placements.begin(), image.placements.end(), [](const PLACEMENT& a, const PLACEMENT& b){ return a.address < b.address; });
+    for(size_t i = 1; i < image.placements.size(); i++){
+        const PLACEMENT& a = image.placements[i - 1];
+        const PLACEMENT& b = image.placements[i];
+        if(a.address + a.size > b.address)
+            throw std::invalid_argument{"section " + a.section + " of " + a.source + " overlaps " + b.section + " of " + b.source};
+    }
+
+    // Exported symbols, a constant may be defined by several files if the value is the same
+    std::map<std::string, std::pair<bool, std::string>> origins;
+    for(size_t o = 0; o < objects.size(); o++){
+        for(const OBJECT::SYMBOL& symbol : objects[o].symbols){
+            if(!symbol.exported)
+                continue;
+            long value = symbol.section >= 0 ? addresses[o][symbol.section] + symbol.value : symbol.value;
+            auto known = origins.find(symbol.name);
+            if(known != origins.end()){
+                bool constants = symbol.section < 0 && known->second.first;
+                if(!constants || image.symbols[symbol.name] != value)
+                    throw std::invalid_argument{symbol.name + " defined in " + known->second.second + " and " + objects[o].source};
+                continue;
+            }
+            origins[symbol.name] = {symbol.section < 0, objects[o].source};
+            image.symbols[symbol.name] = value;
+        }
+    }
+
+    if(low < high){
+        image.start = low;
+        image.data.assign(high - low, 0);
+    }
+    for(size_t o = 0; o < objects.size(); o++){
+        for(size_t s = 0; s < objects[o].sections.size(); s++){
+            const std::vector<BYTE>& data = objects[o].sections[s].data;
+            std::copy(data.begin(), data.end(), image.data.begin() + (addresses[o][s] - low));
+        }
+    }
+
+    for(size_t o = 0; o < objects.size(); o++){
+        for(const OBJECT::LINE& line : objects[o].lines)
+            image.lines[addresses[o][line.section] + line.offset] = line.where;
+        for(const OBJECT::SYMBOL& symbol : objects[o].symbols){
+            if(symbol.section >= 0)
+                image.labels.emplace(addresses[o][symbol.section] + symbol.value, symbol.name);
+        }
+    }
+
+    for(size_t o = 0; o < objects.size(); o++){
+        for(const OBJECT::RELOCATION& relocation : objects[o].relocations){
+            long value = relocation.addend;
+            if(!relocation.symbol.empty()){
+                auto symbol = image.symbols.find(relocation.symbol);
+                if(symbol == image.symbols.end())
+                    throw std::invalid_argument{"undefined symbol " + relocation.symbol + " in " + objects[o].source};
+                value += symbol->second;
+            }
+            else if(relocation.target >= 0)
+                value += addresses[o][relocation.target];
+
+            long address = addresses[o][relocation.section] + relocation.offset;
+            BYTE* at = &image.data[address - low];
+            auto check = [&](long min, long max, const char* what){
+                if(value < min || value > max)
+                    throw std::invalid_argument{what + std::string(" out of range in ") + objects[o].source + " (" +
+                        (relocation.symbol.empty() ? "" : relocation.symbol + ", ") + std::to_string(value) + ")"};
+            };
+            switch(relocation.kind){
+                case OBJECT::RelocWord:
+                    check(-0x8000, 0xFFFF, "word");
+                    at[0] = value & 0xFF;
+                    at[1] = (value >> 8) & 0xFF;
+                break;
+                case OBJECT::RelocByte:
+                    check(-128, 0xFF, "byte");
+                    at[0] = value & 0xFF;
+                break;
+                case OBJECT::RelocLow:
+                    at[0] = value & 0xFF;
+                break;
+                case OBJECT::RelocHigh:
+                    at[0] = (value >> 8) & 0xFF;
+                break;
+                case OBJECT::RelocBranch:
+                    value -= address + 1;
+                    check(-128, 127, "branch distance");
+                    at[0] = value & 0xFF;
+                break;
+                default:
+                    throw std::invalid_argument{"unknown relocation in " + objects[o].source};
+            }
+        }
+    }
+    return image;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "objectFile.h"
+
+// Combines the objects of SourceAssembler into one program image. Sections without a fixed
+// address are placed one after the other: all "code" sections of the objects in their order,
+// then the next section name, and so on. A base set with place() moves a section name (and
+// the ones following it) to that address. Then the symbols are resolved and the relocations
+// patched. Errors throw std::invalid_argument.
+class Linker{
+public:
+    void place(const std::string& section, WORD address);
+
+    struct PLACEMENT{
+        std::string section;
+        std::string source;
+        WORD address;
+        unsigned size;
+    };
+
+    struct IMAGE{
+        WORD start = 0;                     // Address of data[0]
+        std::vector<BYTE> data;             // Gaps between the sections are zero
+        std::map<std::string, long> symbols;
+        std::map<WORD, std::string> labels; // Labels of the objects by address, local ones too
+        std::map<WORD, std::string> lines;  // Source line of every instruction
+        std::vector<PLACEMENT> placements;
+    };
+
+    IMAGE link(const std::vector<OBJECT>& objects);
+
+    static const WORD DEFAULT_BASE = 0x2000;
+
+private:
+    std::map<std::string, WORD> bases;
+};
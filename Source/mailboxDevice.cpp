@@ -0,0 +1,35 @@
+#include "mailboxDevice.h"
+
+thread_local BYTE MailboxDevice::core = 0;
+
+MailboxDevice::MailboxDevice(){
+    reset();
+}
+
+void MailboxDevice::reset(){
+    for(std::atomic<BYTE>& slot : slots)
+        slot.store(0, std::memory_order_relaxed);
+    pending.store(0, std::memory_order_relaxed);
+}
+
+MailboxDevice::~MailboxDevice(){
+    // Does nothing
+}
+
+BYTE MailboxDevice::read(WORD addr){
+    if(addr < START + MAX_CORES)
+        return slots[addr - START].load(std::memory_order_acquire);
+    if(addr == 0x0708)
+        return pending.load(std::memory_order_acquire);
+    return core;
+}
+
+void MailboxDevice::write(WORD addr, BYTE data){
+    // The message is visible before the interrupt is
+    if(addr < START + MAX_CORES){
+        slots[addr - START].store(data, std::memory_order_relaxed);
+        pending.fetch_or(1 << (addr - START), std::memory_order_release);
+    }
+    else if(addr == 0x0708)
+        pending.fetch_and(~data, std::memory_order_acq_rel);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+
+#include "datatypes.h"
+
+// Signals between the cores of a MultiCore machine.
+// Registers (0x0700 - 0x0709):
+//   0x0700 - 0x0707  message slot of core 0 - 7, a write raises the interrupt of that core
+//   0x0708          pending mask, bit n is the interrupt line of core n. Writing clears the set bits
+//   0x0709          number of the core which reads it
+// The cores run on different host threads, so the registers are handled at the time of the
+// access through read() and write() instead of being polled in a clock(), and are atomics.
+class MailboxDevice{
+public:
+    MailboxDevice();
+    ~MailboxDevice();
+
+    static const WORD START = 0x0700;
+    static const WORD END   = 0x0709;
+    static const unsigned MAX_CORES = 8;
+
+    BYTE read(WORD addr);
+    void write(WORD addr, BYTE data);
+
+    // Clears the slots and the interrupt lines, used by Bus::restore()
+    void reset();
+
+    // Interrupt line of a core
+    bool irq(unsigned core) { return pending.load(std::memory_order_relaxed) & (1 << core); }
+
+    // Number of the core driven by the calling thread, set by MultiCore
+    static thread_local BYTE core;
+
+private:
+    std::atomic<BYTE> slots[MAX_CORES];
+    std::atomic<BYTE> pending{0};
+};
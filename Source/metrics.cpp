@@ -0,0 +1,137 @@
+#include "metrics.h"
+#include "bus.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+Metrics::Metrics(Bus* bus, const char* name, double frequency) : frequency(frequency), bus(bus){
+    if(name)
+        snprintf(this->name, sizeof(this->name), "%s", name);
+    else
+        snprintf(this->name, sizeof(this->name), "/emu6502-%d", (int) getpid());
+    startNs = lastNs = now();
+    lastCycles = bus->clockCount;
+    attach(bus->cpu);
+
+    // The page of another emulator would be written by both
+    int fd = shm_open(this->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0)
+        return;
+    if(ftruncate(fd, sizeof(PAGE)) == 0){
+        void* data = mmap(nullptr, sizeof(PAGE), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(data != MAP_FAILED){
+            page = (PAGE*) data;
+            memset((void*) page, 0, sizeof(PAGE));
+            page->magic = MAGIC;
+            page->version = VERSION;
+        }
+    }
+    close(fd);
+    if(!page)
+        shm_unlink(this->name);
+}
+
+Metrics::~Metrics(){
+    for(unsigned i = 0; i < cpuCount; i++)
+        cpus[i]->counters = nullptr;
+    if(page){
+        munmap(page, sizeof(PAGE));
+        shm_unlink(name);
+    }
+}
+
+void Metrics::attach(emu6502Base& cpu){
+    if(cpuCount == MAX_CPUS)
+        return;
+    cpus[cpuCount] = &cpu;
+    cpu.counters = &counters[cpuCount];
+    cpuCount++;
+}
+
+long long Metrics::now(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// The fields are stored as relaxed atomics, a reader may map the page at any time
+static void store(uint64_t& field, uint64_t value){
+    std::atomic_ref<uint64_t>(field).store(value, std::memory_order_relaxed);
+}
+
+void Metrics::publish(){
+    if(!page)
+        return;
+
+    long long t = now();
+    unsigned long long cycles = bus->clockCount;
+    uint64_t nsPerSecond = 0;
+    if(cycles > lastCycles)
+        nsPerSecond = (t - lastNs) * frequency / (cycles - lastCycles);
+    lastNs = t;
+    lastCycles = cycles;
+
+    uint64_t sequence = page->sequence.load(std::memory_order_relaxed);
+    page->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    unsigned long long instructions = 0;
+    for(unsigned i = 0; i < cpuCount; i++)
+        instructions += cpus[i]->instructions;
+    store(page->publishes, sequence / 2 + 1);
+    store(page->instructions, instructions);
+    store(page->cycles, cycles);
+    store(page->hostNs, t - startNs);
+    store(page->hostNsPerSecond, nsPerSecond);
+    store(page->drawCommands, bus->dd.commands);
+    store(page->frames, bus->dd.frames());
+    store(page->bitmapRows, bus->vd.rows);
+    store(page->inputEvents, bus->in.delivered);
+    store(page->deviceResumes, bus->scheduler.resumes);
+    for(unsigned r = 0; r < REGION_COUNT; r++){
+        unsigned long long reads = 0, writes = 0;
+        for(unsigned i = 0; i < cpuCount; i++){
+            reads += counters[i].reads[r];
+            writes += counters[i].writes[r];
+        }
+        store(page->reads[r], reads);
+        store(page->writes[r], writes);
+    }
+    for(unsigned op = 0; op < 256; op++){
+        unsigned long long count = 0;
+        for(unsigned i = 0; i < cpuCount; i++)
+            count += counters[i].opcodes[op];
+        store(page->opcodes[op], count);
+    }
+
+    page->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool Metrics::read(const PAGE* page, PAGE& copy){
+    for(int attempt = 0; attempt < 1000; attempt++){
+        uint64_t before = page->sequence.load(std::memory_order_acquire);
+        if(before & 1)
+            continue;
+        const uint64_t* from = (const uint64_t*) &page->publishes;
+        uint64_t* to = (uint64_t*) &copy.publishes;
+        unsigned fields = (sizeof(PAGE) - offsetof(PAGE, publishes)) / sizeof(uint64_t);
+        for(unsigned i = 0; i < fields; i++)
+            to[i] = std::atomic_ref<uint64_t>(const_cast<uint64_t&>(from[i])).load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(page->sequence.load(std::memory_order_relaxed) == before){
+            copy.magic = page->magic;
+            copy.version = page->version;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Metrics::regionName(unsigned region){
+    static const char* names[REGION_COUNT] = { "ram", "stack", "zeropage", "odRAM", "ddRAM", "dmaRAM", "mailbox", "dlRAM", "mmu", "vdRAM", "input", "timer", "unmapped" };
+    return region < REGION_COUNT ? names[region] : "";
+}
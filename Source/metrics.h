@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#include "datatypes.h"
+
+class Bus;
+class emu6502Base;
+
+// Regions of the address space, as laid out in Bus
+enum REGIONS{
+    RegionRam,          // 0x1000 - 0xFFFF
+    RegionStack,        // 0x0100 - 0x01FF
+    RegionZeroPage,     // 0x0000 - 0x00FF
+    RegionOdRAM,        // 0x0400 - 0x0404
+    RegionDdRAM,        // 0x0500 - 0x0502
+    RegionDmaRAM,       // 0x0600 - 0x0608
+    RegionMailbox,      // 0x0700 - 0x0709
+    RegionDlRAM,        // 0x0800 - 0x0FFF
+    RegionMmu,          // 0x0300 - 0x031F
+    RegionVdRAM,        // 0x0200 - 0x0230
+    RegionInput,        // 0x0240 - 0x0247
+    RegionTimer,        // 0x0250 - 0x0253
+    RegionUnmapped,
+    REGION_COUNT
+};
+
+inline BYTE regionOf(WORD addr){
+    if(addr >= 0x1000) return RegionRam;
+    if(addr >= 0x0800) return RegionDlRAM;
+    if(addr <= 0x00FF) return RegionZeroPage;
+    if(addr <= 0x01FF) return RegionStack;
+    switch(addr >> 8){
+        case 0x02: return addr <= 0x0230 ? RegionVdRAM
+                        : (addr >= 0x0240 && addr <= 0x0247) ? RegionInput
+                        : (addr >= 0x0250 && addr <= 0x0253) ? RegionTimer : RegionUnmapped;
+        case 0x03: return addr <= 0x031F ? RegionMmu : RegionUnmapped;
+        case 0x04: return addr <= 0x0404 ? RegionOdRAM : RegionUnmapped;
+        case 0x05: return addr <= 0x0502 ? RegionDdRAM : RegionUnmapped;
+        case 0x06: return addr <= 0x0608 ? RegionDmaRAM : RegionUnmapped;
+        case 0x07: return addr <= 0x0709 ? RegionMailbox : RegionUnmapped;
+    }
+    return RegionUnmapped;
+}
+
+// Counters of one CPU, only written by the thread which runs it
+struct CPU_COUNTERS{
+    unsigned long long opcodes[256] = {};
+    unsigned long long reads[REGION_COUNT] = {};
+    unsigned long long writes[REGION_COUNT] = {};
+};
+
+// Live statistics of a bus, published into a shared memory object (/dev/shm/<name>) which
+// other processes can map and read while the emulation runs (Tools/stats.cpp).
+// Counting stays on the emulation threads: every CPU gets its own CPU_COUNTERS, which only
+// costs an increment per instruction and access. publish() adds them up and copies the totals
+// into the page under a seqlock. It has to be called from the thread which runs the bus,
+// between two runs, e.g. after every slice of the Pacer.
+// Each emulator needs its own object, the default name is /emu6502-<pid>. An object which
+// exists already isn't taken over.
+class Metrics{
+public:
+    Metrics(Bus* bus, const char* name = nullptr, double frequency = 1000000.0);
+    ~Metrics();
+
+    // False if the shared memory couldn't be created, publish() does nothing then
+    bool open() { return page != nullptr; }
+    const char* getName() { return name; }
+
+    // Starts counting the instructions and accesses of a CPU (bus->cpu is attached already)
+    void attach(emu6502Base& cpu);
+    void publish();
+
+    // Clock rate the host time is compared with
+    double frequency;
+
+    // Layout of the shared page. The sequence is odd while it is written, a reader copies the
+    // page and retries if the sequence was odd or has changed meanwhile.
+    static const uint32_t MAGIC = 0x36353032;   // "6502"
+    static const uint32_t VERSION = 4;
+    struct PAGE{
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint64_t> sequence;
+        uint64_t publishes;
+        uint64_t instructions;
+        uint64_t cycles;
+        uint64_t hostNs;                    // Since the Metrics were created
+        uint64_t hostNsPerSecond;           // Host time per emulated second, since the last publish
+        uint64_t drawCommands;              // Handled by DrawingDevice
+        uint64_t frames;                    // Presented by OpenGLDevice
+        uint64_t bitmapRows;                // Converted by VideoDevice
+        uint64_t inputEvents;               // Delivered by InputDevice
+        uint64_t deviceResumes;             // Of the coroutine devices
+        uint64_t reads[REGION_COUNT];
+        uint64_t writes[REGION_COUNT];
+        uint64_t opcodes[256];
+    };
+    static const char* regionName(unsigned region);
+
+    // Copies the page of another process, returns false if it isn't consistent after a few tries
+    static bool read(const PAGE* page, PAGE& copy);
+
+private:
+    Bus* bus;
+    char name[64];
+    PAGE* page = nullptr;
+
+    // Per-CPU counters, in the order of attach()
+    static const unsigned MAX_CPUS = 8;
+    CPU_COUNTERS counters[MAX_CPUS];
+    emu6502Base* cpus[MAX_CPUS] = {};
+    unsigned cpuCount = 0;
+
+    long long startNs;
+    long long lastNs;
+    unsigned long long lastCycles = 0;
+    static long long now();
+};
@@ -0,0 +1,71 @@
+#include "mmuDevice.h"
+#include "bus.h"
+
+#include <string.h>
+
+MmuDevice::MmuDevice(){
+    for(WORD& bank : registers)
+        bank = NONE;
+}
+
+MmuDevice::~MmuDevice(){
+    // Does nothing
+}
+
+void MmuDevice::configure(unsigned size, unsigned ram, const std::vector<BYTE>& rom){
+    for(unsigned window = 1; window < windows(); window++)
+        map(window, NONE);
+
+    windowSize = size == 0x2000 ? 0x2000 : 0x1000;
+    ramBanks = ram;
+    unsigned romBanks = (rom.size() + windowSize - 1) / windowSize;
+    store.assign((ramBanks + romBanks) * windowSize, 0x00);
+    if(!rom.empty())
+        memcpy(store.data() + ramBanks * windowSize, rom.data(), rom.size());
+}
+
+BYTE* MmuDevice::data(WORD bank){
+    if(bank >= banks())
+        return nullptr;
+    return store.data() + bank * windowSize;
+}
+
+// Points every page of the window to the bank, a switch costs 16 or 32 pointer stores
+void MmuDevice::map(unsigned window, WORD bank){
+    if(window == 0 || window >= windows())
+        return;
+    registers[window] = bank;
+    unsigned pages = windowSize / 256;
+    bus->mapPages(window * pages, pages, data(bank), bank < ramBanks);
+}
+
+BYTE MmuDevice::read(WORD addr){
+    unsigned window = (addr - START) >> 1;
+    if(window >= windows())
+        return 0x00;
+    return (addr & 1) ? registers[window] >> 8 : registers[window] & 0xFF;
+}
+
+void MmuDevice::write(WORD addr, BYTE data){
+    if(bus->shared){
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.emplace_back(addr, data);
+        return;
+    }
+    setRegister(addr, data);
+}
+
+void MmuDevice::applyQueued(){
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for(const std::pair<WORD, BYTE>& entry : queue)
+        setRegister(entry.first, entry.second);
+    queue.clear();
+}
+
+void MmuDevice::setRegister(WORD addr, BYTE data){
+    unsigned window = (addr - START) >> 1;
+    if(window >= windows())
+        return;
+    WORD bank = (addr & 1) ? (registers[window] & 0x00FF) | (data << 8) : (registers[window] & 0xFF00) | data;
+    map(window, bank);
+}
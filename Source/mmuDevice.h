@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <utility>
+
+#include "datatypes.h"
+
+class Bus;
+
+// Maps windows of the address space onto a backing store larger than 64kB.
+// The store is cut into banks of the window size (4kB or 8kB). The first ramBanks banks are RAM,
+// the ROM image follows them, its banks ignore writes.
+// Registers (0x0300 - 0x031F):
+//   0x0300 + 2n, 0x0301 + 2n  bank of window n (lo, hi), 0xFFFF (or any bank which doesn't
+//                             exist) maps the RAM of the bus back into the window
+// Window 0 holds the zero page, the stack and the device registers, it can't be switched.
+// A register write switches the window at once: the pages of the window in the page map of the
+// bus are pointed to the bank, nothing is copied. While several cores run (MultiCore) the other
+// cores read the page map, so the writes are queued and take effect at the end of the quantum.
+class MmuDevice{
+public:
+    MmuDevice();
+    ~MmuDevice();
+
+    void ConnectBus(Bus* ptr) { bus = ptr; }
+
+    static const WORD START = 0x0300;
+    static const WORD END   = 0x031F;
+    static const WORD NONE  = 0xFFFF;
+
+    // Allocates the banks and maps the RAM of the bus into all windows. Without it, the
+    // registers don't respond.
+    void configure(unsigned windowSize, unsigned ramBanks, const std::vector<BYTE>& rom = {});
+    bool enabled() { return !store.empty(); }
+
+    unsigned windows() { return 0x10000 / windowSize; }
+    unsigned banks() { return store.size() / windowSize; }
+    unsigned size() { return windowSize; }
+
+    void map(unsigned window, WORD bank);
+    WORD bank(unsigned window) { return registers[window]; }
+    // Contents of a bank, nullptr if it doesn't exist
+    BYTE* data(WORD bank);
+
+    BYTE read(WORD addr);
+    void write(WORD addr, BYTE data);
+
+    // Carries out the queued register writes, called by MultiCore while only core 0 runs
+    void applyQueued();
+
+private:
+    Bus* bus = nullptr;
+
+    std::vector<BYTE> store;
+    unsigned windowSize = 0x1000;
+    unsigned ramBanks = 0;
+    WORD registers[16];
+
+    void setRegister(WORD addr, BYTE data);
+
+    std::mutex queueMutex;
+    std::vector<std::pair<WORD, BYTE>> queue;
+};
@@ -0,0 +1,77 @@
+#include "multiCore.h"
+#include "bus.h"
+
+#include <algorithm>
+
+MultiCore::MultiCore(Bus* bus, unsigned cores, bool privatePages, unsigned long quantum)
+    : quantum(quantum), bus(bus), cores(std::clamp(cores, 1u, MailboxDevice::MAX_CORES)), barrier(this->cores){
+    for(unsigned n = 1; n < this->cores; n++){
+        others.push_back(std::make_unique<emu6502>());
+        others.back()->ConnectBus(bus);
+    }
+    if(privatePages){
+        pages.resize(this->cores, std::vector<BYTE>(0x0200, 0x00));
+        for(unsigned n = 0; n < this->cores; n++)
+            core(n).local = pages[n].data();
+    }
+
+    // A shared page would be copied by the core which writes it first, while the others read it
+    if(this->cores > 1)
+        bus->detach();
+    bus->shared = this->cores > 1;
+    for(unsigned n = 1; n < this->cores; n++)
+        threads.emplace_back(&MultiCore::worker, this, n);
+}
+
+MultiCore::~MultiCore(){
+    // Releasing the workers from the barrier which starts the next quantum
+    stopping = true;
+    if(!threads.empty())
+        barrier.arrive_and_wait();
+    for(std::thread& thread : threads)
+        thread.join();
+
+    bus->shared = false;
+    bus->cpu.local = nullptr;
+}
+
+emu6502& MultiCore::core(unsigned n){
+    return n == 0 ? bus->cpu : *others[n - 1];
+}
+
+void MultiCore::reset(){
+    for(unsigned n = 0; n < cores; n++)
+        core(n).reset();
+}
+
+void MultiCore::run(unsigned long long cycles){
+    unsigned long long end = bus->clockCount + cycles;
+    while(bus->clockCount < end && !bus->shouldTerminate()){
+        slice = std::min<unsigned long long>(quantum, end - bus->clockCount);
+
+        barrier.arrive_and_wait();  // Start of the quantum
+        unsigned long long sliceEnd = bus->clockCount + slice;
+        while(bus->clockCount < sliceEnd)
+            bus->clock();
+        barrier.arrive_and_wait();  // End of the quantum
+        // The workers wait for the next quantum, the page map can be changed now
+        bus->mmu.applyQueued();
+    }
+}
+
+void MultiCore::worker(unsigned n){
+    MailboxDevice::core = n;
+    emu6502& cpu = core(n);
+
+    while(true){
+        barrier.arrive_and_wait();
+        if(stopping)
+            return;
+        for(unsigned long i = 0; i < slice; i++){
+            if(bus->mb.irq(n) && cpu.completed())
+                cpu.irq();
+            cpu.clock();
+        }
+        barrier.arrive_and_wait();
+    }
+}
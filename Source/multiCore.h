@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <barrier>
+
+#include "datatypes.h"
+#include "emu6502.h"
+
+class Bus;
+
+// Runs several CPU cores on one bus. Core 0 is bus->cpu, it runs on the calling thread
+// together with the devices. Every other core gets a host thread of its own.
+// The cores are synchronized conservatively: all of them execute one quantum of cycles and
+// wait for each other at a barrier before the next one starts. So no core gets ahead by more
+// than a quantum, and the writes of a core are visible to the others at the latest at the
+// next boundary. Smaller quanta are closer to lockstep, larger ones scale better.
+// The cores signal each other through the mailbox (bus->mb), which also drives their
+// interrupt lines. DMA transfers only stall core 0, MMU switches take effect at the end of
+// the quantum.
+class MultiCore{
+public:
+    // With privatePages every core has its own zero page and stack
+    MultiCore(Bus* bus, unsigned cores, bool privatePages = false, unsigned long quantum = 1000);
+    ~MultiCore();
+
+    unsigned count() { return cores; }
+    emu6502& core(unsigned n);
+
+    void reset();
+    // Runs all cores for a number of cycles, in quanta
+    void run(unsigned long long cycles);
+
+    unsigned long quantum;
+
+private:
+    Bus* bus;
+    unsigned cores;
+    std::vector<std::unique_ptr<emu6502>> others;
+    std::vector<std::vector<BYTE>> pages;
+    std::vector<std::thread> threads;
+    std::barrier<> barrier;
+
+    // Written by run() before the barrier which starts a quantum
+    unsigned long slice = 0;
+    bool stopping = false;
+
+    void worker(unsigned n);
+};
@@ -0,0 +1,128 @@
+#include "objectFile.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+unsigned long long contentHash(const std::string& data, unsigned long long hash){
+    for(unsigned char c : data){
+        hash ^= c;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+bool readFile(const std::string& path, std::string& content){
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+        return false;
+    std::stringstream data;
+    data << file.rdbuf();
+    content = data.str();
+    return true;
+}
+
+bool OBJECT::upToDate() const{
+    std::string content;
+    for(const DEPENDENCY& dependency : dependencies){
+        if(!readFile(dependency.path, content) || contentHash(content) != dependency.hash)
+            return false;
+    }
+    return true;
+}
+
+// Names and paths are written last on their line, so they may contain spaces
+bool OBJECT::save(const std::string& path) const{
+    std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "w");
+    if(!file)
+        return false;
+
+    fprintf(file, "emu6502-object %d\n", VERSION);
+    fprintf(file, "source %s\n", source.c_str());
+    for(const DEPENDENCY& dependency : dependencies)
+        fprintf(file, "dep %016llx %s\n", dependency.hash, dependency.path.c_str());
+    for(const SECTION& section : sections){
+        fprintf(file, "section %ld %zu %s\n", section.org, section.data.size(), section.name.c_str());
+        for(size_t i = 0; i < section.data.size(); i++)
+            fprintf(file, "%02X%s", section.data[i], (i % 32 == 31 || i + 1 == section.data.size()) ? "\n" : "");
+    }
+    for(const SYMBOL& symbol : symbols)
+        fprintf(file, "sym %d %ld %d %s\n", symbol.section, symbol.value, symbol.exported, symbol.name.c_str());
+    for(const RELOCATION& relocation : relocations)
+        fprintf(file, "reloc %d %u %d %d %ld %s\n", relocation.section, relocation.offset, relocation.kind,
+            relocation.target, relocation.addend, relocation.symbol.c_str());
+    for(const LINE& line : lines)
+        fprintf(file, "line %d %u %s\n", line.section, line.offset, line.where.c_str());
+
+    bool ok = !ferror(file);
+    fclose(file);
+    // Renamed into place, so an interrupted build never leaves half an object in the cache
+    return ok && rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool OBJECT::load(const std::string& path){
+    std::ifstream file(path);
+    std::string line, record;
+    int version = 0;
+    if(!std::getline(file, line) || sscanf(line.c_str(), "emu6502-object %d", &version) != 1 || version != VERSION)
+        return false;
+
+    *this = OBJECT();
+    auto rest = [](std::istringstream& in){
+        std::string text;
+        if(!(in >> std::ws).eof())
+            std::getline(in, text);
+        return text;
+    };
+    while(std::getline(file, line)){
+        std::istringstream in(line);
+        in >> record;
+        if(record == "source")
+            source = rest(in);
+        else if(record == "dep"){
+            DEPENDENCY dependency;
+            in >> std::hex >> dependency.hash >> std::dec;
+            dependency.path = rest(in);
+            dependencies.push_back(dependency);
+        }
+        else if(record == "section"){
+            SECTION section;
+            size_t size = 0;
+            in >> section.org >> size;
+            section.name = rest(in);
+            while(section.data.size() < size && std::getline(file, line)){
+                for(size_t i = 0; i + 1 < line.size(); i += 2)
+                    section.data.push_back(std::stoi(line.substr(i, 2), nullptr, 16));
+            }
+            if(section.data.size() != size)
+                return false;
+            sections.push_back(section);
+        }
+        else if(record == "sym"){
+            SYMBOL symbol;
+            in >> symbol.section >> symbol.value >> symbol.exported;
+            symbol.name = rest(in);
+            symbols.push_back(symbol);
+        }
+        else if(record == "reloc"){
+            RELOCATION relocation;
+            int kind = 0;
+            in >> relocation.section >> relocation.offset >> kind >> relocation.target >> relocation.addend;
+            relocation.kind = kind;
+            relocation.symbol = rest(in);
+            relocations.push_back(relocation);
+        }
+        else if(record == "line"){
+            LINE entry;
+            in >> entry.section >> entry.offset;
+            entry.where = rest(in);
+            lines.push_back(entry);
+        }
+        else
+            return false;
+        if(in.fail())
+            return false;
+    }
+    return true;
+}
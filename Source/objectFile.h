@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "datatypes.h"
+
+// Relocatable output of SourceAssembler for one source file, the input of Linker.
+// Addresses of labels aren't known before linking, so they are stored as offsets into a
+// section, and every place that refers to one gets a relocation.
+struct OBJECT{
+    struct SECTION{
+        std::string name;
+        long org = -1;                  // Fixed address set with .org, -1 if the linker places it
+        std::vector<BYTE> data;
+    };
+
+    struct SYMBOL{
+        std::string name;
+        int section = -1;               // Index into sections, -1 for constants
+        long value = 0;                 // Offset into the section or the value of the constant
+        bool exported = true;           // Names starting with @ are local to the file
+    };
+
+    enum RELOCATIONS{
+        RelocWord,                      // Little endian address
+        RelocByte,                      // Zero page address or immediate, has to fit into 8 bits
+        RelocLow,                       // <expr
+        RelocHigh,                      // >expr
+        RelocBranch                     // Relative offset of a branch
+    };
+
+    // Value of symbol + addend, or of the start of target (a section of this object) + addend
+    struct RELOCATION{
+        int section;
+        unsigned offset;
+        BYTE kind;
+        std::string symbol;
+        int target = -1;
+        long addend = 0;
+    };
+
+    // The source and the files it included, with the hash of their content when assembled
+    struct DEPENDENCY{
+        std::string path;
+        unsigned long long hash;
+    };
+
+    // Source line (file:line) of an instruction
+    struct LINE{
+        int section;
+        unsigned offset;
+        std::string where;
+    };
+
+    std::string source;
+    std::vector<DEPENDENCY> dependencies;
+    std::vector<SECTION> sections;
+    std::vector<SYMBOL> symbols;
+    std::vector<RELOCATION> relocations;
+    std::vector<LINE> lines;
+
+    // Text format, one record per line. load() returns false if the file is missing or
+    // was written by another version.
+    static const int VERSION = 2;
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // True if none of the dependencies changed since the object was assembled
+    bool upToDate() const;
+};
+
+// FNV-1a, used as the key of cached objects
+unsigned long long contentHash(const std::string& data, unsigned long long hash = 0xCBF29CE484222325ULL);
+
+// Content of a file, false if it can't be read
+bool readFile(const std::string& path, std::string& content);
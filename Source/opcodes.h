@@ -0,0 +1,94 @@
+#pragma once
+
+#include "datatypes.h"
+
+// The instruction set of the 6502, described once. emu6502 builds its lookup table from it,
+// Assembler and SourceAssembler find the opcodes in it, Disassembler and the recompiler
+// decode with it.
+// The modes follow emu6502: BRK is ModeIMM because the CPU skips the byte after it, the
+// undocumented opcodes are the NOPs and XXX (both do nothing) with the size and cycles
+// emu6502 gives them. ModeACC is IMP for the CPU, it only tells the shifts on A apart.
+// OPCODES_UNDOCUMENTED and OPCODES_65C02 describe the other variants of cpuVariants.h.
+enum ADDRESS_MODES{
+    ModeIMP, ModeACC, ModeIMM,
+    ModeZP0, ModeZPX, ModeZPY,
+    ModeREL, ModeABS, ModeABX,
+    ModeABY, ModeIND, ModeIZX,
+    ModeIZY,
+    ModeZPI, ModeIAX,           // 65C02 only: (zp) and (abs,X)
+    MODE_COUNT
+};
+
+// Bytes of an instruction in each mode, opcode included
+inline constexpr BYTE MODE_LENGTH[MODE_COUNT] = { 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3, 2, 2, 2, 3 };
+
+struct OPCODE{
+    const char* name;
+    BYTE mode;
+    BYTE cycles;        // Without the extra cycles of page crossings and taken branches
+    bool legal;         // Defined on the variant: the 151 documented opcodes and the additions
+                        // of the variant. The assembler only uses these.
+};
+
+inline constexpr OPCODE OPCODES[256] = {
+    { "BRK", ModeIMM, 7, true },{ "ORA", ModeIZX, 6, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 3, false },{ "ORA", ModeZP0, 3, true },{ "ASL", ModeZP0, 5, true },{ "XXX", ModeIMP, 5, false },{ "PHP", ModeIMP, 3, true },{ "ORA", ModeIMM, 2, true },{ "ASL", ModeACC, 2, true },{ "XXX", ModeIMP, 2, false },{ "NOP", ModeIMP, 4, false },{ "ORA", ModeABS, 4, true },{ "ASL", ModeABS, 6, true },{ "XXX", ModeIMP, 6, false },
+    { "BPL", ModeREL, 2, true },{ "ORA", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 4, false },{ "ORA", ModeZPX, 4, true },{ "ASL", ModeZPX, 6, true },{ "XXX", ModeIMP, 6, false },{ "CLC", ModeIMP, 2, true },{ "ORA", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 7, false },{ "NOP", ModeIMP, 4, false },{ "ORA", ModeABX, 4, true },{ "ASL", ModeABX, 7, true },{ "XXX", ModeIMP, 7, false },
+    { "JSR", ModeABS, 6, true },{ "AND", ModeIZX, 6, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "BIT", ModeZP0, 3, true },{ "AND", ModeZP0, 3, true },{ "ROL", ModeZP0, 5, true },{ "XXX", ModeIMP, 5, false },{ "PLP", ModeIMP, 4, true },{ "AND", ModeIMM, 2, true },{ "ROL", ModeACC, 2, true },{ "XXX", ModeIMP, 2, false },{ "BIT", ModeABS, 4, true },{ "AND", ModeABS, 4, true },{ "ROL", ModeABS, 6, true },{ "XXX", ModeIMP, 6, false },
+    { "BMI", ModeREL, 2, true },{ "AND", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 4, false },{ "AND", ModeZPX, 4, true },{ "ROL", ModeZPX, 6, true },{ "XXX", ModeIMP, 6, false },{ "SEC", ModeIMP, 2, true },{ "AND", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 7, false },{ "NOP", ModeIMP, 4, false },{ "AND", ModeABX, 4, true },{ "ROL", ModeABX, 7, true },{ "XXX", ModeIMP, 7, false },
+    { "RTI", ModeIMP, 6, true },{ "EOR", ModeIZX, 6, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 3, false },{ "EOR", ModeZP0, 3, true },{ "LSR", ModeZP0, 5, true },{ "XXX", ModeIMP, 5, false },{ "PHA", ModeIMP, 3, true },{ "EOR", ModeIMM, 2, true },{ "LSR", ModeACC, 2, true },{ "XXX", ModeIMP, 2, false },{ "JMP", ModeABS, 3, true },{ "EOR", ModeABS, 4, true },{ "LSR", ModeABS, 6, true },{ "XXX", ModeIMP, 6, false },
+    { "BVC", ModeREL, 2, true },{ "EOR", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 4, false },{ "EOR", ModeZPX, 4, true },{ "LSR", ModeZPX, 6, true },{ "XXX", ModeIMP, 6, false },{ "CLI", ModeIMP, 2, true },{ "EOR", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 7, false },{ "NOP", ModeIMP, 4, false },{ "EOR", ModeABX, 4, true },{ "LSR", ModeABX, 7, true },{ "XXX", ModeIMP, 7, false },
+    { "RTS", ModeIMP, 6, true },{ "ADC", ModeIZX, 6, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 3, false },{ "ADC", ModeZP0, 3, true },{ "ROR", ModeZP0, 5, true },{ "XXX", ModeIMP, 5, false },{ "PLA", ModeIMP, 4, true },{ "ADC", ModeIMM, 2, true },{ "ROR", ModeACC, 2, true },{ "XXX", ModeIMP, 2, false },{ "JMP", ModeIND, 5, true },{ "ADC", ModeABS, 4, true },{ "ROR", ModeABS, 6, true },{ "XXX", ModeIMP, 6, false },
+    { "BVS", ModeREL, 2, true },{ "ADC", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 4, false },{ "ADC", ModeZPX, 4, true },{ "ROR", ModeZPX, 6, true },{ "XXX", ModeIMP, 6, false },{ "SEI", ModeIMP, 2, true },{ "ADC", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 7, false },{ "NOP", ModeIMP, 4, false },{ "ADC", ModeABX, 4, true },{ "ROR", ModeABX, 7, true },{ "XXX", ModeIMP, 7, false },
+    { "NOP", ModeIMP, 2, false },{ "STA", ModeIZX, 6, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 6, false },{ "STY", ModeZP0, 3, true },{ "STA", ModeZP0, 3, true },{ "STX", ModeZP0, 3, true },{ "XXX", ModeIMP, 3, false },{ "DEY", ModeIMP, 2, true },{ "NOP", ModeIMP, 2, false },{ "TXA", ModeIMP, 2, true },{ "XXX", ModeIMP, 2, false },{ "STY", ModeABS, 4, true },{ "STA", ModeABS, 4, true },{ "STX", ModeABS, 4, true },{ "XXX", ModeIMP, 4, false },
+    { "BCC", ModeREL, 2, true },{ "STA", ModeIZY, 6, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 6, false },{ "STY", ModeZPX, 4, true },{ "STA", ModeZPX, 4, true },{ "STX", ModeZPY, 4, true },{ "XXX", ModeIMP, 4, false },{ "TYA", ModeIMP, 2, true },{ "STA", ModeABY, 5, true },{ "TXS", ModeIMP, 2, true },{ "XXX", ModeIMP, 5, false },{ "NOP", ModeIMP, 5, false },{ "STA", ModeABX, 5, true },{ "XXX", ModeIMP, 5, false },{ "XXX", ModeIMP, 5, false },
+    { "LDY", ModeIMM, 2, true },{ "LDA", ModeIZX, 6, true },{ "LDX", ModeIMM, 2, true },{ "XXX", ModeIMP, 6, false },{ "LDY", ModeZP0, 3, true },{ "LDA", ModeZP0, 3, true },{ "LDX", ModeZP0, 3, true },{ "XXX", ModeIMP, 3, false },{ "TAY", ModeIMP, 2, true },{ "LDA", ModeIMM, 2, true },{ "TAX", ModeIMP, 2, true },{ "XXX", ModeIMP, 2, false },{ "LDY", ModeABS, 4, true },{ "LDA", ModeABS, 4, true },{ "LDX", ModeABS, 4, true },{ "XXX", ModeIMP, 4, false },
+    { "BCS", ModeREL, 2, true },{ "LDA", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 5, false },{ "LDY", ModeZPX, 4, true },{ "LDA", ModeZPX, 4, true },{ "LDX", ModeZPY, 4, true },{ "XXX", ModeIMP, 4, false },{ "CLV", ModeIMP, 2, true },{ "LDA", ModeABY, 4, true },{ "TSX", ModeIMP, 2, true },{ "XXX", ModeIMP, 4, false },{ "LDY", ModeABX, 4, true },{ "LDA", ModeABX, 4, true },{ "LDX", ModeABY, 4, true },{ "XXX", ModeIMP, 4, false },
+    { "CPY", ModeIMM, 2, true },{ "CMP", ModeIZX, 6, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "CPY", ModeZP0, 3, true },{ "CMP", ModeZP0, 3, true },{ "DEC", ModeZP0, 5, true },{ "XXX", ModeIMP, 5, false },{ "INY", ModeIMP, 2, true },{ "CMP", ModeIMM, 2, true },{ "DEX", ModeIMP, 2, true },{ "XXX", ModeIMP, 2, false },{ "CPY", ModeABS, 4, true },{ "CMP", ModeABS, 4, true },{ "DEC", ModeABS, 6, true },{ "XXX", ModeIMP, 6, false },
+    { "BNE", ModeREL, 2, true },{ "CMP", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 4, false },{ "CMP", ModeZPX, 4, true },{ "DEC", ModeZPX, 6, true },{ "XXX", ModeIMP, 6, false },{ "CLD", ModeIMP, 2, true },{ "CMP", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 7, false },{ "NOP", ModeIMP, 4, false },{ "CMP", ModeABX, 4, true },{ "DEC", ModeABX, 7, true },{ "XXX", ModeIMP, 7, false },
+    { "CPX", ModeIMM, 2, true },{ "SBC", ModeIZX, 6, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "CPX", ModeZP0, 3, true },{ "SBC", ModeZP0, 3, true },{ "INC", ModeZP0, 5, true },{ "XXX", ModeIMP, 5, false },{ "INX", ModeIMP, 2, true },{ "SBC", ModeIMM, 2, true },{ "NOP", ModeIMP, 2, true },{ "SBC", ModeIMP, 2, false },{ "CPX", ModeABS, 4, true },{ "SBC", ModeABS, 4, true },{ "INC", ModeABS, 6, true },{ "XXX", ModeIMP, 6, false },
+    { "BEQ", ModeREL, 2, true },{ "SBC", ModeIZY, 5, true },{ "XXX", ModeIMP, 2, false },{ "XXX", ModeIMP, 8, false },{ "NOP", ModeIMP, 4, false },{ "SBC", ModeZPX, 4, true },{ "INC", ModeZPX, 6, true },{ "XXX", ModeIMP, 6, false },{ "SED", ModeIMP, 2, true },{ "SBC", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "XXX", ModeIMP, 7, false },{ "NOP", ModeIMP, 4, false },{ "SBC", ModeABX, 4, true },{ "INC", ModeABX, 7, true },{ "XXX", ModeIMP, 7, false }
+};
+
+// NMOS 6502 with the undocumented opcodes. The stable ones (SLO, RLA, SRE, RRA, SAX, LAX, DCP,
+// ISC, ANC, ALR, ARR, SBX) count as defined. Not defined are the duplicates (ANC 0x2B, SBC 0xEB),
+// the NOPs, JAM, which freezes the CPU, and the unstable ones, which are emulated with the
+// usual constants: XAA, LXA, SHA, TAS, SHY, SHX, LAS.
+inline constexpr OPCODE OPCODES_UNDOCUMENTED[256] = {
+    { "BRK", ModeIMM, 7, true },{ "ORA", ModeIZX, 6, true },{ "JAM", ModeIMP, 2, false },{ "SLO", ModeIZX, 8, true },{ "NOP", ModeZP0, 3, false },{ "ORA", ModeZP0, 3, true },{ "ASL", ModeZP0, 5, true },{ "SLO", ModeZP0, 5, true },{ "PHP", ModeIMP, 3, true },{ "ORA", ModeIMM, 2, true },{ "ASL", ModeACC, 2, true },{ "ANC", ModeIMM, 2, true },{ "NOP", ModeABS, 4, false },{ "ORA", ModeABS, 4, true },{ "ASL", ModeABS, 6, true },{ "SLO", ModeABS, 6, true },
+    { "BPL", ModeREL, 2, true },{ "ORA", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "SLO", ModeIZY, 8, true },{ "NOP", ModeZPX, 4, false },{ "ORA", ModeZPX, 4, true },{ "ASL", ModeZPX, 6, true },{ "SLO", ModeZPX, 6, true },{ "CLC", ModeIMP, 2, true },{ "ORA", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "SLO", ModeABY, 7, true },{ "NOP", ModeABX, 4, false },{ "ORA", ModeABX, 4, true },{ "ASL", ModeABX, 7, true },{ "SLO", ModeABX, 7, true },
+    { "JSR", ModeABS, 6, true },{ "AND", ModeIZX, 6, true },{ "JAM", ModeIMP, 2, false },{ "RLA", ModeIZX, 8, true },{ "BIT", ModeZP0, 3, true },{ "AND", ModeZP0, 3, true },{ "ROL", ModeZP0, 5, true },{ "RLA", ModeZP0, 5, true },{ "PLP", ModeIMP, 4, true },{ "AND", ModeIMM, 2, true },{ "ROL", ModeACC, 2, true },{ "ANC", ModeIMM, 2, false },{ "BIT", ModeABS, 4, true },{ "AND", ModeABS, 4, true },{ "ROL", ModeABS, 6, true },{ "RLA", ModeABS, 6, true },
+    { "BMI", ModeREL, 2, true },{ "AND", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "RLA", ModeIZY, 8, true },{ "NOP", ModeZPX, 4, false },{ "AND", ModeZPX, 4, true },{ "ROL", ModeZPX, 6, true },{ "RLA", ModeZPX, 6, true },{ "SEC", ModeIMP, 2, true },{ "AND", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "RLA", ModeABY, 7, true },{ "NOP", ModeABX, 4, false },{ "AND", ModeABX, 4, true },{ "ROL", ModeABX, 7, true },{ "RLA", ModeABX, 7, true },
+    { "RTI", ModeIMP, 6, true },{ "EOR", ModeIZX, 6, true },{ "JAM", ModeIMP, 2, false },{ "SRE", ModeIZX, 8, true },{ "NOP", ModeZP0, 3, false },{ "EOR", ModeZP0, 3, true },{ "LSR", ModeZP0, 5, true },{ "SRE", ModeZP0, 5, true },{ "PHA", ModeIMP, 3, true },{ "EOR", ModeIMM, 2, true },{ "LSR", ModeACC, 2, true },{ "ALR", ModeIMM, 2, true },{ "JMP", ModeABS, 3, true },{ "EOR", ModeABS, 4, true },{ "LSR", ModeABS, 6, true },{ "SRE", ModeABS, 6, true },
+    { "BVC", ModeREL, 2, true },{ "EOR", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "SRE", ModeIZY, 8, true },{ "NOP", ModeZPX, 4, false },{ "EOR", ModeZPX, 4, true },{ "LSR", ModeZPX, 6, true },{ "SRE", ModeZPX, 6, true },{ "CLI", ModeIMP, 2, true },{ "EOR", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "SRE", ModeABY, 7, true },{ "NOP", ModeABX, 4, false },{ "EOR", ModeABX, 4, true },{ "LSR", ModeABX, 7, true },{ "SRE", ModeABX, 7, true },
+    { "RTS", ModeIMP, 6, true },{ "ADC", ModeIZX, 6, true },{ "JAM", ModeIMP, 2, false },{ "RRA", ModeIZX, 8, true },{ "NOP", ModeZP0, 3, false },{ "ADC", ModeZP0, 3, true },{ "ROR", ModeZP0, 5, true },{ "RRA", ModeZP0, 5, true },{ "PLA", ModeIMP, 4, true },{ "ADC", ModeIMM, 2, true },{ "ROR", ModeACC, 2, true },{ "ARR", ModeIMM, 2, true },{ "JMP", ModeIND, 5, true },{ "ADC", ModeABS, 4, true },{ "ROR", ModeABS, 6, true },{ "RRA", ModeABS, 6, true },
+    { "BVS", ModeREL, 2, true },{ "ADC", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "RRA", ModeIZY, 8, true },{ "NOP", ModeZPX, 4, false },{ "ADC", ModeZPX, 4, true },{ "ROR", ModeZPX, 6, true },{ "RRA", ModeZPX, 6, true },{ "SEI", ModeIMP, 2, true },{ "ADC", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "RRA", ModeABY, 7, true },{ "NOP", ModeABX, 4, false },{ "ADC", ModeABX, 4, true },{ "ROR", ModeABX, 7, true },{ "RRA", ModeABX, 7, true },
+    { "NOP", ModeIMM, 2, false },{ "STA", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "SAX", ModeIZX, 6, true },{ "STY", ModeZP0, 3, true },{ "STA", ModeZP0, 3, true },{ "STX", ModeZP0, 3, true },{ "SAX", ModeZP0, 3, true },{ "DEY", ModeIMP, 2, true },{ "NOP", ModeIMM, 2, false },{ "TXA", ModeIMP, 2, true },{ "XAA", ModeIMM, 2, false },{ "STY", ModeABS, 4, true },{ "STA", ModeABS, 4, true },{ "STX", ModeABS, 4, true },{ "SAX", ModeABS, 4, true },
+    { "BCC", ModeREL, 2, true },{ "STA", ModeIZY, 6, true },{ "JAM", ModeIMP, 2, false },{ "SHA", ModeIZY, 6, false },{ "STY", ModeZPX, 4, true },{ "STA", ModeZPX, 4, true },{ "STX", ModeZPY, 4, true },{ "SAX", ModeZPY, 4, true },{ "TYA", ModeIMP, 2, true },{ "STA", ModeABY, 5, true },{ "TXS", ModeIMP, 2, true },{ "TAS", ModeABY, 5, false },{ "SHY", ModeABX, 5, false },{ "STA", ModeABX, 5, true },{ "SHX", ModeABY, 5, false },{ "SHA", ModeABY, 5, false },
+    { "LDY", ModeIMM, 2, true },{ "LDA", ModeIZX, 6, true },{ "LDX", ModeIMM, 2, true },{ "LAX", ModeIZX, 6, true },{ "LDY", ModeZP0, 3, true },{ "LDA", ModeZP0, 3, true },{ "LDX", ModeZP0, 3, true },{ "LAX", ModeZP0, 3, true },{ "TAY", ModeIMP, 2, true },{ "LDA", ModeIMM, 2, true },{ "TAX", ModeIMP, 2, true },{ "LXA", ModeIMM, 2, false },{ "LDY", ModeABS, 4, true },{ "LDA", ModeABS, 4, true },{ "LDX", ModeABS, 4, true },{ "LAX", ModeABS, 4, true },
+    { "BCS", ModeREL, 2, true },{ "LDA", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "LAX", ModeIZY, 5, true },{ "LDY", ModeZPX, 4, true },{ "LDA", ModeZPX, 4, true },{ "LDX", ModeZPY, 4, true },{ "LAX", ModeZPY, 4, true },{ "CLV", ModeIMP, 2, true },{ "LDA", ModeABY, 4, true },{ "TSX", ModeIMP, 2, true },{ "LAS", ModeABY, 4, false },{ "LDY", ModeABX, 4, true },{ "LDA", ModeABX, 4, true },{ "LDX", ModeABY, 4, true },{ "LAX", ModeABY, 4, true },
+    { "CPY", ModeIMM, 2, true },{ "CMP", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "DCP", ModeIZX, 8, true },{ "CPY", ModeZP0, 3, true },{ "CMP", ModeZP0, 3, true },{ "DEC", ModeZP0, 5, true },{ "DCP", ModeZP0, 5, true },{ "INY", ModeIMP, 2, true },{ "CMP", ModeIMM, 2, true },{ "DEX", ModeIMP, 2, true },{ "SBX", ModeIMM, 2, true },{ "CPY", ModeABS, 4, true },{ "CMP", ModeABS, 4, true },{ "DEC", ModeABS, 6, true },{ "DCP", ModeABS, 6, true },
+    { "BNE", ModeREL, 2, true },{ "CMP", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "DCP", ModeIZY, 8, true },{ "NOP", ModeZPX, 4, false },{ "CMP", ModeZPX, 4, true },{ "DEC", ModeZPX, 6, true },{ "DCP", ModeZPX, 6, true },{ "CLD", ModeIMP, 2, true },{ "CMP", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "DCP", ModeABY, 7, true },{ "NOP", ModeABX, 4, false },{ "CMP", ModeABX, 4, true },{ "DEC", ModeABX, 7, true },{ "DCP", ModeABX, 7, true },
+    { "CPX", ModeIMM, 2, true },{ "SBC", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "ISC", ModeIZX, 8, true },{ "CPX", ModeZP0, 3, true },{ "SBC", ModeZP0, 3, true },{ "INC", ModeZP0, 5, true },{ "ISC", ModeZP0, 5, true },{ "INX", ModeIMP, 2, true },{ "SBC", ModeIMM, 2, true },{ "NOP", ModeIMP, 2, true },{ "SBC", ModeIMM, 2, false },{ "CPX", ModeABS, 4, true },{ "SBC", ModeABS, 4, true },{ "INC", ModeABS, 6, true },{ "ISC", ModeABS, 6, true },
+    { "BEQ", ModeREL, 2, true },{ "SBC", ModeIZY, 5, true },{ "JAM", ModeIMP, 2, false },{ "ISC", ModeIZY, 8, true },{ "NOP", ModeZPX, 4, false },{ "SBC", ModeZPX, 4, true },{ "INC", ModeZPX, 6, true },{ "ISC", ModeZPX, 6, true },{ "SED", ModeIMP, 2, true },{ "SBC", ModeABY, 4, true },{ "NOP", ModeIMP, 2, false },{ "ISC", ModeABY, 7, true },{ "NOP", ModeABX, 4, false },{ "SBC", ModeABX, 4, true },{ "INC", ModeABX, 7, true },{ "ISC", ModeABX, 7, true }
+};
+
+// 65C02 without the bit instructions of Rockwell and WDC (RMB, SMB, BBR, BBS) and WAI, STP.
+// The opcodes it doesn't define are NOPs of different sizes, most of them take 1 cycle.
+inline constexpr OPCODE OPCODES_65C02[256] = {
+    { "BRK", ModeIMM, 7, true },{ "ORA", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "TSB", ModeZP0, 5, true },{ "ORA", ModeZP0, 3, true },{ "ASL", ModeZP0, 5, true },{ "NOP", ModeIMP, 1, false },{ "PHP", ModeIMP, 3, true },{ "ORA", ModeIMM, 2, true },{ "ASL", ModeACC, 2, true },{ "NOP", ModeIMP, 1, false },{ "TSB", ModeABS, 6, true },{ "ORA", ModeABS, 4, true },{ "ASL", ModeABS, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BPL", ModeREL, 2, true },{ "ORA", ModeIZY, 5, true },{ "ORA", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "TRB", ModeZP0, 5, true },{ "ORA", ModeZPX, 4, true },{ "ASL", ModeZPX, 6, true },{ "NOP", ModeIMP, 1, false },{ "CLC", ModeIMP, 2, true },{ "ORA", ModeABY, 4, true },{ "INC", ModeACC, 2, true },{ "NOP", ModeIMP, 1, false },{ "TRB", ModeABS, 6, true },{ "ORA", ModeABX, 4, true },{ "ASL", ModeABX, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "JSR", ModeABS, 6, true },{ "AND", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "BIT", ModeZP0, 3, true },{ "AND", ModeZP0, 3, true },{ "ROL", ModeZP0, 5, true },{ "NOP", ModeIMP, 1, false },{ "PLP", ModeIMP, 4, true },{ "AND", ModeIMM, 2, true },{ "ROL", ModeACC, 2, true },{ "NOP", ModeIMP, 1, false },{ "BIT", ModeABS, 4, true },{ "AND", ModeABS, 4, true },{ "ROL", ModeABS, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BMI", ModeREL, 2, true },{ "AND", ModeIZY, 5, true },{ "AND", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "BIT", ModeZPX, 4, true },{ "AND", ModeZPX, 4, true },{ "ROL", ModeZPX, 6, true },{ "NOP", ModeIMP, 1, false },{ "SEC", ModeIMP, 2, true },{ "AND", ModeABY, 4, true },{ "DEC", ModeACC, 2, true },{ "NOP", ModeIMP, 1, false },{ "BIT", ModeABX, 4, true },{ "AND", ModeABX, 4, true },{ "ROL", ModeABX, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "RTI", ModeIMP, 6, true },{ "EOR", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeZP0, 3, false },{ "EOR", ModeZP0, 3, true },{ "LSR", ModeZP0, 5, true },{ "NOP", ModeIMP, 1, false },{ "PHA", ModeIMP, 3, true },{ "EOR", ModeIMM, 2, true },{ "LSR", ModeACC, 2, true },{ "NOP", ModeIMP, 1, false },{ "JMP", ModeABS, 3, true },{ "EOR", ModeABS, 4, true },{ "LSR", ModeABS, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BVC", ModeREL, 2, true },{ "EOR", ModeIZY, 5, true },{ "EOR", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeZPX, 4, false },{ "EOR", ModeZPX, 4, true },{ "LSR", ModeZPX, 6, true },{ "NOP", ModeIMP, 1, false },{ "CLI", ModeIMP, 2, true },{ "EOR", ModeABY, 4, true },{ "PHY", ModeIMP, 3, true },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeABS, 8, false },{ "EOR", ModeABX, 4, true },{ "LSR", ModeABX, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "RTS", ModeIMP, 6, true },{ "ADC", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "STZ", ModeZP0, 3, true },{ "ADC", ModeZP0, 3, true },{ "ROR", ModeZP0, 5, true },{ "NOP", ModeIMP, 1, false },{ "PLA", ModeIMP, 4, true },{ "ADC", ModeIMM, 2, true },{ "ROR", ModeACC, 2, true },{ "NOP", ModeIMP, 1, false },{ "JMP", ModeIND, 6, true },{ "ADC", ModeABS, 4, true },{ "ROR", ModeABS, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BVS", ModeREL, 2, true },{ "ADC", ModeIZY, 5, true },{ "ADC", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "STZ", ModeZPX, 4, true },{ "ADC", ModeZPX, 4, true },{ "ROR", ModeZPX, 6, true },{ "NOP", ModeIMP, 1, false },{ "SEI", ModeIMP, 2, true },{ "ADC", ModeABY, 4, true },{ "PLY", ModeIMP, 4, true },{ "NOP", ModeIMP, 1, false },{ "JMP", ModeIAX, 6, true },{ "ADC", ModeABX, 4, true },{ "ROR", ModeABX, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BRA", ModeREL, 2, true },{ "STA", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "STY", ModeZP0, 3, true },{ "STA", ModeZP0, 3, true },{ "STX", ModeZP0, 3, true },{ "NOP", ModeIMP, 1, false },{ "DEY", ModeIMP, 2, true },{ "BIT", ModeIMM, 2, true },{ "TXA", ModeIMP, 2, true },{ "NOP", ModeIMP, 1, false },{ "STY", ModeABS, 4, true },{ "STA", ModeABS, 4, true },{ "STX", ModeABS, 4, true },{ "NOP", ModeIMP, 1, false },
+    { "BCC", ModeREL, 2, true },{ "STA", ModeIZY, 6, true },{ "STA", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "STY", ModeZPX, 4, true },{ "STA", ModeZPX, 4, true },{ "STX", ModeZPY, 4, true },{ "NOP", ModeIMP, 1, false },{ "TYA", ModeIMP, 2, true },{ "STA", ModeABY, 5, true },{ "TXS", ModeIMP, 2, true },{ "NOP", ModeIMP, 1, false },{ "STZ", ModeABS, 4, true },{ "STA", ModeABX, 5, true },{ "STZ", ModeABX, 5, true },{ "NOP", ModeIMP, 1, false },
+    { "LDY", ModeIMM, 2, true },{ "LDA", ModeIZX, 6, true },{ "LDX", ModeIMM, 2, true },{ "NOP", ModeIMP, 1, false },{ "LDY", ModeZP0, 3, true },{ "LDA", ModeZP0, 3, true },{ "LDX", ModeZP0, 3, true },{ "NOP", ModeIMP, 1, false },{ "TAY", ModeIMP, 2, true },{ "LDA", ModeIMM, 2, true },{ "TAX", ModeIMP, 2, true },{ "NOP", ModeIMP, 1, false },{ "LDY", ModeABS, 4, true },{ "LDA", ModeABS, 4, true },{ "LDX", ModeABS, 4, true },{ "NOP", ModeIMP, 1, false },
+    { "BCS", ModeREL, 2, true },{ "LDA", ModeIZY, 5, true },{ "LDA", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "LDY", ModeZPX, 4, true },{ "LDA", ModeZPX, 4, true },{ "LDX", ModeZPY, 4, true },{ "NOP", ModeIMP, 1, false },{ "CLV", ModeIMP, 2, true },{ "LDA", ModeABY, 4, true },{ "TSX", ModeIMP, 2, true },{ "NOP", ModeIMP, 1, false },{ "LDY", ModeABX, 4, true },{ "LDA", ModeABX, 4, true },{ "LDX", ModeABY, 4, true },{ "NOP", ModeIMP, 1, false },
+    { "CPY", ModeIMM, 2, true },{ "CMP", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "CPY", ModeZP0, 3, true },{ "CMP", ModeZP0, 3, true },{ "DEC", ModeZP0, 5, true },{ "NOP", ModeIMP, 1, false },{ "INY", ModeIMP, 2, true },{ "CMP", ModeIMM, 2, true },{ "DEX", ModeIMP, 2, true },{ "NOP", ModeIMP, 1, false },{ "CPY", ModeABS, 4, true },{ "CMP", ModeABS, 4, true },{ "DEC", ModeABS, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BNE", ModeREL, 2, true },{ "CMP", ModeIZY, 5, true },{ "CMP", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeZPX, 4, false },{ "CMP", ModeZPX, 4, true },{ "DEC", ModeZPX, 6, true },{ "NOP", ModeIMP, 1, false },{ "CLD", ModeIMP, 2, true },{ "CMP", ModeABY, 4, true },{ "PHX", ModeIMP, 3, true },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeABS, 4, false },{ "CMP", ModeABX, 4, true },{ "DEC", ModeABX, 7, true },{ "NOP", ModeIMP, 1, false },
+    { "CPX", ModeIMM, 2, true },{ "SBC", ModeIZX, 6, true },{ "NOP", ModeIMM, 2, false },{ "NOP", ModeIMP, 1, false },{ "CPX", ModeZP0, 3, true },{ "SBC", ModeZP0, 3, true },{ "INC", ModeZP0, 5, true },{ "NOP", ModeIMP, 1, false },{ "INX", ModeIMP, 2, true },{ "SBC", ModeIMM, 2, true },{ "NOP", ModeIMP, 2, true },{ "NOP", ModeIMP, 1, false },{ "CPX", ModeABS, 4, true },{ "SBC", ModeABS, 4, true },{ "INC", ModeABS, 6, true },{ "NOP", ModeIMP, 1, false },
+    { "BEQ", ModeREL, 2, true },{ "SBC", ModeIZY, 5, true },{ "SBC", ModeZPI, 5, true },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeZPX, 4, false },{ "SBC", ModeZPX, 4, true },{ "INC", ModeZPX, 6, true },{ "NOP", ModeIMP, 1, false },{ "SED", ModeIMP, 2, true },{ "SBC", ModeABY, 4, true },{ "PLX", ModeIMP, 4, true },{ "NOP", ModeIMP, 1, false },{ "NOP", ModeABS, 4, false },{ "SBC", ModeABX, 4, true },{ "INC", ModeABX, 7, true },{ "NOP", ModeIMP, 1, false }
+};
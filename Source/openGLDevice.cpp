@@ -27,6 +27,13 @@ OpenGLDevice::OpenGLDevice(){
     }
     glfwMakeContextCurrent(window);
 
+    // Input arrives through callbacks while glfwPollEvents() runs, instead of being polled
+    glfwSetWindowUserPointer(window, this);
+    glfwSetKeyCallback(window, keyCallback);
+    glfwSetCharCallback(window, charCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
+    glfwSetCursorPosCallback(window, cursorPosCallback);
+
     // Setting up GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
@@ -36,10 +43,59 @@ OpenGLDevice::OpenGLDevice(){
         return ;
     }
 
-    // Building and compiling the shader program
+    // Building and compiling the shader programs
+    shaderProgram = buildProgram(vertexShaderSource, fragmentShaderSource);
+    listShaderProgram = buildProgram(listVertexShaderSource, listFragmentShaderSource);
+    bitmapShaderProgram = buildProgram(bitmapVertexShaderSource, bitmapFragmentShaderSource);
+
+    // Setting up the buffers
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    // Bind the Vertex Array Object first, then bind and set vertex buffer, and then configure vertex attributes
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Display list buffer, its storage is allocated by the first present()
+    glGenVertexArrays(1, &listVAO);
+    glGenBuffers(1, &listVBO);
+    glBindVertexArray(listVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, listVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(DISPLAY_VERTEX), (void*)offsetof(DISPLAY_VERTEX, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(DISPLAY_VERTEX), (void*)offsetof(DISPLAY_VERTEX, r));
+    glEnableVertexAttribArray(1);
+
+    // Bitmap quad over the whole window, row 0 of the texture at the top
+    float bitmapVertices[16] = {
+        -1.0f,  1.0f,  0.0f, 0.0f,
+        -1.0f, -1.0f,  0.0f, 1.0f,
+         1.0f,  1.0f,  1.0f, 0.0f,
+         1.0f, -1.0f,  1.0f, 1.0f
+    };
+    glGenVertexArrays(1, &bitmapVAO);
+    glGenBuffers(1, &bitmapVBO);
+    glBindVertexArray(bitmapVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, bitmapVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(bitmapVertices), bitmapVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // Unbinding
+    glBindBuffer(GL_ARRAY_BUFFER, 0); 
+    glBindVertexArray(0); 
+}
+
+unsigned int OpenGLDevice::buildProgram(const char* vertexSource, const char* fragmentSource){
     // Vertex shader
     unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
     glCompileShader(vertexShader);
     // Checking for shader compile errors
     int success;
@@ -54,7 +110,7 @@ OpenGLDevice::OpenGLDevice(){
     }
     // Fragment shader
     unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
     glCompileShader(fragmentShader);
     // Checking for shader compile errors
     glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
@@ -66,37 +122,22 @@ OpenGLDevice::OpenGLDevice(){
         #endif
     }
     // Linking shaders
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
     // Checking for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
         #ifdef DEBUG
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
         printf("ERROR::SHADER::PROGRAM::LINKING_FAILED\n");
         #endif
     }
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
-
-
-    // Setting up the buffers
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    // Bind the Vertex Array Object first, then bind and set vertex buffer, and then configure vertex attributes
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Unbinding
-    glBindBuffer(GL_ARRAY_BUFFER, 0); 
-    glBindVertexArray(0); 
+    (void) infoLog;
+    return program;
 }
 
 OpenGLDevice::~OpenGLDevice(){
@@ -104,13 +145,27 @@ OpenGLDevice::~OpenGLDevice(){
 }
 
 void OpenGLDevice::render(){
-    processInput();
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
+    // Bitmap first, the quad and the display lists are drawn over it
+    if(bitmapShown && bitmapTexture){
+        glUseProgram(bitmapShaderProgram);
+        glBindTexture(GL_TEXTURE_2D, bitmapTexture);
+        glBindVertexArray(bitmapVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
     glUseProgram(shaderProgram);
     glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
     glDrawArrays(GL_LINE_LOOP, 0, 4);
+    // Display list frame, one draw call per primitive type
+    if(lineCount + triangleCount > 0){
+        glUseProgram(listShaderProgram);
+        glBindVertexArray(listVAO);
+        glDrawArrays(GL_TRIANGLES, lineCount, triangleCount);
+        glDrawArrays(GL_LINES, 0, lineCount);
+    }
     glfwSwapBuffers(window);
+    frames++;
     glfwPollEvents();
 }
 
@@ -130,7 +185,84 @@ void OpenGLDevice::update(float newVert[8]){
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
 }
 
-void OpenGLDevice::processInput(){
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        shouldTerminate = true;
+// The buffer is orphaned for every frame, so the driver can hand out fresh storage
+// instead of waiting for the previous frame. It is only reallocated with a larger
+// size if a frame doesn't fit.
+void OpenGLDevice::present(const DISPLAY_VERTEX* lines, size_t lineVertices, const DISPLAY_VERTEX* triangles, size_t triangleVertices){
+    lineCount = lineVertices;
+    triangleCount = triangleVertices;
+    size_t total = lineVertices + triangleVertices;
+    if(total == 0)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, listVBO);
+    while(listCapacity < total)
+        listCapacity = listCapacity ? listCapacity * 2 : 4096;
+    glBufferData(GL_ARRAY_BUFFER, listCapacity * sizeof(DISPLAY_VERTEX), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, lineVertices * sizeof(DISPLAY_VERTEX), lines);
+    glBufferSubData(GL_ARRAY_BUFFER, lineVertices * sizeof(DISPLAY_VERTEX), triangleVertices * sizeof(DISPLAY_VERTEX), triangles);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Rows which didn't change stay in the texture, so a frame costs one glTexSubImage2D per
+// run of changed rows instead of uploading the whole bitmap
+void OpenGLDevice::updateBitmap(const uint32_t* pixels, unsigned width, unsigned height, unsigned first, unsigned count){
+    if(!bitmapTexture){
+        glGenTextures(1, &bitmapTexture);
+        glBindTexture(GL_TEXTURE_2D, bitmapTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, bitmapTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if(width != bitmapWidth || height != bitmapHeight){
+        bitmapWidth = width;
+        bitmapHeight = height;
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    else if(count > 0)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, width, count, GL_RGBA, GL_UNSIGNED_BYTE, pixels + first * width);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void OpenGLDevice::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods){
+    OpenGLDevice* device = owner(window);
+    (void) scancode;
+    if(key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+        device->shouldTerminate = true;
+    device->mods = mods;
+    if(device->input && key >= 0)
+        device->input->push(action == GLFW_RELEASE ? InputDevice::KeyUp : InputDevice::KeyDown, key, mods, device->mouseX, device->mouseY);
+}
+
+void OpenGLDevice::charCallback(GLFWwindow* window, unsigned int codepoint){
+    OpenGLDevice* device = owner(window);
+    if(device->input)
+        device->input->push(InputDevice::Char, codepoint, device->mods, device->mouseX, device->mouseY);
+}
+
+void OpenGLDevice::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods){
+    OpenGLDevice* device = owner(window);
+    device->mods = mods;
+    if(device->input)
+        device->input->push(action == GLFW_RELEASE ? InputDevice::MouseUp : InputDevice::MouseDown, button, mods, device->mouseX, device->mouseY);
+}
+
+// Positions are scaled to 0 - 255, a move within the same step isn't reported
+void OpenGLDevice::cursorPosCallback(GLFWwindow* window, double x, double y){
+    OpenGLDevice* device = owner(window);
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    if(width <= 0 || height <= 0)
+        return;
+    BYTE mx = x <= 0 ? 0 : x >= width ? 255 : (BYTE)(x * 256 / width);
+    BYTE my = y <= 0 ? 0 : y >= height ? 255 : (BYTE)(y * 256 / height);
+    if(mx == device->mouseX && my == device->mouseY)
+        return;
+    device->mouseX = mx;
+    device->mouseY = my;
+    if(device->input)
+        device->input->push(InputDevice::MouseMove, 0, device->mods, mx, my);
 }
\ No newline at end of file
@@ -4,18 +4,41 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "displayList.h"
+#include "inputDevice.h"
 
 class OpenGLDevice{
 public:
     OpenGLDevice();
     ~OpenGLDevice();
     bool shouldTerminate = false;
+    unsigned long long frames = 0;      // Swapped buffers
+
+    // Keys and the mouse are passed to the device from the GLFW callbacks, ESC also ends the run
+    void attachInput(InputDevice* device) { input = device; }
 
     
 private:
     GLFWwindow* window;
     unsigned int shaderProgram;
     unsigned int VBO, VAO;
+
+    // Display list frame: one dynamic buffer holding the lines followed by the triangles
+    unsigned int listShaderProgram;
+    unsigned int listVBO, listVAO;
+    size_t listCapacity = 0;    // Size of listVBO in vertices
+    size_t lineCount = 0;
+    size_t triangleCount = 0;
+
+    // Bitmap of VideoDevice: a texture drawn over the whole window, only the changed rows
+    // are uploaded into it
+    unsigned int bitmapShaderProgram;
+    unsigned int bitmapVBO, bitmapVAO, bitmapTexture = 0;
+    unsigned int bitmapWidth = 0, bitmapHeight = 0;
+    bool bitmapShown = false;
     
     float vertices[8] = {
         -0.5f, -0.5f,
@@ -41,10 +64,60 @@ private:
     "{\n"
     "   FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
     "}\n\0";
+    // Display list shaders, the color comes with every vertex
+    const char *listVertexShaderSource = "#version 330 core\n"
+    "layout (location = 0) in vec2 aPos;\n"
+    "layout (location = 1) in vec3 aColor;\n"
+    "out vec3 color;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);\n"
+    "   color = aColor;\n"
+    "}\0";
+    const char *listFragmentShaderSource = "#version 330 core\n"
+    "in vec3 color;\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "   FragColor = vec4(color, 1.0f);\n"
+    "}\n\0";
+    // Bitmap shaders
+    const char *bitmapVertexShaderSource = "#version 330 core\n"
+    "layout (location = 0) in vec2 aPos;\n"
+    "layout (location = 1) in vec2 aTexCoord;\n"
+    "out vec2 texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);\n"
+    "   texCoord = aTexCoord;\n"
+    "}\0";
+    const char *bitmapFragmentShaderSource = "#version 330 core\n"
+    "in vec2 texCoord;\n"
+    "uniform sampler2D bitmap;\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "   FragColor = texture(bitmap, texCoord);\n"
+    "}\n\0";
+
+    unsigned int buildProgram(const char* vertexSource, const char* fragmentSource);
 
-    void processInput();
+    InputDevice* input = nullptr;
+    BYTE mouseX = 0, mouseY = 0;
+    BYTE mods = 0;
+    static OpenGLDevice* owner(GLFWwindow* window) { return (OpenGLDevice*) glfwGetWindowUserPointer(window); }
+    static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void charCallback(GLFWwindow* window, unsigned int codepoint);
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+    static void cursorPosCallback(GLFWwindow* window, double x, double y);
     
     public:
     void render();
     void update(float newVert[8]);
+    // Uploads a whole display list frame
+    void present(const DISPLAY_VERTEX* lines, size_t lineVertices, const DISPLAY_VERTEX* triangles, size_t triangleVertices);
+    // Uploads rows first .. first + count - 1 of an RGBA bitmap of width x height pixels.
+    // The texture is (re)created when the size changes, then the whole bitmap is uploaded.
+    void updateBitmap(const uint32_t* pixels, unsigned width, unsigned height, unsigned first, unsigned count);
+    void showBitmap(bool show) { bitmapShown = show; }
 };
\ No newline at end of file
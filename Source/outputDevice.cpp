@@ -1,13 +1,22 @@
 #include "outputDevice.h"
 #include "bus.h"
 
+#include <vector>
+#include <chrono>
+
 OutputDevice::OutputDevice(){
     first = 0x00;
     second = 0x00;
 }
 
 OutputDevice::~OutputDevice(){
-    // does nothing
+    // Writes what is left in the ring
+    if(running){
+        running = false;
+        writer.join();
+    }
+    if(logFile)
+        fclose(logFile);
 }
 
 void OutputDevice::ConnectBus(Bus* ptr){
@@ -18,16 +27,110 @@ BYTE OutputDevice::read(WORD addr){
     return bus->read(addr);
 }
 
+void OutputDevice::write(WORD addr, BYTE data){
+    bus->write(addr, data);
+}
+
+bool OutputDevice::openLog(std::string path){
+    flush();
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+        return false;
+    FILE* previous = logFile.exchange(file);
+    if(previous)
+        fclose(previous);
+    return true;
+}
+
 // An output occurs each time that a value has changed
 // Both values can change at the same "transaction" (Reset)
 // so no if else.
 void OutputDevice::clock(){
     if(first != read(0x400)){
         first = read(0x400);
-        printf("First: %d\n", first);
+        push(0x400, first);
     }
     if(second != read(0x401)){
         second = read(0x401);
-        printf("Second: %d\n", second);
+        push(0x401, second);
+    }
+    BYTE character = read(0x402);
+    if(character != 0x00){
+        push(0x402, character);
+        write(0x402, 0x00);
+    }
+}
+
+void OutputDevice::reset(){
+    first = read(0x400);
+    second = read(0x401);
+}
+
+// Called from the emulation thread only. Waits only if the writer can't keep up
+// and the ring is full.
+void OutputDevice::push(WORD port, BYTE value){
+    if(discard)
+        return;
+    if(!running){
+        ring = std::make_unique<EVENT[]>(RING_SIZE);
+        running = true;
+        writer = std::thread(&OutputDevice::drain, this);
     }
-}
\ No newline at end of file
+
+    size_t h = head.load(std::memory_order_relaxed);
+    while(h - tail.load(std::memory_order_acquire) == RING_SIZE)
+        std::this_thread::yield();
+
+    ring[h & (RING_SIZE - 1)] = { bus->clockCount, port, value };
+    head.store(h + 1, std::memory_order_release);
+}
+
+void OutputDevice::flush(){
+    while(running && tail.load(std::memory_order_acquire) != head.load(std::memory_order_acquire))
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+// Writer thread, collects the events into a buffer and writes it at once
+void OutputDevice::drain(){
+    std::vector<char> buffer;
+    buffer.reserve(1 << 16);
+
+    while(true){
+        bool stop = !running.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        FILE* log = logFile.load();
+
+        for(; t != h; t++){
+            const EVENT& e = ring[t & (RING_SIZE - 1)];
+            if(log){
+                for(int i = 0; i < 8; i++)
+                    buffer.push_back((e.cycle >> (8 * i)) & 0xFF);
+                buffer.push_back(e.port & 0xFF);
+                buffer.push_back(e.port >> 8);
+                buffer.push_back(e.value);
+            }
+            else if(e.port == 0x402)
+                buffer.push_back(e.value);
+            else{
+                char line[32];
+                int len = snprintf(line, sizeof(line), e.port == 0x400 ? "First: %d\n" : "Second: %d\n", e.value);
+                buffer.insert(buffer.end(), line, line + len);
+            }
+        }
+
+        if(!buffer.empty()){
+            FILE* out = log ? log : stdout;
+            fwrite(buffer.data(), 1, buffer.size(), out);
+            fflush(out);
+            buffer.clear();
+        }
+        // The slots are only released after the I/O, so flush() means written
+        tail.store(t, std::memory_order_release);
+
+        if(stop)
+            return;
+        if(t == head.load(std::memory_order_acquire))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -1,10 +1,22 @@
 #pragma once
 
 #include <stdio.h>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
 #include "datatypes.h"
 
 class Bus;
 
+// Console/log device.
+// Registers:
+//   0x0400, 0x0401  every change is reported as "First: n" / "Second: n"
+//   0x0402          character stream, a written character is printed and the register cleared
+// The emulation thread only pushes events into a single producer/single consumer ring,
+// a writer thread drains it and does the actual I/O in large batches.
+// With openLog() the events are recorded as binary tuples instead:
+//   8 bytes cycle, 2 bytes port, 1 byte value (little endian)
 class OutputDevice{
 public:
     OutputDevice();
@@ -13,10 +25,38 @@ public:
     Bus* bus;
 
     BYTE first, second; // used for checking if data is updated
+    // Drops the events instead of printing or logging them, for machines which run jobs
+    bool discard = false;
 
     void ConnectBus(Bus* ptr);
     void clock();
 
+    // Switches to the binary log mode, returns false if the file can't be opened
+    bool openLog(std::string path);
+    // Blocks until every event so far has been written
+    void flush();
+    // Takes the registers as they are, used by Bus::restore() so the restored values aren't
+    // reported as changes
+    void reset();
+
 private:
     BYTE read(WORD addr);
-};
\ No newline at end of file
+    void write(WORD addr, BYTE data);
+
+    struct EVENT{
+        unsigned long long cycle;
+        WORD port;
+        BYTE value;
+    };
+
+    static const size_t RING_SIZE = 1 << 16;   // Has to be a power of two
+    std::unique_ptr<EVENT[]> ring;              // Allocated with the writer thread
+    std::atomic<size_t> head{0};                // Next slot written by the emulation thread
+    std::atomic<size_t> tail{0};                // Next slot read by the writer thread
+    std::atomic<bool> running{false};
+    std::thread writer;
+    std::atomic<FILE*> logFile{nullptr};
+
+    void push(WORD port, BYTE value);
+    void drain();
+};
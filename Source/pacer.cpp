@@ -0,0 +1,90 @@
+#include "pacer.h"
+#include "bus.h"
+#include "metrics.h"
+
+#include <errno.h>
+
+Pacer::Pacer(Bus* bus, double frequency, long sliceMicroseconds, long spinMicroseconds) : bus(bus), frequency(frequency){
+    sliceNs = sliceMicroseconds * 1000LL;
+    spinNs = spinMicroseconds * 1000LL;
+    restart();
+}
+
+Pacer::~Pacer(){
+    // Does nothing
+}
+
+long long Pacer::now(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void Pacer::restart(){
+    startNs = now();
+    startCycle = bus->clockCount;
+    sliceIndex = 0;
+}
+
+void Pacer::setFrequency(double hz){
+    frequency = hz;
+    restart();
+}
+
+void Pacer::slice(){
+    sliceIndex++;
+    long long deadline = startNs + sliceIndex * sliceNs;
+
+    // Cycles are derived from the timeline, so rounding doesn't add up over time
+    unsigned long long target = startCycle + (unsigned long long)(frequency * sliceIndex * sliceNs / 1e9);
+    if(target > bus->clockCount)
+        bus->run(target - bus->clockCount);
+    if(metrics)
+        metrics->publish();
+
+    long long t = now();
+    if(t < deadline - spinNs){
+        struct timespec ts;
+        long long wake = deadline - spinNs;
+        ts.tv_sec = wake / 1000000000LL;
+        ts.tv_nsec = wake % 1000000000LL;
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR);
+        long long woke = now();
+        stats.sleptNs += woke - t;
+        t = woke;
+    }
+    else if(t > deadline)
+        stats.lateSlices++;
+
+    // The last microseconds are spun, a sleep could overshoot them
+    long long spinStart = t;
+    while(t < deadline)
+        t = now();
+    stats.spunNs += t - spinStart;
+
+    long long drift = t - deadline;
+    stats.slices++;
+    stats.totalDriftNs += drift;
+    if(drift > stats.maxDriftNs)
+        stats.maxDriftNs = drift;
+
+    if(drift > maxLagMicroseconds * 1000LL){
+        stats.resyncs++;
+        stats.droppedNs += drift;
+        restart();
+    }
+}
+
+void Pacer::run(){
+    while(!bus->shouldTerminate())
+        slice();
+}
+
+void Pacer::report(FILE* file){
+    double seconds = (double) stats.slices * sliceNs / 1e9;
+    fprintf(file, "%llu slices (%.2fs), %llu late, %llu resyncs (%.3fms dropped)\n",
+        stats.slices, seconds, stats.lateSlices, stats.resyncs, stats.droppedNs / 1e6);
+    fprintf(file, "drift: mean %.1fus, max %.1fus; slept %.1f%%, spun %.1f%% of the time\n",
+        stats.slices ? stats.totalDriftNs / 1e3 / stats.slices : 0.0, stats.maxDriftNs / 1e3,
+        seconds > 0 ? 100.0 * stats.sleptNs / 1e9 / seconds : 0.0, seconds > 0 ? 100.0 * stats.spunNs / 1e9 / seconds : 0.0);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+class Bus;
+class Metrics;
+
+// Runs a bus in real time at a given clock rate.
+// The cycles are executed in batches, one per timeslice. After a batch the thread
+// sleeps with clock_nanosleep until shortly before the end of the slice and only
+// spins for the rest, so an instance costs little host CPU.
+// Slices are scheduled on an absolute timeline, late slices are caught up by not
+// sleeping. If the emulation falls behind by more than maxLag, the timeline is reset.
+class Pacer{
+public:
+    Pacer(Bus* bus, double frequency = 1000000.0, long sliceMicroseconds = 1000, long spinMicroseconds = 50);
+    ~Pacer();
+
+    // Runs one timeslice, including the wait for its end
+    void slice();
+    // Runs timeslices until the bus wants to terminate
+    void run();
+
+    // Clock rate in Hz, e.g. 1000000.0 or 1789773.0
+    void setFrequency(double hz);
+    long maxLagMicroseconds = 100000;
+    // Published after every slice if set
+    Metrics* metrics = nullptr;
+
+    struct STATS{
+        unsigned long long slices = 0;
+        unsigned long long lateSlices = 0;  // Slices which had no time left to sleep
+        unsigned long long resyncs = 0;     // Times the timeline was reset
+        long long droppedNs = 0;            // Time given up by the resyncs
+        long long maxDriftNs = 0;           // Largest delay of a slice end
+        long long totalDriftNs = 0;
+        long long sleptNs = 0;
+        long long spunNs = 0;
+    };
+    STATS stats;
+    void report(FILE* file);
+
+private:
+    Bus* bus;
+    double frequency;
+    long long sliceNs;
+    long long spinNs;
+
+    long long startNs = 0;                  // Start of the timeline
+    unsigned long long startCycle = 0;      // bus->clockCount at that time
+    unsigned long long sliceIndex = 0;
+
+    static long long now();
+    void restart();
+};
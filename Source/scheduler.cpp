@@ -0,0 +1,175 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <new>
+
+thread_local Scheduler::ARENA* Scheduler::ARENA::current = nullptr;
+
+// Every frame starts with the arena it came from, nullptr for the heap
+static const size_t HEADER = alignof(max_align_t);
+
+Scheduler::ARENA::~ARENA(){
+    // The blocks free themselves
+}
+
+void* Scheduler::ARENA::allocate(size_t size){
+    size_t sizeClass = (size + GRAIN - 1) / GRAIN;
+    if(sizeClass >= CLASSES)
+        return ::operator new(size);
+    if(free[sizeClass]){
+        void* data = free[sizeClass];
+        free[sizeClass] = *(void**) data;
+        return data;
+    }
+    size_t bytes = sizeClass * GRAIN;
+    if(used + bytes > BLOCK_SIZE){
+        blocks.emplace_back(new BYTE[BLOCK_SIZE]);
+        used = 0;
+    }
+    void* data = blocks.back().get() + used;
+    used += bytes;
+    return data;
+}
+
+void Scheduler::ARENA::release(void* data, size_t size){
+    size_t sizeClass = (size + GRAIN - 1) / GRAIN;
+    if(sizeClass >= CLASSES){
+        ::operator delete(data);
+        return;
+    }
+    *(void**) data = free[sizeClass];
+    free[sizeClass] = data;
+}
+
+void* Scheduler::TASK::promise_type::operator new(size_t size){
+    ARENA* arena = ARENA::current;
+    BYTE* data = (BYTE*)(arena ? arena->allocate(size + HEADER) : ::operator new(size + HEADER));
+    *(ARENA**) data = arena;
+    return data + HEADER;
+}
+
+void Scheduler::TASK::promise_type::operator delete(void* data, size_t size){
+    BYTE* start = (BYTE*) data - HEADER;
+    ARENA* arena = *(ARENA**) start;
+    if(arena)
+        arena->release(start, size + HEADER);
+    else
+        ::operator delete(start);
+}
+
+Scheduler::Scheduler(){
+    // Does nothing
+}
+
+// The frames go back into the arena before it is destroyed
+Scheduler::~Scheduler(){
+    for(HANDLE handle : tasks)
+        handle.destroy();
+}
+
+void Scheduler::reset(unsigned long long cycle){
+    for(HANDLE handle : tasks)
+        handle.destroy();
+    tasks.clear();
+    timers.clear();
+    watchers.clear();
+    interrupts.clear();
+    ready.clear();
+    resuming.clear();
+    updateWatched();
+    now = cycle;
+    next = ~0ULL;
+}
+
+void Scheduler::WRITE::await_suspend(HANDLE handle){
+    scheduler->watchers.push_back({ addr, this, handle });
+    scheduler->watched[addr >> 14] |= 1ULL << ((addr >> 8) & 63);
+    if(timeout > 0)
+        scheduler->at(scheduler->now + timeout, handle);
+}
+
+void Scheduler::at(unsigned long long cycle, HANDLE handle){
+    // Behind the timers of the same cycle, so they fire in the order they were set
+    size_t i = timers.size();
+    while(i > 0 && timers[i - 1].cycle <= cycle)
+        i--;
+    timers.insert(timers.begin() + i, { cycle, handle });
+    next = std::min(next, cycle);
+}
+
+void Scheduler::cancelTimer(HANDLE handle){
+    for(size_t i = 0; i < timers.size(); i++){
+        if(timers[i].handle == handle){
+            timers.erase(timers.begin() + i);
+            return;
+        }
+    }
+}
+
+void Scheduler::cancelWatches(HANDLE handle){
+    size_t count = watchers.size();
+    std::erase_if(watchers, [&](const WATCH& watch){ return watch.handle == handle; });
+    if(watchers.size() != count)
+        updateWatched();
+}
+
+void Scheduler::updateWatched(){
+    for(unsigned long long& bits : watched)
+        bits = 0;
+    for(const WATCH& watch : watchers)
+        watched[watch.addr >> 14] |= 1ULL << ((watch.addr >> 8) & 63);
+}
+
+// The waiting coroutines are resumed at the next clock
+void Scheduler::written(WORD addr, BYTE data){
+    bool found = false;
+    for(size_t i = 0; i < watchers.size();){
+        if(watchers[i].addr != addr){
+            i++;
+            continue;
+        }
+        HANDLE handle = watchers[i].handle;
+        watchers[i].awaiter->data = data;
+        watchers.erase(watchers.begin() + i);
+        cancelTimer(handle);
+        ready.push_back(handle);
+        found = true;
+    }
+    if(found){
+        updateWatched();
+        next = now;
+    }
+}
+
+void Scheduler::acknowledge(){
+    ready.insert(ready.end(), interrupts.begin(), interrupts.end());
+    interrupts.clear();
+    next = now;
+}
+
+void Scheduler::dispatch(){
+    while(!timers.empty() && timers.back().cycle <= now){
+        HANDLE handle = timers.back().handle;
+        timers.pop_back();
+        // A write with a timeout which ran out
+        cancelWatches(handle);
+        ready.push_back(handle);
+    }
+    // Coroutines can make others ready, by writing to an address they wait for
+    while(!ready.empty()){
+        resuming.swap(ready);
+        for(HANDLE handle : resuming){
+            resumes++;
+            handle.resume();
+            if(handle.done())
+                finish(handle);
+        }
+        resuming.clear();
+    }
+    next = timers.empty() ? ~0ULL : timers.back().cycle;
+}
+
+void Scheduler::finish(HANDLE handle){
+    std::erase(tasks, handle);
+    handle.destroy();
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stddef.h>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "datatypes.h"
+
+// Runs devices written as coroutines, driven by the clock of the bus.
+// Instead of a clock() which polls its registers every cycle, such a device is a function that
+// waits for what it needs:
+//     co_await scheduler.cycles(n);           n cycles pass
+//     BYTE b = co_await scheduler.write(a);   the CPU (or anyone) writes to address a
+//     auto b = co_await scheduler.write(a, n); the same, std::nullopt if nothing came within n cycles
+//     co_await scheduler.interrupt();         raises the IRQ until the CPU takes it
+// A waiting coroutine costs nothing: clock() compares the cycle with the next event, the bus
+// only checks watched pages on writes, and Bus::run() skips idle cycles up to the next event.
+// Writes are only seen while a coroutine waits for them, like a register which is sampled.
+// Resumed coroutines run in Bus::clock() after the CPU, in the order of their events.
+// Their frames come from an arena of the machine, so starting and ending devices doesn't go
+// through the global heap. The state of the coroutines isn't part of the checkpoints of Bus,
+// Bus::restore() ends them with reset() and the devices start them again from their registers.
+// Coroutines must not throw. On a MultiCore machine they only see the writes of core 0.
+class Scheduler{
+public:
+    Scheduler();
+    ~Scheduler();
+
+    // Recycles the frames of one machine: 64 byte size classes with free lists, carved from
+    // 16kB blocks. Larger frames come from the heap.
+    class ARENA{
+    public:
+        ~ARENA();
+        void* allocate(size_t size);
+        void release(void* data, size_t size);
+
+        // Arena the frames of the coroutines being started are taken from
+        static thread_local ARENA* current;
+
+    private:
+        static const size_t GRAIN = 64;
+        static const size_t CLASSES = 64;
+        static const size_t BLOCK_SIZE = 16384;
+        std::vector<std::unique_ptr<BYTE[]>> blocks;
+        size_t used = BLOCK_SIZE;
+        void* free[CLASSES] = {};
+    };
+
+    // Return type of a device coroutine
+    struct TASK{
+        struct promise_type{
+            TASK get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_always initial_suspend() { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+
+            static void* operator new(size_t size);
+            static void operator delete(void* data, size_t size);
+        };
+        std::coroutine_handle<promise_type> handle;
+    };
+    using HANDLE = std::coroutine_handle<TASK::promise_type>;
+
+    // Starts a device, body returns its TASK: spawn([this]{ return run(); })
+    template<class BODY>
+    void spawn(BODY body){
+        ARENA* previous = ARENA::current;
+        ARENA::current = &arena;
+        TASK task = body();
+        ARENA::current = previous;
+        ready.push_back(task.handle);
+        tasks.push_back(task.handle);
+        next = now;
+    }
+
+    struct CYCLES{
+        Scheduler* scheduler;
+        unsigned long long cycles;
+        bool await_ready() { return cycles == 0; }
+        void await_suspend(HANDLE handle) { scheduler->at(scheduler->now + cycles, handle); }
+        void await_resume() {}
+    };
+    struct WRITE{
+        Scheduler* scheduler;
+        WORD addr;
+        unsigned long long timeout;         // 0 waits forever
+        std::optional<BYTE> data;
+        bool await_ready() { return false; }
+        void await_suspend(HANDLE handle);
+        std::optional<BYTE> await_resume() { return data; }
+    };
+    struct WRITTEN : WRITE{
+        BYTE await_resume() { return *data; }
+    };
+    struct INTERRUPT{
+        Scheduler* scheduler;
+        bool await_ready() { return false; }
+        void await_suspend(HANDLE handle) { scheduler->interrupts.push_back(handle); }
+        void await_resume() {}
+    };
+
+    CYCLES cycles(unsigned long long n) { return { this, n }; }
+    WRITTEN write(WORD addr) { return { { this, addr, 0, std::nullopt } }; }
+    WRITE write(WORD addr, unsigned long long timeout) { return { this, addr, timeout, std::nullopt }; }
+    INTERRUPT interrupt() { return { this }; }
+
+    // Called by the bus every cycle
+    void clock(unsigned long long cycle){
+        now = cycle;
+        if(cycle >= next)
+            dispatch();
+    }
+    // Checked by Bus::write() before a write to addr
+    bool watches(WORD addr) { return watched[addr >> 14] & (1ULL << ((addr >> 8) & 63)); }
+    void written(WORD addr, BYTE data);
+
+    // Interrupt line, raised while a coroutine waits in interrupt()
+    bool irq() { return !interrupts.empty(); }
+    // The CPU took the interrupt, resumes the coroutines which requested it
+    void acknowledge();
+
+    // Cycles from cycle to the next event, ~0 if there is none
+    unsigned long long pendingCycles(unsigned long long cycle) { return next == ~0ULL ? ~0ULL : next > cycle ? next - cycle : 0; }
+
+    // Destroys all coroutines and forgets their timers, watches and interrupt requests.
+    // The clock continues at cycle.
+    void reset(unsigned long long cycle);
+
+    unsigned running() { return tasks.size(); }
+    // Coroutines resumed, for Metrics
+    unsigned long long resumes = 0;
+
+private:
+    ARENA arena;
+    unsigned long long now = 0;
+    unsigned long long next = ~0ULL;        // Cycle of the earliest event
+
+    struct TIMER{
+        unsigned long long cycle;
+        HANDLE handle;
+    };
+    std::vector<TIMER> timers;              // Latest first, the next one is at the back
+    struct WATCH{
+        WORD addr;
+        WRITE* awaiter;
+        HANDLE handle;
+    };
+    std::vector<WATCH> watchers;
+    unsigned long long watched[4] = {};     // Pages with a watched address
+    std::vector<HANDLE> interrupts;
+    std::vector<HANDLE> ready;
+    std::vector<HANDLE> resuming;
+    std::vector<HANDLE> tasks;              // All frames, destroyed when they finish or with the scheduler
+
+    void at(unsigned long long cycle, HANDLE handle);
+    void cancelTimer(HANDLE handle);
+    void cancelWatches(HANDLE handle);
+    void updateWatched();
+    void dispatch();
+    void finish(HANDLE handle);
+};
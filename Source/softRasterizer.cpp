@@ -0,0 +1,218 @@
+#include "softRasterizer.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+SoftRasterizer::SoftRasterizer(unsigned int width, unsigned int height) : width(width), height(height){
+    framebuffer.resize(width * height);
+}
+
+SoftRasterizer::~SoftRasterizer(){
+    // Does nothing
+}
+
+bool SoftRasterizer::dumpFrames(std::string pattern){
+    std::string path;
+    framePattern = framePath(pattern, 0, path) ? pattern : "";
+    return !framePattern.empty();
+}
+
+// Substitutes the frame number itself, the pattern comes from the user and isn't passed to printf
+bool SoftRasterizer::framePath(const std::string& pattern, unsigned long long frame, std::string& path){
+    path.clear();
+    bool substituted = false;
+    for(size_t i = 0; i < pattern.size(); i++){
+        if(pattern[i] != '%'){
+            path += pattern[i];
+            continue;
+        }
+        if(i + 1 < pattern.size() && pattern[i + 1] == '%'){
+            path += '%';
+            i++;
+            continue;
+        }
+        // %[0][width](u|d)
+        size_t j = i + 1;
+        bool zeros = j < pattern.size() && pattern[j] == '0';
+        unsigned width = 0;
+        while(j < pattern.size() && isdigit((unsigned char) pattern[j]) && width < 100)
+            width = width * 10 + (pattern[j++] - '0');
+        if(substituted || j >= pattern.size() || (pattern[j] != 'u' && pattern[j] != 'd'))
+            return false;
+        std::string number = std::to_string(frame);
+        if(number.size() < width)
+            path += std::string(width - number.size(), zeros ? '0' : ' ');
+        path += number;
+        substituted = true;
+        i = j;
+    }
+    return substituted;
+}
+
+// Memory order R, G, B, A on little endian hosts
+uint32_t SoftRasterizer::pack(float r, float g, float b){
+    uint32_t R = std::clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f;
+    uint32_t G = std::clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f;
+    uint32_t B = std::clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return R | (G << 8) | (B << 16) | 0xFF000000u;
+}
+
+// From the -1.0 to 1.0 range of OpenGL to pixels, y points down in the framebuffer
+int SoftRasterizer::toX(float x) const{
+    return (int) floorf((x + 1.0f) * 0.5f * width);
+}
+
+int SoftRasterizer::toY(float y) const{
+    return (int) floorf((1.0f - y) * 0.5f * height);
+}
+
+void SoftRasterizer::render(const float quad[8], const DISPLAY_VERTEX* lines, size_t lineVertices,
+                            const DISPLAY_VERTEX* triangles, size_t triangleVertices){
+    // Same order as OpenGLDevice::render()
+    std::fill(framebuffer.begin(), framebuffer.end(), pack(0.2f, 0.3f, 0.3f));
+
+    uint32_t orange = pack(1.0f, 0.5f, 0.2f);
+    for(int i = 0; i < 4; i++){
+        int j = (i + 1) % 4;
+        line(toX(quad[2 * i]), toY(quad[2 * i + 1]), toX(quad[2 * j]), toY(quad[2 * j + 1]), orange);
+    }
+
+    for(size_t i = 0; i + 2 < triangleVertices; i += 3)
+        triangle(triangles[i], triangles[i + 1], triangles[i + 2]);
+
+    for(size_t i = 0; i + 1 < lineVertices; i += 2){
+        const DISPLAY_VERTEX& a = lines[i];
+        const DISPLAY_VERTEX& b = lines[i + 1];
+        line(toX(a.x), toY(a.y), toX(b.x), toY(b.y), pack(a.r, a.g, a.b));
+    }
+
+    frameCount++;
+    if(!framePattern.empty()){
+        std::string path;
+        framePath(framePattern, frameCount, path);
+        writePPM(path);
+    }
+    if(hashFile)
+        fprintf(hashFile, "%llu %016llx\n", frameCount, (unsigned long long) hash());
+}
+
+// Fills the pixels x0 to x1 (inclusive) of a row, four at a time with SSE2
+void SoftRasterizer::span(int y, int x0, int x1, uint32_t color){
+    if(y < 0 || y >= (int) height)
+        return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, (int) width - 1);
+
+    uint32_t* row = framebuffer.data() + (size_t) y * width;
+    int x = x0;
+#ifdef __SSE2__
+    __m128i c = _mm_set1_epi32(color);
+    for(; x + 3 <= x1; x += 4)
+        _mm_storeu_si128((__m128i*)(row + x), c);
+#endif
+    for(; x <= x1; x++)
+        row[x] = color;
+}
+
+// Bresenham, horizontal lines are handed to the span kernel
+void SoftRasterizer::line(int x0, int y0, int x1, int y1, uint32_t color){
+    if(y0 == y1){
+        span(y0, std::min(x0, x1), std::max(x0, x1), color);
+        return;
+    }
+
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while(true){
+        if(x0 >= 0 && x0 < (int) width && y0 >= 0 && y0 < (int) height)
+            framebuffer[(size_t) y0 * width + x0] = color;
+        if(x0 == x1 && y0 == y1)
+            return;
+        int e2 = 2 * err;
+        if(e2 >= dy){
+            err += dy;
+            x0 += sx;
+        }
+        if(e2 <= dx){
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// Scanline fill, a pixel is covered if its center lies inside the triangle.
+// The color is flat, all vertices of a display list triangle share one.
+void SoftRasterizer::triangle(const DISPLAY_VERTEX& a, const DISPLAY_VERTEX& b, const DISPLAY_VERTEX& c){
+    struct P{ float x, y; } v[3] = {
+        { (a.x + 1.0f) * 0.5f * width, (1.0f - a.y) * 0.5f * height },
+        { (b.x + 1.0f) * 0.5f * width, (1.0f - b.y) * 0.5f * height },
+        { (c.x + 1.0f) * 0.5f * width, (1.0f - c.y) * 0.5f * height }
+    };
+    std::sort(v, v + 3, [](const P& l, const P& r){ return l.y < r.y; });
+    if(v[2].y == v[0].y)
+        return;
+
+    uint32_t color = pack(a.r, a.g, a.b);
+    int yStart = std::max(0, (int) ceilf(v[0].y - 0.5f));
+    int yEnd   = std::min((int) height - 1, (int) ceilf(v[2].y - 0.5f) - 1);
+
+    for(int y = yStart; y <= yEnd; y++){
+        float cy = y + 0.5f;
+        // Long edge v0 -> v2 and the short edge of the current half
+        float xl = v[0].x + (v[2].x - v[0].x) * (cy - v[0].y) / (v[2].y - v[0].y);
+        float xr;
+        if(cy < v[1].y)
+            xr = v[0].x + (v[1].x - v[0].x) * (cy - v[0].y) / (v[1].y - v[0].y);
+        else if(v[2].y != v[1].y)
+            xr = v[1].x + (v[2].x - v[1].x) * (cy - v[1].y) / (v[2].y - v[1].y);
+        else
+            xr = v[1].x;
+        if(xl > xr)
+            std::swap(xl, xr);
+        int x0 = (int) ceilf(xl - 0.5f);
+        int x1 = (int) ceilf(xr - 0.5f) - 1;
+        if(x0 <= x1)
+            span(y, x0, x1, color);
+    }
+}
+
+// FNV-1a over 64 bit words, fast enough to hash every frame
+uint64_t SoftRasterizer::hash() const{
+    uint64_t h = 0xcbf29ce484222325ull;
+    const uint32_t* data = framebuffer.data();
+    size_t i = 0;
+    for(; i + 1 < framebuffer.size(); i += 2){
+        h ^= data[i] | ((uint64_t) data[i + 1] << 32);
+        h *= 0x100000001b3ull;
+    }
+    if(i < framebuffer.size()){
+        h ^= data[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+bool SoftRasterizer::writePPM(std::string path) const{
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+        return false;
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    std::vector<unsigned char> row(width * 3);
+    for(unsigned int y = 0; y < height; y++){
+        for(unsigned int x = 0; x < width; x++){
+            uint32_t p = framebuffer[(size_t) y * width + x];
+            row[3 * x]     = p & 0xFF;
+            row[3 * x + 1] = (p >> 8) & 0xFF;
+            row[3 * x + 2] = (p >> 16) & 0xFF;
+        }
+        fwrite(row.data(), 1, row.size(), file);
+    }
+    fclose(file);
+    return true;
+}
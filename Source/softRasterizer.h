@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "displayList.h"
+
+// CPU backend for DrawingDevice, renders into an in-memory RGBA framebuffer.
+// Draws the same things as OpenGLDevice: the single quad as line loop and the
+// display list frame, so headless runs can be checked pixel by pixel.
+// Every rendered frame can be dumped as PPM and/or hashed into a text stream.
+class SoftRasterizer{
+public:
+    SoftRasterizer(unsigned int width = 800, unsigned int height = 600);
+    ~SoftRasterizer();
+
+    // Renders a complete frame: background, quad outline, triangles and lines
+    void render(const float quad[8], const DISPLAY_VERTEX* lines, size_t lineVertices,
+                const DISPLAY_VERTEX* triangles, size_t triangleVertices);
+
+    // Frames are written to a pattern like "frame%05u.ppm". It holds one conversion of the frame
+    // number (%u or %d, optionally with a width and zero padding), %% is a percent sign.
+    // Returns false and dumps nothing if the pattern has another conversion or none.
+    bool dumpFrames(std::string pattern);
+    // Writes "<frame> <hash>" per frame, the file is not closed by the rasterizer
+    void hashFrames(FILE* file) { hashFile = file; }
+
+    // FNV-1a hash of the current framebuffer
+    uint64_t hash() const;
+    bool writePPM(std::string path) const;
+
+    const uint32_t* pixels() const { return framebuffer.data(); }
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+    unsigned long long frames() const { return frameCount; }
+
+private:
+    unsigned int width, height;
+    std::vector<uint32_t> framebuffer;  // RGBA, one uint32_t per pixel in memory order R, G, B, A
+    unsigned long long frameCount = 0;
+
+    std::string framePattern;
+    FILE* hashFile = nullptr;
+
+    static bool framePath(const std::string& pattern, unsigned long long frame, std::string& path);
+    static uint32_t pack(float r, float g, float b);
+    int toX(float x) const;
+    int toY(float y) const;
+
+    // Kernels
+    void span(int y, int x0, int x1, uint32_t color);
+    void line(int x0, int y0, int x1, int y1, uint32_t color);
+    void triangle(const DISPLAY_VERTEX& a, const DISPLAY_VERTEX& b, const DISPLAY_VERTEX& c);
+};
@@ -0,0 +1,804 @@
+#include "sourceAssembler.h"
+#include "assembler.h"
+
+#include <string.h>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+
+using MODE = Assembler::addressModeEnum;
+
+static const int MAX_DEPTH = 32;
+
+static std::string trim(const std::string& text){
+    size_t first = text.find_first_not_of(" \t");
+    if(first == std::string::npos)
+        return "";
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+static std::string upper(std::string text){
+    for(char& c : text)
+        c = toupper(c);
+    return text;
+}
+
+static std::string lower(std::string text){
+    for(char& c : text)
+        c = tolower(c);
+    return text;
+}
+
+static bool identStart(char c){ return isalpha((unsigned char) c) || c == '_' || c == '@'; }
+static bool identChar(char c){ return isalnum((unsigned char) c) || c == '_' || c == '@'; }
+
+// Index after the quoted text starting at i
+static size_t skipQuoted(const std::string& text, size_t i){
+    size_t end = text.find(text[i], i + 1);
+    return end == std::string::npos ? text.size() : end + 1;
+}
+
+static std::string stripComment(const std::string& text){
+    for(size_t i = 0; i < text.size(); ){
+        if(text[i] == '"' || text[i] == '\'')
+            i = skipQuoted(text, i);
+        else if(text[i] == ';')
+            return text.substr(0, i);
+        else
+            i++;
+    }
+    return text;
+}
+
+// Splits at the commas outside of quotes and parentheses
+static std::vector<std::string> splitArgs(const std::string& text){
+    std::vector<std::string> args;
+    int nesting = 0;
+    size_t start = 0;
+    for(size_t i = 0; i < text.size(); ){
+        if(text[i] == '"' || text[i] == '\''){
+            i = skipQuoted(text, i);
+            continue;
+        }
+        if(text[i] == '(') nesting++;
+        if(text[i] == ')') nesting--;
+        if(text[i] == ',' && nesting == 0){
+            args.push_back(trim(text.substr(start, i - start)));
+            start = i + 1;
+        }
+        i++;
+    }
+    if(!trim(text).empty())
+        args.push_back(trim(text.substr(start)));
+    return args;
+}
+
+static bool quoted(const std::string& text){
+    return text.size() >= 2 && text.front() == '"' && text.back() == '"';
+}
+
+static unsigned instructionSize(int mode){
+    switch(mode){
+        case MODE::Implicit:
+        case MODE::Accumulator:
+            return 1;
+        case MODE::Absolute:
+        case MODE::AbsoluteX:
+        case MODE::AbsoluteY:
+        case MODE::Indirect:
+        case MODE::AbsoluteIndirectX:
+            return 3;
+    }
+    return 2;
+}
+
+OBJECT SourceAssembler::assemble(const std::string& path){
+    reset(path);
+    source(readDependency(path), path);
+    return finish();
+}
+
+OBJECT SourceAssembler::assembleText(const std::string& text, const std::string& name){
+    reset(name);
+    source(text, name);
+    return finish();
+}
+
+void SourceAssembler::reset(const std::string& name){
+    object = OBJECT();
+    object.source = name;
+    symbols.clear();
+    macros.clear();
+    lines.clear();
+    conditions.clear();
+    sizes.clear();
+    secondPass = false;
+    recording = nullptr;
+    uses = 0;
+    depth = 0;
+    file = where = name;
+    for(const auto& [define, value] : defines)
+        symbols[define] = {-1, value};
+    selectSection("code", -1);
+}
+
+OBJECT SourceAssembler::finish(){
+    if(recording)
+        error(".macro without .endmacro");
+    if(!conditions.empty())
+        error(".if without .endif");
+
+    // All symbols of the file are known now, only those of other files are left to the linker
+    secondPass = true;
+    for(size_t i = 0; i < sizes.size(); i++)
+        object.sections[i].data.reserve(sizes[i]);
+    for(const LINE& line : lines)
+        emit(line);
+
+    for(const auto& [name, symbol] : symbols){
+        if(!defines.count(name))
+            object.symbols.push_back({name, symbol.section, symbol.value, name[0] != '@'});
+    }
+    return std::move(object);
+}
+
+void SourceAssembler::source(const std::string& text, const std::string& path){
+    if(++depth > MAX_DEPTH)
+        error("includes or macros nested too deep");
+    std::string including = file;
+    file = path;
+
+    std::istringstream in(text);
+    std::string row;
+    for(int number = 1; std::getline(in, row); number++){
+        if(!row.empty() && row.back() == '\r')
+            row.pop_back();
+        where = path + ":" + std::to_string(number);
+        line(row);
+    }
+
+    file = including;
+    depth--;
+}
+
+void SourceAssembler::line(const std::string& text){
+    std::string s = trim(stripComment(text));
+    if(s.empty())
+        return;
+    std::string first = s.substr(0, s.find_first_of(" \t"));
+    std::string word = lower(first);
+
+    if(recording){
+        if(word == ".endmacro")
+            recording = nullptr;
+        else if(word == ".macro")
+            error("macros can't be defined inside a macro");
+        else
+            recording->body.push_back(s);
+        return;
+    }
+
+    // Conditionals are followed while skipping as well, to find the matching .endif
+    if(word == ".if" || word == ".ifdef" || word == ".ifndef"){
+        bool parent = conditions.empty() || conditions.back().active;
+        bool active = false;
+        if(parent){
+            std::string arg = trim(s.substr(first.size()));
+            if(word == ".if")
+                active = constant(arg) != 0;
+            else
+                active = (symbols.count(arg) != 0) == (word == ".ifdef");
+        }
+        conditions.push_back({active, active, parent});
+        return;
+    }
+    if(word == ".else"){
+        if(conditions.empty())
+            error(".else without .if");
+        CONDITION& condition = conditions.back();
+        condition.active = condition.parentActive && !condition.taken;
+        condition.taken = true;
+        return;
+    }
+    if(word == ".endif"){
+        if(conditions.empty())
+            error(".endif without .if");
+        conditions.pop_back();
+        return;
+    }
+    if(!conditions.empty() && !conditions.back().active)
+        return;
+
+    size_t n = 0;
+    while(n < s.size() && (n ? identChar(s[n]) : identStart(s[n])))
+        n++;
+    if(n > 0 && n < s.size() && s[n] == ':'){
+        define(s.substr(0, n), section, sizes[section]);
+        s = trim(s.substr(n + 1));
+        if(s.empty())
+            return;
+        first = s.substr(0, s.find_first_of(" \t"));
+        word = lower(first);
+    }
+    else if(n > 0){
+        size_t equals = s.find_first_not_of(" \t", n);
+        if(equals != std::string::npos && s[equals] == '='){
+            VALUE value = evaluate(s.substr(equals + 1));
+            if(value.unknown || !value.symbol.empty() || value.part)
+                error("the value of " + s.substr(0, n) + " has to be known at this point");
+            define(s.substr(0, n), value.section, value.value);
+            return;
+        }
+    }
+
+    std::string operand = trim(s.substr(first.size()));
+    if(word[0] == '.')
+        directive(word, operand);
+    else if(Assembler::isMnemonic(upper(first)))
+        instruction(upper(first), operand);
+    else if(macros.count(first))
+        expand(first, operand);
+    else
+        error("unknown instruction " + first);
+}
+
+void SourceAssembler::directive(const std::string& word, const std::string& operand){
+    if(word == ".include"){
+        if(!quoted(operand))
+            error(".include needs a \"file\"");
+        std::string path = findFile(operand.substr(1, operand.size() - 2));
+        std::string including = where;
+        source(readDependency(path), path);
+        where = including;
+    }
+    else if(word == ".incbin"){
+        if(!quoted(operand))
+            error(".incbin needs a \"file\"");
+        std::string content = readDependency(findFile(operand.substr(1, operand.size() - 2)));
+        LINE line{where, ".incbin", "", 0, section, sizes[section], std::vector<BYTE>(content.begin(), content.end())};
+        lines.push_back(line);
+        advance(content.size());
+    }
+    else if(word == ".macro"){
+        std::string name = operand.substr(0, operand.find_first_of(" \t"));
+        if(name.empty() || !identStart(name[0]))
+            error(".macro needs a name");
+        if(macros.count(name) || Assembler::isMnemonic(upper(name)))
+            error("macro " + name + " defined twice");
+        recording = &macros[name];
+        recording->params = splitArgs(operand.substr(name.size()));
+    }
+    else if(word == ".endmacro")
+        error(".endmacro without .macro");
+    else if(word == ".section")
+        selectSection(quoted(operand) ? operand.substr(1, operand.size() - 2) : operand, -1);
+    else if(word == ".code" || word == ".data")
+        selectSection(word.substr(1), -1);
+    else if(word == ".org"){
+        long org = constant(operand);
+        if(org < 0 || org > 0xFFFF)
+            error(".org outside of the address space");
+        selectSection(object.sections[section].name, org);
+    }
+    else if(word == ".byte" || word == ".db"){
+        unsigned size = 0;
+        for(const std::string& arg : splitArgs(operand))
+            size += quoted(arg) ? arg.size() - 2 : 1;
+        lines.push_back({where, ".byte", operand, 0, section, sizes[section], {}});
+        advance(size);
+    }
+    else if(word == ".word" || word == ".dw"){
+        lines.push_back({where, ".word", operand, 0, section, sizes[section], {}});
+        advance(2 * splitArgs(operand).size());
+    }
+    else if(word == ".res" || word == ".ds"){
+        std::vector<std::string> args = splitArgs(operand);
+        if(args.empty() || args.size() > 2)
+            error(".res needs a count and an optional fill value");
+        long count = constant(args[0]);
+        long fill = args.size() > 1 ? constant(args[1]) : 0;
+        if(count < 0 || count > 0x10000)
+            error(".res count out of range");
+        lines.push_back({where, ".res", "", 0, section, sizes[section], std::vector<BYTE>(count, fill)});
+        advance(count);
+    }
+    else if(word == ".error")
+        error(quoted(operand) ? operand.substr(1, operand.size() - 2) : operand);
+    else
+        error("unknown directive " + word);
+}
+
+void SourceAssembler::instruction(const std::string& name, const std::string& operand){
+    auto has = [&](int mode){ return Assembler::opcode(name, (MODE) mode) >= 0; };
+    std::string expression = operand;
+    int mode = MODE::Implicit;
+    int kind = operandKind(name, expression);
+
+    switch(kind){
+        case OpNone:        mode = has(MODE::Implicit) ? MODE::Implicit : MODE::Accumulator; break;
+        case OpAccumulator: mode = MODE::Accumulator; break;
+        case OpImmediate:   mode = MODE::Immediate; break;
+        case OpIndirect:    mode = has(MODE::Indirect) ? MODE::Indirect : MODE::ZeroPageIndirect; break;
+        case OpIndirectX:   mode = has(MODE::IndirectX) ? MODE::IndirectX : MODE::AbsoluteIndirectX; break;
+        case OpIndirectY:   mode = MODE::IndirectY; break;
+        case OpAddress:
+        case OpAddressX:
+        case OpAddressY:{
+            if(kind == OpAddress && has(MODE::Relative)){
+                mode = MODE::Relative;
+                break;
+            }
+            int zeroPage = kind == OpAddress ? MODE::ZeroPage : kind == OpAddressX ? MODE::ZeroPageX : MODE::ZeroPageY;
+            int absolute = kind == OpAddress ? MODE::Absolute : kind == OpAddressX ? MODE::AbsoluteX : MODE::AbsoluteY;
+            // Zero page only for values known by now, the second pass has to emit the same size
+            VALUE value = evaluate(expression);
+            bool narrow = value.part != PartNone || (value.constant() && value.value >= 0 && value.value <= 0xFF);
+            mode = (narrow && has(zeroPage)) || !has(absolute) ? zeroPage : absolute;
+        }
+        break;
+    }
+    if(!has(mode))
+        error(name + " doesn't have this addressing mode");
+
+    lines.push_back({where, name, expression, mode, section, sizes[section], {}});
+    advance(instructionSize(mode));
+}
+
+// Kind of the operand, leaves only the expression in it
+int SourceAssembler::operandKind(const std::string& name, std::string& operand){
+    auto has = [&](int mode){ return Assembler::opcode(name, (MODE) mode) >= 0; };
+    std::string s;
+    for(size_t i = 0; i < operand.size(); ){
+        if(operand[i] == '"' || operand[i] == '\''){
+            size_t end = skipQuoted(operand, i);
+            s += operand.substr(i, end - i);
+            i = end;
+        }
+        else if(operand[i] != ' ' && operand[i] != '\t')
+            s += operand[i++];
+        else
+            i++;
+    }
+    std::string u = upper(s);
+
+    if(s.empty()){
+        if(!has(MODE::Implicit) && !has(MODE::Accumulator))
+            error(name + " needs an operand");
+        return OpNone;
+    }
+    if(has(MODE::Implicit))
+        error(name + " has no operand");
+    if(u == "A" && has(MODE::Accumulator))
+        return OpAccumulator;
+    if(s[0] == '#'){
+        operand = s.substr(1);
+        return OpImmediate;
+    }
+    if(s[0] == '('){
+        size_t close = 0;
+        int nesting = 0;
+        for(size_t i = 0; i < s.size(); i++){
+            if(s[i] == '(') nesting++;
+            if(s[i] == ')' && --nesting == 0){
+                close = i;
+                break;
+            }
+        }
+        if(close + 1 == s.size() && u.size() > 4 && u.substr(close - 2, 2) == ",X"){
+            operand = s.substr(1, close - 3);
+            return OpIndirectX;
+        }
+        if(close + 1 == s.size() && (has(MODE::Indirect) || has(MODE::ZeroPageIndirect))){
+            operand = s.substr(1, close - 1);
+            return OpIndirect;
+        }
+        if(u.substr(close + 1) == ",Y" && has(MODE::IndirectY)){
+            operand = s.substr(1, close - 1);
+            return OpIndirectY;
+        }
+    }
+    if(u.size() > 2 && u.substr(u.size() - 2) == ",X"){
+        operand = s.substr(0, s.size() - 2);
+        return OpAddressX;
+    }
+    if(u.size() > 2 && u.substr(u.size() - 2) == ",Y"){
+        operand = s.substr(0, s.size() - 2);
+        return OpAddressY;
+    }
+    operand = s;
+    return OpAddress;
+}
+
+void SourceAssembler::expand(const std::string& name, const std::string& operand){
+    const MACRO& macro = macros[name];
+    std::vector<std::string> args = splitArgs(operand);
+    if(args.size() != macro.params.size())
+        error(name + " takes " + std::to_string(macro.params.size()) + " arguments");
+    if(++depth > MAX_DEPTH)
+        error("includes or macros nested too deep");
+
+    // Parameters are replaced as whole names, outside of quotes and numbers
+    std::string unique = std::to_string(++uses);
+    std::string caller = where;
+    for(const std::string& body : macro.body){
+        std::string text;
+        for(size_t i = 0; i < body.size(); ){
+            if(body[i] == '"' || body[i] == '\''){
+                size_t end = skipQuoted(body, i);
+                text += body.substr(i, end - i);
+                i = end;
+            }
+            else if(body[i] == '\\' && i + 1 < body.size() && body[i + 1] == '@'){
+                text += unique;
+                i += 2;
+            }
+            else if(identStart(body[i]) || isdigit((unsigned char) body[i]) || body[i] == '$'){
+                size_t end = i + 1;
+                while(end < body.size() && identChar(body[end]))
+                    end++;
+                std::string token = body.substr(i, end - i);
+                size_t param = 0;
+                while(param < macro.params.size() && macro.params[param] != token)
+                    param++;
+                text += param < macro.params.size() ? args[param] : token;
+                i = end;
+            }
+            else
+                text += body[i++];
+        }
+        where = caller + " (" + name + ")";
+        line(text);
+    }
+    where = caller;
+    depth--;
+}
+
+void SourceAssembler::define(const std::string& name, int section, long value){
+    if(symbols.count(name))
+        error(name + " defined twice");
+    symbols[name] = {section, value};
+}
+
+// Continues the section of that name, a fixed address always starts a new one
+void SourceAssembler::selectSection(const std::string& name, long org){
+    if(name.empty())
+        error(".section needs a name");
+    if(org < 0){
+        for(size_t i = 0; i < object.sections.size(); i++){
+            if(object.sections[i].name == name && object.sections[i].org < 0){
+                section = i;
+                return;
+            }
+        }
+    }
+    object.sections.push_back({name, org, {}});
+    sizes.push_back(0);
+    section = object.sections.size() - 1;
+}
+
+void SourceAssembler::advance(unsigned size){
+    sizes[section] += size;
+    long org = object.sections[section].org;
+    if((org < 0 ? 0 : org) + sizes[section] > 0x10000)
+        error("section " + object.sections[section].name + " doesn't fit into the address space");
+}
+
+std::string SourceAssembler::findFile(const std::string& name){
+    std::vector<std::string> candidates;
+    if(name[0] == '/')
+        candidates.push_back(name);
+    else{
+        size_t slash = file.rfind('/');
+        candidates.push_back(slash == std::string::npos ? name : file.substr(0, slash + 1) + name);
+        for(const std::string& dir : includeDirs)
+            candidates.push_back(dir + "/" + name);
+    }
+    for(const std::string& path : candidates){
+        if(std::ifstream(path))
+            return path;
+    }
+    error("can't find " + name);
+}
+
+std::string SourceAssembler::readDependency(const std::string& path){
+    std::string content;
+    if(!readFile(path, content))
+        error("can't read " + path);
+    bool known = false;
+    for(const OBJECT::DEPENDENCY& dependency : object.dependencies)
+        known |= dependency.path == path;
+    if(!known)
+        object.dependencies.push_back({path, contentHash(content)});
+    return content;
+}
+
+void SourceAssembler::emit(const LINE& line){
+    where = line.where;
+    section = line.section;
+    lineOffset = line.offset;
+    std::vector<BYTE>& data = object.sections[section].data;
+    if(data.size() != line.offset)
+        error("the passes disagree about the size of the code before this line");
+
+    if(line.word == ".incbin" || line.word == ".res")
+        data.insert(data.end(), line.bytes.begin(), line.bytes.end());
+    else if(line.word == ".byte"){
+        for(const std::string& arg : splitArgs(line.operand)){
+            if(quoted(arg))
+                data.insert(data.end(), arg.begin() + 1, arg.end() - 1);
+            else
+                emitByte(evaluate(arg));
+        }
+    }
+    else if(line.word == ".word"){
+        for(const std::string& arg : splitArgs(line.operand))
+            emitWord(evaluate(arg));
+    }
+    else{
+        object.lines.push_back({section, line.offset, line.where});
+        data.push_back(Assembler::opcode(line.word, (MODE) line.mode));
+        switch(line.mode){
+            case MODE::Implicit:
+            case MODE::Accumulator:
+                break;
+            case MODE::Relative:
+                emitBranch(evaluate(line.operand));
+                break;
+            case MODE::Absolute:
+            case MODE::AbsoluteX:
+            case MODE::AbsoluteY:
+            case MODE::Indirect:
+            case MODE::AbsoluteIndirectX:
+                emitWord(evaluate(line.operand));
+                break;
+            default:
+                emitByte(evaluate(line.operand));
+        }
+    }
+}
+
+void SourceAssembler::relocate(BYTE kind, const VALUE& value){
+    object.relocations.push_back({section, (unsigned) object.sections[section].data.size(), kind, value.symbol, value.section, value.value});
+}
+
+void SourceAssembler::emitByte(const VALUE& value){
+    std::vector<BYTE>& data = object.sections[section].data;
+    if(value.constant()){
+        if(value.value < -128 || value.value > 0xFF)
+            error("value " + std::to_string(value.value) + " doesn't fit into a byte");
+        data.push_back(value.value & 0xFF);
+        return;
+    }
+    relocate(value.part == PartLow ? OBJECT::RelocLow : value.part == PartHigh ? OBJECT::RelocHigh : OBJECT::RelocByte, value);
+    data.push_back(0);
+}
+
+void SourceAssembler::emitWord(const VALUE& value){
+    std::vector<BYTE>& data = object.sections[section].data;
+    if(value.part != PartNone)
+        error("< and > give a byte, not an address");
+    if(value.constant()){
+        if(value.value < -0x8000 || value.value > 0xFFFF)
+            error("value " + std::to_string(value.value) + " doesn't fit into a word");
+        data.push_back(value.value & 0xFF);
+        data.push_back((value.value >> 8) & 0xFF);
+        return;
+    }
+    relocate(OBJECT::RelocWord, value);
+    data.push_back(0);
+    data.push_back(0);
+}
+
+// Branches within a section are resolved here, others by the linker
+void SourceAssembler::emitBranch(const VALUE& value){
+    std::vector<BYTE>& data = object.sections[section].data;
+    long org = object.sections[section].org;
+    long next = data.size() + 1;
+    if(value.part != PartNone)
+        error("< and > give a byte, not an address");
+
+    long distance;
+    if(value.symbol.empty() && value.section == section)
+        distance = value.value - next;
+    else if(value.constant() && org >= 0)
+        distance = value.value - (org + next);
+    else{
+        relocate(OBJECT::RelocBranch, value);
+        data.push_back(0);
+        return;
+    }
+    if(distance < -128 || distance > 127)
+        error("branch out of range (" + std::to_string(distance) + " bytes)");
+    data.push_back(distance & 0xFF);
+}
+
+void SourceAssembler::error(const std::string& message) const{
+    throw std::invalid_argument{where + ": " + message};
+}
+
+SourceAssembler::VALUE SourceAssembler::evaluate(const std::string& text){
+    const char* p = text.c_str();
+    VALUE value = parseBinary(p, 0);
+    while(isspace((unsigned char) *p))
+        p++;
+    if(*p)
+        error("unexpected " + std::string(p) + " in " + trim(text));
+    return value;
+}
+
+long SourceAssembler::constant(const std::string& text){
+    VALUE value = evaluate(text);
+    if(!value.constant())
+        error(trim(text) + " has to be a constant defined before this line");
+    return value.value;
+}
+
+// Operators from the lowest to the highest precedence, the unary ones are above all
+SourceAssembler::VALUE SourceAssembler::parseBinary(const char*& p, int level){
+    static const std::vector<std::vector<std::string>> operators = {
+        {"|"}, {"^"}, {"&"}, {"<<", ">>"}, {"+", "-"}, {"*", "/", "%"}
+    };
+    if(level == (int) operators.size())
+        return parseUnary(p);
+
+    VALUE value = parseBinary(p, level + 1);
+    for(;;){
+        while(isspace((unsigned char) *p))
+            p++;
+        std::string op;
+        for(const std::string& candidate : operators[level]){
+            if(!strncmp(p, candidate.c_str(), candidate.size()))
+                op = candidate;
+        }
+        if(op.empty())
+            return value;
+        p += op.size();
+        value = combine(op, value, parseBinary(p, level + 1));
+    }
+}
+
+SourceAssembler::VALUE SourceAssembler::parseUnary(const char*& p){
+    while(isspace((unsigned char) *p))
+        p++;
+    char op = *p;
+    if(op != '-' && op != '~' && op != '<' && op != '>')
+        return parsePrimary(p);
+
+    p++;
+    VALUE value = parseUnary(p);
+    if(value.unknown)
+        return value;
+    if(op == '-' || op == '~'){
+        if(!value.constant())
+            error(std::string(1, op) + " needs a constant");
+        value.value = op == '-' ? -value.value : ~value.value;
+    }
+    else if(value.part != PartNone)
+        error("< or > applied twice");
+    else if(value.constant())
+        value.value = op == '<' ? value.value & 0xFF : (value.value >> 8) & 0xFF;
+    else
+        value.part = op == '<' ? PartLow : PartHigh;
+    return value;
+}
+
+SourceAssembler::VALUE SourceAssembler::parsePrimary(const char*& p){
+    VALUE value;
+    char* end;
+    while(isspace((unsigned char) *p))
+        p++;
+
+    if(*p == '('){
+        p++;
+        value = parseBinary(p, 0);
+        while(isspace((unsigned char) *p))
+            p++;
+        if(*p != ')')
+            error("missing )");
+        p++;
+        return value;
+    }
+    if(*p == '$' || *p == '%' || isdigit((unsigned char) *p)){
+        int base = 10;
+        if(*p == '$')
+            base = 16, p++;
+        else if(*p == '%')
+            base = 2, p++;
+        else if(p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+            base = 16, p += 2;
+        value.value = strtol(p, &end, base);
+        if(end == p || identChar(*end))
+            error("bad number");
+        p = end;
+        return value;
+    }
+    if(*p == '\''){
+        if(!p[1] || p[2] != '\'')
+            error("bad character constant");
+        value.value = (unsigned char) p[1];
+        p += 3;
+        return value;
+    }
+
+    // Labels of sections with a fixed address are constants
+    auto located = [&](int section, long offset){
+        if(section >= 0 && object.sections[section].org >= 0){
+            value.value = object.sections[section].org + offset;
+            return value;
+        }
+        value.section = section;
+        value.value = offset;
+        return value;
+    };
+    if(*p == '*'){
+        p++;
+        return located(section, secondPass ? lineOffset : sizes[section]);
+    }
+    if(identStart(*p)){
+        const char* start = p;
+        while(identChar(*p))
+            p++;
+        std::string name(start, p);
+        auto symbol = symbols.find(name);
+        if(symbol != symbols.end())
+            return located(symbol->second.section, symbol->second.value);
+        if(!secondPass)
+            value.unknown = true;
+        else if(name[0] == '@')
+            error("undefined local symbol " + name);
+        else
+            value.symbol = name;
+        return value;
+    }
+    error(*p ? "bad expression at " + std::string(p) : "missing value");
+}
+
+SourceAssembler::VALUE SourceAssembler::combine(const std::string& op, VALUE a, VALUE b){
+    if(a.unknown || b.unknown){
+        VALUE value;
+        value.unknown = true;
+        return value;
+    }
+    if(a.part != PartNone || b.part != PartNone)
+        error("< and > apply to the whole expression, use <(...)");
+
+    if(a.constant() && b.constant()){
+        long x = a.value, y = b.value;
+        if((op == "/" || op == "%") && y == 0)
+            error("division by zero");
+        if(op == "|") a.value = x | y;
+        else if(op == "^") a.value = x ^ y;
+        else if(op == "&") a.value = x & y;
+        else if(op == "<<") a.value = x << y;
+        else if(op == ">>") a.value = x >> y;
+        else if(op == "+") a.value = x + y;
+        else if(op == "-") a.value = x - y;
+        else if(op == "*") a.value = x * y;
+        else if(op == "/") a.value = x / y;
+        else a.value = x % y;
+        return a;
+    }
+
+    // Addresses only known to the linker can be moved by a constant, or subtracted
+    // from an address of the same section
+    if(op == "+"){
+        if(a.constant())
+            std::swap(a, b);
+        if(b.constant()){
+            a.value += b.value;
+            return a;
+        }
+    }
+    else if(op == "-"){
+        if(b.constant()){
+            a.value -= b.value;
+            return a;
+        }
+        if(a.section == b.section && a.symbol == b.symbol){
+            VALUE value;
+            value.value = a.value - b.value;
+            return value;
+        }
+    }
+    error("the operands of " + op + " aren't known before linking");
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "objectFile.h"
+
+// Assembles a source file into a relocatable OBJECT, which Linker combines with the objects of
+// the other files of a program. Unlike Assembler it reads whole files:
+//
+//   ; comment
+//   SCREEN = $0800                 constant
+//   start:  lda #<message          label, < and > take the low and high byte
+//           jsr print              symbols of other files are resolved by the linker
+//   @loop:  dex                    names starting with @ are local to the file
+//           bne @loop
+//
+//   .include "file"   .incbin "file"          searched next to the file, then in includeDirs
+//   .macro name a, b  ...  .endmacro          \@ in the body expands to a number unique per use
+//   .if expr  .ifdef name  .ifndef name  .else  .endif
+//   .section name  .code  .data  .org addr    the linker places sections, .org fixes the address
+//   .byte expr, "text"  .word expr  .res count, fill  .error "message"
+//
+// Numbers are decimal, $hex, %binary or 'c'. Expressions use + - * / % & | ^ << >> ~ and
+// parentheses, * alone is the current address.
+// Errors throw std::invalid_argument, prefixed with file:line.
+class SourceAssembler{
+public:
+    // Searched for .include and .incbin after the directory of the including file
+    std::vector<std::string> includeDirs;
+    // Constants defined before the source is read, like -D of a compiler
+    std::map<std::string, long> defines;
+
+    OBJECT assemble(const std::string& path);
+    OBJECT assembleText(const std::string& text, const std::string& name = "<text>");
+
+private:
+    // Result of an expression: a constant, an offset into a section of this file or a symbol
+    // of another file plus an offset
+    struct VALUE{
+        long value = 0;
+        int section = -1;
+        std::string symbol;
+        BYTE part = 0;              // PartLow or PartHigh
+        bool unknown = false;       // Refers to a symbol not defined yet (first pass)
+        bool constant() const { return section < 0 && symbol.empty() && !unknown; }
+    };
+    enum PARTS{ PartNone, PartLow, PartHigh };
+
+    enum OPERANDS{ OpNone, OpAccumulator, OpImmediate, OpAddress, OpAddressX, OpAddressY, OpIndirect, OpIndirectX, OpIndirectY };
+
+    // An instruction or data directive found by the first pass, emitted by the second
+    struct LINE{
+        std::string where;
+        std::string word;           // Mnemonic or directive
+        std::string operand;
+        int mode = 0;               // Assembler::addressModeEnum of instructions
+        int section = 0;
+        unsigned offset = 0;
+        std::vector<BYTE> bytes;    // Of .incbin and .res
+    };
+
+    struct SYMBOL{
+        int section;
+        long value;
+    };
+
+    struct MACRO{
+        std::vector<std::string> params;
+        std::vector<std::string> body;
+    };
+
+    struct CONDITION{
+        bool active;                // Lines are assembled
+        bool taken;                 // A branch of this .if was assembled already
+        bool parentActive;
+    };
+
+    OBJECT object;
+    std::map<std::string, SYMBOL> symbols;
+    std::map<std::string, MACRO> macros;
+    std::vector<LINE> lines;
+    std::vector<CONDITION> conditions;
+    std::vector<unsigned> sizes;    // Of the sections, while the first pass lays them out
+    int section = 0;
+    bool secondPass = false;
+    unsigned lineOffset = 0;        // Of the line emitted by the second pass, for *
+    std::string file;               // Being read, includes are searched next to it
+    std::string where;
+
+    MACRO* recording = nullptr;     // Between .macro and .endmacro
+    unsigned uses = 0;              // Of macros, for \@
+    int depth = 0;                  // Of includes and macro uses
+
+    void reset(const std::string& name);
+    OBJECT finish();
+    void source(const std::string& text, const std::string& path);
+    void line(const std::string& text);
+    void directive(const std::string& word, const std::string& operand);
+    void instruction(const std::string& mnemonic, const std::string& operand);
+    void expand(const std::string& name, const std::string& operand);
+    void define(const std::string& name, int section, long value);
+    void selectSection(const std::string& name, long org);
+    std::string findFile(const std::string& name);
+    std::string readDependency(const std::string& path);
+    void advance(unsigned size);
+
+    int operandKind(const std::string& mnemonic, std::string& operand);
+    void emit(const LINE& line);
+    void emitByte(const VALUE& value);
+    void emitWord(const VALUE& value);
+    void emitBranch(const VALUE& value);
+    void relocate(BYTE kind, const VALUE& value);
+
+    VALUE evaluate(const std::string& text);
+    long constant(const std::string& text);
+    VALUE parseBinary(const char*& p, int level);
+    VALUE parseUnary(const char*& p);
+    VALUE parsePrimary(const char*& p);
+    VALUE combine(const std::string& op, VALUE a, VALUE b);
+
+    [[noreturn]] void error(const std::string& message) const;
+};
@@ -0,0 +1,52 @@
+#include "timerDevice.h"
+#include "bus.h"
+
+TimerDevice::TimerDevice(){
+    // Does nothing
+}
+
+TimerDevice::~TimerDevice(){
+    // Does nothing
+}
+
+void TimerDevice::ConnectBus(Bus* ptr){
+    bus = ptr;
+    bus->scheduler.spawn([this]{ return run(0); });
+}
+
+// Continues with the control value the restored memory holds
+void TimerDevice::restart(){
+    BYTE control = read(CONTROL);
+    bus->scheduler.spawn([this, control]{ return run(control); });
+}
+
+BYTE TimerDevice::read(WORD addr){
+    return bus->read(addr);
+}
+
+void TimerDevice::write(WORD addr, BYTE data){
+    bus->write(addr, data);
+}
+
+// The whole device: wait for a start, then for the period or a new control value
+Scheduler::TASK TimerDevice::run(BYTE control){
+    Scheduler& scheduler = bus->scheduler;
+    while(true){
+        if(!(control & Run)){
+            control = co_await scheduler.write(CONTROL);
+            continue;
+        }
+        unsigned period = read(PERIOD) | read(PERIOD + 1) << 8;
+        std::optional<BYTE> written = co_await scheduler.write(CONTROL, period ? period : 1);
+        if(written){
+            control = *written;
+            continue;
+        }
+
+        write(COUNT, read(COUNT) + 1);
+        if(control & Irq)
+            co_await scheduler.interrupt();
+        if(!(control & Periodic))
+            control = 0;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "datatypes.h"
+#include "scheduler.h"
+
+class Bus;
+
+// Interval timer, the first device written as a coroutine of the Scheduler.
+// Registers (0x0250 - 0x0253):
+//   0x0250, 0x0251  period in cycles (lo, hi), 0 counts as 1
+//   0x0252          control, see CONTROL. A write (re)starts the timer with the period
+//                   in 0x0250 - 0x0251, 0 stops it
+//   0x0253          counts the expirations, wraps around
+// With Irq set, every expiration requests an interrupt, the next period starts once the CPU
+// has taken it. Control writes while the timer waits for that are missed.
+class TimerDevice{
+public:
+    TimerDevice();
+    ~TimerDevice();
+
+    // Starts the coroutine on the scheduler of the bus
+    void ConnectBus(Bus* ptr);
+    // Starts it again after Scheduler::reset(), a running timer begins a new period
+    void restart();
+
+    static const WORD START   = 0x0250;
+    static const WORD END     = 0x0253;
+    static const WORD PERIOD  = 0x0250;
+    static const WORD CONTROL = 0x0252;
+    static const WORD COUNT   = 0x0253;
+
+    enum CONTROL_BITS{
+        Run      = 0x01,
+        Periodic = 0x02,  // Otherwise the timer stops after one period
+        Irq      = 0x80
+    };
+
+private:
+    Bus* bus = nullptr;
+
+    BYTE read(WORD addr);
+    void write(WORD addr, BYTE data);
+
+    Scheduler::TASK run(BYTE control);
+};
@@ -0,0 +1,72 @@
+#include "videoDevice.h"
+#include "bus.h"
+
+VideoDevice::VideoDevice(){
+    dirtyRows[0] = dirtyRows[1] = 0;
+    for(uint32_t& pixel : frame)
+        pixel = 0xFF000000;
+}
+
+VideoDevice::~VideoDevice(){
+    // Does nothing
+}
+
+bool VideoDevice::refresh(){
+    unsigned long long pages[4];
+    bus->takeWrites(pages);
+    shown = bus->read(CONTROL) & 0x01;
+    if(pages[START >> 14] & (1ULL << ((START >> 8) & 63)))
+        loadPalette();
+
+    // Rows to convert now, 4 per written page
+    unsigned long long fresh[2] = {};
+    if(paletteChanged){
+        fresh[0] = ~0ULL;
+        fresh[1] = (1ULL << (HEIGHT - 64)) - 1;
+        paletteChanged = false;
+    }
+    else{
+        for(unsigned page = FRAME_START >> 8; page <= FRAME_END >> 8; page++){
+            if(!(pages[page >> 6] & (1ULL << (page & 63))))
+                continue;
+            unsigned first = (page - (FRAME_START >> 8)) * 4;
+            fresh[first >> 6] |= 0xFULL << (first & 63);
+        }
+    }
+    if(!(fresh[0] | fresh[1]))
+        return false;
+
+    for(unsigned i = 0; i < 2; i++){
+        for(unsigned long long bits = fresh[i]; bits; bits &= bits - 1)
+            convert(i * 64 + __builtin_ctzll(bits));
+        dirtyRows[i] |= fresh[i];
+    }
+    return true;
+}
+
+void VideoDevice::clean(){
+    dirtyRows[0] = dirtyRows[1] = 0;
+}
+
+void VideoDevice::loadPalette(){
+    for(unsigned i = 0; i < 16; i++){
+        uint32_t color = bus->read(PALETTE + 3 * i)
+                      | bus->read(PALETTE + 3 * i + 1) << 8
+                      | bus->read(PALETTE + 3 * i + 2) << 16
+                      | 0xFF000000;
+        if(color != palette[i])
+            paletteChanged = true;
+        palette[i] = color;
+    }
+}
+
+void VideoDevice::convert(unsigned row){
+    uint32_t* out = frame + row * WIDTH;
+    WORD addr = FRAME_START + row * PITCH;
+    for(unsigned i = 0; i < PITCH; i++){
+        BYTE pair = bus->read(addr + i);
+        out[2 * i] = palette[pair >> 4];
+        out[2 * i + 1] = palette[pair & 0x0F];
+    }
+    rows++;
+}
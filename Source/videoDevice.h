@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "datatypes.h"
+
+class Bus;
+
+// Bitmap display, shown by the OpenGL window of DrawingDevice behind its quad and display lists.
+// The framebuffer is plain RAM: 128 x 96 pixels with 4 bits each, two pixels per byte (the left
+// one in the high nibble), 64 bytes per row from 0x4000 to 0x57FF.
+// Registers (0x0200 - 0x0230):
+//   0x0200                 bit 0 shows the bitmap
+//   0x0201 + 3n .. + 2     red, green, blue of color n (16 colors)
+// The bus marks every page it writes, refresh() only converts the rows of the pages written since
+// the last frame (4 rows per page) and leaves them marked for the backend, which uploads just
+// those. A change of the palette marks the whole frame.
+class VideoDevice{
+public:
+    VideoDevice();
+    ~VideoDevice();
+
+    void ConnectBus(Bus* ptr) { bus = ptr; }
+
+    static const WORD START       = 0x0200;
+    static const WORD END         = 0x0230;
+    static const WORD CONTROL     = 0x0200;
+    static const WORD PALETTE     = 0x0201;
+    static const WORD FRAME_START = 0x4000;
+    static const unsigned WIDTH   = 128;
+    static const unsigned HEIGHT  = 96;
+    static const unsigned PITCH   = WIDTH / 2;     // Bytes per row
+    static const WORD FRAME_END   = FRAME_START + PITCH * HEIGHT - 1;
+
+    // Picks up the writes since the last call and converts the rows they touched.
+    // Returns true if a row changed.
+    bool refresh();
+    bool enabled() { return shown; }
+
+    // RGBA pixels of the whole frame, one uint32_t per pixel in memory order R, G, B, A
+    const uint32_t* pixels() const { return frame; }
+    // Rows which changed since clean()
+    bool dirty(unsigned row) const { return dirtyRows[row >> 6] & (1ULL << (row & 63)); }
+    void clean();
+
+    // Rows converted, for Metrics
+    unsigned long long rows = 0;
+
+private:
+    Bus* bus = nullptr;
+
+    bool shown = false;
+    uint32_t palette[16] = {};
+    uint32_t frame[WIDTH * HEIGHT];
+    unsigned long long dirtyRows[2];
+    bool paletteChanged = true;     // The first frame converts everything
+
+    void loadPalette();
+    void convert(unsigned row);
+};
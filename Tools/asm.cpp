@@ -0,0 +1,127 @@
+// Builds a program from several source files with SourceAssembler and Linker.
+// Every file is assembled into its own object, which is cached in the cache directory under
+// the hash of its path, content, options and CPU variant. An object is reused as long as the
+// file and everything it included are unchanged, so after editing one file only that file is
+// assembled again, and the program relinked.
+//
+// Usage: asm <source>... [-o image.bin] [-m map.txt] [-c cachedir] [-I dir]... [-D name=value]...
+//            [-s section=address]...                                      (addresses in hex)
+//        -o: image from the lowest to the highest address used, program.bin by default
+//        -m: sections, symbols and source lines with their addresses, read by disasm
+//        -c: Build/asmcache by default
+//        -s: start address of a section, "code" starts at 2000 by default
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "sourceAssembler.h"
+#include "linker.h"
+#include "cpuVariants.h"
+
+int main(int argc, char** argv){
+    std::vector<std::string> sources;
+    std::string outPath = "program.bin", mapPath, cacheDir = "Build/asmcache";
+    SourceAssembler assembler;
+    Linker linker;
+
+    for(int i = 1; i < argc; i++){
+        std::string option = argv[i];
+        if(option.size() == 2 && option[0] == '-' && i + 1 == argc){
+            sources.clear();
+            break;
+        }
+        if(option == "-o") outPath = argv[++i];
+        else if(option == "-m") mapPath = argv[++i];
+        else if(option == "-c") cacheDir = argv[++i];
+        else if(option == "-I") assembler.includeDirs.push_back(argv[++i]);
+        else if(option == "-D" || option == "-s"){
+            std::string definition = argv[++i];
+            size_t equals = definition.find('=');
+            std::string name = definition.substr(0, equals);
+            if(option == "-D")
+                assembler.defines[name] = equals == std::string::npos ? 1 : strtol(definition.c_str() + equals + 1, nullptr, 0);
+            else
+                linker.place(name, equals == std::string::npos ? 0 : strtoul(definition.c_str() + equals + 1, nullptr, 16));
+        }
+        else
+            sources.push_back(option);
+    }
+    if(sources.empty()){
+        printf("Usage: %s <source>... [-o image.bin] [-m map.txt] [-c cachedir] [-I dir]... [-D name=value]... [-s section=address]...\n", argv[0]);
+        return 2;
+    }
+    mkdir(cacheDir.c_str(), 0755);
+
+    // Everything besides the files themselves which changes the output of the assembler
+    // The instruction set depends on the CPU variant of the build
+    std::string options = std::to_string(OBJECT::VERSION) + " " + CPU_VARIANT::name;
+    for(const std::string& dir : assembler.includeDirs)
+        options += " -I" + dir;
+    for(const auto& [name, value] : assembler.defines)
+        options += " -D" + name + "=" + std::to_string(value);
+
+    std::vector<OBJECT> objects(sources.size());
+    unsigned assembled = 0;
+    try{
+        for(size_t i = 0; i < sources.size(); i++){
+            std::string content;
+            if(!readFile(sources[i], content)){
+                printf("Can't read %s\n", sources[i].c_str());
+                return 2;
+            }
+            char key[17];
+            snprintf(key, sizeof(key), "%016llx", contentHash(content, contentHash(sources[i] + '\0' + options)));
+            std::string cached = cacheDir + "/" + key + ".o";
+
+            if(objects[i].load(cached) && objects[i].upToDate())
+                continue;
+            objects[i] = assembler.assemble(sources[i]);
+            if(!objects[i].save(cached))
+                printf("Can't write %s\n", cached.c_str());
+            assembled++;
+        }
+
+        Linker::IMAGE image = linker.link(objects);
+        FILE* out = fopen(outPath.c_str(), "wb");
+        if(!out || fwrite(image.data.data(), 1, image.data.size(), out) != image.data.size()){
+            printf("Can't write %s\n", outPath.c_str());
+            return 2;
+        }
+        fclose(out);
+
+        if(!mapPath.empty()){
+            FILE* map = fopen(mapPath.c_str(), "w");
+            if(!map){
+                printf("Can't write %s\n", mapPath.c_str());
+                return 2;
+            }
+            for(const Linker::PLACEMENT& placement : image.placements)
+                fprintf(map, "%04X-%04X %-12s %s\n", placement.address, placement.address + placement.size - 1,
+                    placement.section.c_str(), placement.source.c_str());
+            fprintf(map, "\n");
+            for(const auto& [name, value] : image.symbols)
+                fprintf(map, "%04lX %s\n", value & 0xFFFF, name.c_str());
+            for(const auto& [address, name] : image.labels){
+                if(name[0] == '@')
+                    fprintf(map, "%04X %s\n", address, name.c_str());
+            }
+            fprintf(map, "\n");
+            for(const auto& [address, where] : image.lines)
+                fprintf(map, "%04X %s\n", address, where.c_str());
+            fclose(map);
+        }
+
+        printf("%zu files, %u assembled, %zu from the cache\n", sources.size(), assembled, sources.size() - assembled);
+        printf("%s: %zu bytes, load at %04X\n", outPath.c_str(), image.data.size(), image.start);
+    }
+    catch(const std::invalid_argument& e){
+        printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
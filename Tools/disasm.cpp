@@ -0,0 +1,103 @@
+// Disassembles a program image. With the map written by Tools/asm (-m) the addresses are
+// replaced by their symbols and every instruction is annotated with its source line.
+//
+// Usage: disasm <image.bin> [-l load] [-s start] [-e end] [-m map.txt]   (addresses in hex)
+//        -l: address of the first byte of the image, 2000 by default
+//        -s, -e: range to disassemble, the whole image by default (end exclusive)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "disassembler.h"
+
+// Blocks of the map, separated by empty lines: sections, symbols, source lines
+static bool readMap(const char* path, Disassembler& disassembler){
+    FILE* file = fopen(path, "r");
+    if(!file)
+        return false;
+    char line[1024];
+    int block = 0;
+    while(fgets(line, sizeof(line), file)){
+        line[strcspn(line, "\r\n")] = '\0';
+        if(!line[0]){
+            block++;
+            continue;
+        }
+        unsigned address = 0;
+        int length = 0;
+        if(block == 0 || sscanf(line, "%x %n", &address, &length) != 1)
+            continue;
+        if(block == 1)
+            disassembler.addSymbol(address, line + length);
+        else
+            disassembler.addLine(address, line + length);
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv){
+    const char* path = nullptr;
+    const char* mapPath = nullptr;
+    unsigned long load = 0x2000, start = 0, end = 0;
+    bool hasStart = false, hasEnd = false;
+
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-l") && i + 1 < argc)
+            load = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-s") && i + 1 < argc)
+            start = strtoul(argv[++i], nullptr, 16), hasStart = true;
+        else if(!strcmp(argv[i], "-e") && i + 1 < argc)
+            end = strtoul(argv[++i], nullptr, 16), hasEnd = true;
+        else if(!strcmp(argv[i], "-m") && i + 1 < argc)
+            mapPath = argv[++i];
+        else
+            path = argv[i];
+    }
+    if(!path){
+        printf("Usage: %s <image.bin> [-l load] [-s start] [-e end] [-m map.txt]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if(!file){
+        printf("Can't read %s\n", path);
+        return 2;
+    }
+    std::vector<BYTE> image(0x10000);
+    size_t size = fread(image.data(), 1, 0x10000 - (load & 0xFFFF), file);
+    fclose(file);
+
+    Disassembler disassembler;
+    if(mapPath && !readMap(mapPath, disassembler)){
+        printf("Can't read %s\n", mapPath);
+        return 2;
+    }
+    if(!hasStart || start < load)
+        start = load;
+    if(!hasEnd || end > load + size)
+        end = load + size;
+
+    // Decoded and formatted in chunks, into buffers which are reused
+    static Disassembler::DECODED decoded[4096];
+    static char text[4096 * 256];
+    const BYTE* memory = image.data();
+    while(start < end){
+        size_t count = Disassembler::decode(memory + (start - load), end - start, start, decoded, 4096);
+        if(count == 0){
+            // The last instruction is cut off by the end of the image
+            printf("%04lX  %02X            .byte\n", start, memory[start - load]);
+            start++;
+            continue;
+        }
+        size_t used = 0;
+        for(size_t i = 0; i < count; i++)
+            used += disassembler.format(decoded[i], text + used, sizeof(text) - used);
+        fwrite(text, 1, used, stdout);
+        start = decoded[count - 1].address + decoded[count - 1].length;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Runs Klaus Dormann's 6502 functional test (https://github.com/Klaus2m5/6502_65C02_functional_tests).
+// The binary 6502_functional_test.bin is a 64kB image which is loaded to 0x0000 and started
+// at 0x0400. Every failing test ends in a JMP * or a branch to itself, so the run stops as soon
+// as an instruction doesn't move the PC. Reaching the success trap means all tests passed.
+//
+// Usage: functest <image.bin> [-l load] [-e entry] [-s success]   (addresses in hex)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <memory>
+
+#include "bus.h"
+
+int main(int argc, char** argv){
+    std::string path;
+    WORD load    = 0x0000;
+    WORD entry   = 0x0400;
+    WORD success = 0x3469;  // Success trap of the unmodified binary
+
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-l") && i + 1 < argc)
+            load = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-e") && i + 1 < argc)
+            entry = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-s") && i + 1 < argc)
+            success = strtoul(argv[++i], nullptr, 16);
+        else
+            path = argv[i];
+    }
+    if(path.empty()){
+        printf("Usage: %s <image.bin> [-l load] [-e entry] [-s success]\n", argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<Bus> bus = std::make_unique<Bus>(Bus::Layout::Flat);
+    if(bus->loadBinary(path, load) < 0){
+        printf("Can't read %s\n", path.c_str());
+        return 2;
+    }
+    bus->cpu.PC = entry;
+    bus->cpu.SP = 0xFD;
+
+    unsigned long long instructions = 0;
+    unsigned long long cycles = 0;
+    WORD last;
+
+    auto start = std::chrono::steady_clock::now();
+    do{
+        last = bus->cpu.PC;
+        do{
+            bus->cpu.clock();
+            cycles++;
+        } while(!bus->cpu.completed());
+        instructions++;
+    } while(bus->cpu.PC != last);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool passed = (last == success);
+    if(passed)
+        printf("Passed, success trap at %04X\n", last);
+    else
+        printf("Failed, trapped at %04X (test case %02X)\n", last, bus->read(0x0200));
+
+    printf("%llu instructions, %llu cycles in %.3fs\n", instructions, cycles, seconds);
+    printf("%.2f M instructions/s, %.2f MHz\n", instructions / seconds / 1e6, cycles / seconds / 1e6);
+
+    return passed ? 0 : 1;
+}
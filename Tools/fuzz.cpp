@@ -0,0 +1,315 @@
+// Coverage-guided fuzzer for 6502 routines.
+// The image is loaded once, the routine at the entry is called like by a JSR and runs until it
+// returns (RTS), traps or exceeds the cycle limit. Before every call the input is written
+// into the window and its length is passed in A (lo) and X (hi). Between the calls the machine
+// is reset by Bus::restore(), which only copies back the pages the last run wrote.
+// The CPU records every branch, jump, call and return into an edge map. Inputs which reach new
+// edges (or edges a new number of times) are kept in the corpus directory. Inputs which end in a
+// trap (BRK, an illegal opcode or a stack wrap) are kept in <corpus>/crashes, one per trap and address. Existing files in the corpus directory
+// are the seeds. Every worker thread runs its own bus, the coverage and the corpus are shared.
+// Only the CPU is clocked, devices don't run while fuzzing.
+//
+// Usage: fuzz <image.bin> -c corpus [-l load] [-e entry] [-w window] [-s size] [-m cycles]
+//             [-j threads] [-t seconds] [-n executions] [-f]   (addresses in hex)
+//        -f: Bus::Layout::Flat instead of the device layout
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "bus.h"
+
+static const unsigned MAP_SIZE = 1 << 13;
+// The routine returns to this address, nothing is executed there
+static const WORD SENTINEL = 0xFFFF;
+
+struct CONFIG{
+    std::string image, corpus;
+    WORD load = 0x2000;
+    WORD entry = 0x2000;
+    WORD window = 0x3000;
+    unsigned size = 256;
+    unsigned long long cycles = 100000;
+    unsigned threads = 1;
+    double seconds = 60;
+    unsigned long long executions = 0;
+    bool flat = false;
+};
+
+enum RESULT{ Returned, Trapped, Timeout };
+
+// Shared between the workers
+static CONFIG config;
+static std::vector<BYTE> image;
+static std::atomic<BYTE> virgin[MAP_SIZE];
+static std::mutex corpusLock;
+static std::vector<std::vector<BYTE>> corpus;
+static std::set<unsigned> crashes;
+static std::atomic<unsigned long long> executed{0}, timeouts{0};
+static std::atomic<bool> stopping{false};
+
+static void save(const std::vector<BYTE>& input, std::string path){
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*) input.data(), input.size());
+}
+
+// xorshift64
+struct RANDOM{
+    unsigned long long state;
+    unsigned long long next(){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    unsigned below(unsigned n) { return n ? next() % n : 0; }
+};
+
+static void mutate(std::vector<BYTE>& data, RANDOM& random){
+    static const BYTE interesting[] = { 0x00, 0x01, 0x02, 0x0A, 0x0D, 0x10, 0x20, 0x30, 0x39, 0x41, 0x5A, 0x7F, 0x80, 0x81, 0xFE, 0xFF };
+
+    // Havoc: a stack of 2 - 16 small changes
+    unsigned count = 2 << random.below(4);
+    for(unsigned n = 0; n < count; n++){
+        if(data.empty())
+            data.push_back(random.next());
+        unsigned at = random.below(data.size());
+        switch(random.below(8)){
+            case 0: data[at] ^= 1 << random.below(8); break;
+            case 1: data[at] = random.next(); break;
+            case 2: data[at] = interesting[random.below(sizeof(interesting))]; break;
+            case 3: data[at] += 1 + random.below(16); break;
+            case 4: data[at] -= 1 + random.below(16); break;
+            case 5:
+                if(data.size() < config.size)
+                    data.insert(data.begin() + random.below(data.size() + 1), (BYTE) random.next());
+                break;
+            case 6:
+                if(data.size() > 1)
+                    data.erase(data.begin() + at, data.begin() + at + 1 + random.below(std::min<size_t>(8, data.size() - at)));
+                break;
+            case 7:{
+                // Splicing in a piece of another input
+                std::lock_guard<std::mutex> lock(corpusLock);
+                const std::vector<BYTE>& other = corpus[random.below(corpus.size())];
+                if(other.empty())
+                    break;
+                unsigned from = random.below(other.size());
+                unsigned len = 1 + random.below(other.size() - from);
+                for(unsigned i = 0; i < len && at + i < config.size; i++){
+                    if(at + i < data.size())
+                        data[at + i] = other[from + i];
+                    else
+                        data.push_back(other[from + i]);
+                }
+                break;
+            }
+        }
+    }
+    if(data.size() > config.size)
+        data.resize(config.size);
+}
+
+static RESULT execute(Bus& bus, const std::vector<BYTE>& input, WORD& stop){
+    emu6502& cpu = bus.cpu;
+    bus.restore();
+    for(size_t i = 0; i < input.size(); i++)
+        bus.write(config.window + i, input[i]);
+    cpu.A = input.size() & 0xFF;
+    cpu.X = input.size() >> 8;
+
+    // A halted CPU completes at once
+    unsigned long long cycles = 0;
+    while(cycles < config.cycles){
+        if(cpu.PC == SENTINEL)
+            return Returned;
+        do{
+            cpu.clock();
+            cycles++;
+        } while(!cpu.completed());
+        if(cpu.stop != emu6502::Stop::None){
+            stop = cpu.PC;
+            return Trapped;
+        }
+    }
+    return Timeout;
+}
+
+// Counts are compared in buckets: 1, 2, 3, 4 - 7, 8 - 15, 16 - 31, 32 - 127, 128+
+static BYTE bucket(BYTE hits){
+    if(hits <= 3)   return 1 << (hits - 1);
+    if(hits <= 7)   return 0x08;
+    if(hits <= 15)  return 0x10;
+    if(hits <= 31)  return 0x20;
+    if(hits <= 127) return 0x40;
+    return 0x80;
+}
+
+// Clears the trace while looking for new coverage
+static bool interesting(BYTE* trace){
+    bool found = false;
+    unsigned long long* words = (unsigned long long*) trace;
+    for(unsigned w = 0; w < MAP_SIZE / 8; w++){
+        if(!words[w])
+            continue;
+        for(unsigned i = w * 8; i < w * 8 + 8; i++){
+            if(!trace[i])
+                continue;
+            BYTE b = bucket(trace[i]);
+            if(virgin[i].fetch_and(~b, std::memory_order_relaxed) & b)
+                found = true;
+        }
+        words[w] = 0;
+    }
+    return found;
+}
+
+static void worker(unsigned id){
+    std::unique_ptr<Bus> bus = std::make_unique<Bus>(config.flat ? Bus::Layout::Flat : Bus::Layout::Devices);
+    for(size_t i = 0; i < image.size(); i++)
+        bus->write(config.load + i, image[i]);
+
+    // Calling the routine like a JSR from SENTINEL - 2 would
+    emu6502& cpu = bus->cpu;
+    cpu.PC = config.entry;
+    cpu.SP = 0xFD;
+    bus->write(0x0100 + cpu.SP--, (SENTINEL - 1) >> 8);
+    bus->write(0x0100 + cpu.SP--, (SENTINEL - 1) & 0xFF);
+    bus->checkpoint();
+
+    emu6502::TRAPS traps;
+    traps.brk = true;
+    traps.illegalOpcode = true;
+    traps.stackWrap = true;
+    cpu.setTraps(traps);
+
+    alignas(8) static thread_local BYTE trace[MAP_SIZE];
+    cpu.coverage = trace;
+    cpu.coverageMask = MAP_SIZE - 1;
+
+    RANDOM random{ 0x9E3779B97F4A7C15ULL * (id + 1) };
+    std::vector<BYTE> input;
+
+    while(!stopping){
+        {
+            std::lock_guard<std::mutex> lock(corpusLock);
+            input = corpus[random.below(corpus.size())];
+        }
+        mutate(input, random);
+
+        WORD stop = 0;
+        RESULT result = execute(*bus, input, stop);
+        unsigned long long n = ++executed;
+        if(result == Timeout)
+            timeouts++;
+
+        if(interesting(trace)){
+            std::lock_guard<std::mutex> lock(corpusLock);
+            corpus.push_back(input);
+            char name[32];
+            snprintf(name, sizeof(name), "/id_%06zu", corpus.size());
+            save(input, config.corpus + name);
+        }
+        if(result == Trapped){
+            static const char* names[] = { "", "illegal", "brk", "", "", "stack" };
+            std::lock_guard<std::mutex> lock(corpusLock);
+            if(crashes.insert(((unsigned) cpu.stop << 16) | stop).second){
+                char name[32];
+                snprintf(name, sizeof(name), "/crashes/%s_%04X", names[(int) cpu.stop], stop);
+                save(input, config.corpus + name);
+            }
+        }
+        if(config.executions && n >= config.executions)
+            stopping = true;
+    }
+}
+
+int main(int argc, char** argv){
+    for(int i = 1; i < argc; i++){
+        if(i + 1 < argc && argv[i][0] == '-' && argv[i][1] && !argv[i][2] && argv[i][1] != 'f'){
+            char option = argv[i][1];
+            const char* value = argv[++i];
+            switch(option){
+                case 'c': config.corpus = value; break;
+                case 'l': config.load = strtoul(value, nullptr, 16); break;
+                case 'e': config.entry = strtoul(value, nullptr, 16); break;
+                case 'w': config.window = strtoul(value, nullptr, 16); break;
+                case 's': config.size = std::max(1ul, strtoul(value, nullptr, 10)); break;
+                case 'm': config.cycles = strtoull(value, nullptr, 10); break;
+                case 'j': config.threads = std::max(1ul, strtoul(value, nullptr, 10)); break;
+                case 't': config.seconds = atof(value); break;
+                case 'n': config.executions = strtoull(value, nullptr, 10); break;
+            }
+        }
+        else if(!strcmp(argv[i], "-f"))
+            config.flat = true;
+        else
+            config.image = argv[i];
+    }
+    if(config.image.empty() || config.corpus.empty()){
+        printf("Usage: %s <image.bin> -c corpus [-l load] [-e entry] [-w window] [-s size] [-m cycles]\n"
+               "       [-j threads] [-t seconds] [-n executions] [-f]\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream file(config.image, std::ios::binary);
+    if(!file){
+        printf("Can't read %s\n", config.image.c_str());
+        return 2;
+    }
+    image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    image.resize(std::min<size_t>(image.size(), 0x10000 - config.load));
+
+    // Seeds
+    std::filesystem::create_directories(config.corpus + "/crashes");
+    for(const auto& entry : std::filesystem::directory_iterator(config.corpus)){
+        if(!entry.is_regular_file())
+            continue;
+        std::ifstream seed(entry.path(), std::ios::binary);
+        std::vector<BYTE> data((std::istreambuf_iterator<char>(seed)), std::istreambuf_iterator<char>());
+        data.resize(std::min<size_t>(data.size(), config.size));
+        corpus.push_back(data);
+    }
+    if(corpus.empty())
+        corpus.push_back(std::vector<BYTE>(1, 0x00));
+    for(std::atomic<BYTE>& bits : virgin)
+        bits = 0xFF;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < config.threads; i++)
+        threads.emplace_back(worker, i);
+
+    double elapsed = 0;
+    while(!stopping){
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(config.seconds > 0 && elapsed >= config.seconds)
+            stopping = true;
+
+        static int ticks = 0;
+        if(++ticks % 10 == 0 || stopping){
+            unsigned edges = 0;
+            for(std::atomic<BYTE>& bits : virgin)
+                edges += bits != 0xFF;
+            std::lock_guard<std::mutex> lock(corpusLock);
+            printf("%.0fs: %llu executions (%.0f/s), corpus %zu, %u edges, %zu crashes, %llu timeouts\n",
+                elapsed, executed.load(), executed / elapsed, corpus.size(), edges, crashes.size(), timeouts.load());
+            fflush(stdout);
+        }
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+    return crashes.empty() ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Runs a program on several CPU cores of one bus (MultiCore). All cores start at the entry.
+// Without a program it runs a built-in check: every core stores its number through its private
+// zero page, core 0 sends each of the others a message through the mailbox, and their
+// interrupt handlers store the message. It passes if all of them arrived.
+//
+// Usage: multicore [program.bin] [-c cores] [-q quantum] [-p] [-l load] [-e entry] [-n cycles]
+//                  (addresses in hex)
+//        -p: a private zero page and stack for every core, always on for the check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <memory>
+
+#include "bus.h"
+#include "multiCore.h"
+
+// Every core:   LDA $0709 / TAX / ORA #$80 / STA $00 / a delay of 256 loops, so all cores
+//               stored their number / LDA $00 / STA $3000,X
+// Other cores:  CLI / JMP * (waiting for the message)
+// Core 0:       for X = 1 .. [$30FF] - 1: wait for $3000,X, then write X | $40 into the slot of core X
+//               for X = 1 .. [$30FF] - 1: wait for $3100,X
+//               JMP * at $203E
+// IRQ ($2041):  LDA $0709 / TAX / LDA $0700,X / STA $3100,X / JMP *
+static const char* CHECK =
+    "AD 09 07 AA 09 80 85 00 A0 00 88 D0 FD A5 00 9D 00 30 E0 00 F0 04 58 4C 17 20 "
+    "A2 01 EC FF 30 B0 0E BD 00 30 F0 FB 8A 09 40 9D 00 07 E8 D0 ED "
+    "A2 01 EC FF 30 B0 08 BD 00 31 F0 FB E8 D0 F3 4C 3E 20 "
+    "AD 09 07 AA BD 00 07 9D 00 31 4C 4B 20";
+static const WORD CHECK_DONE = 0x203E;
+
+int main(int argc, char** argv){
+    std::string path;
+    unsigned cores = 4;
+    unsigned long quantum = 1000;
+    bool privatePages = false;
+    WORD load  = 0x2000;
+    WORD entry = 0x2000;
+    unsigned long long cycles = 10000000;
+
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-c") && i + 1 < argc)
+            cores = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-q") && i + 1 < argc)
+            quantum = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if(!strcmp(argv[i], "-p"))
+            privatePages = true;
+        else if(!strcmp(argv[i], "-l") && i + 1 < argc)
+            load = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-e") && i + 1 < argc)
+            entry = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-n") && i + 1 < argc)
+            cycles = strtoull(argv[++i], nullptr, 10);
+        else
+            path = argv[i];
+    }
+
+    std::unique_ptr<Bus> bus = std::make_unique<Bus>();
+    bool check = path.empty();
+    if(check){
+        bus->loadProgram(CHECK);
+        bus->write(0xFFFE, 0x41);
+        bus->write(0xFFFF, 0x20);
+        privatePages = true;
+    }
+    else if(bus->loadBinary(path, load) < 0){
+        printf("Can't read %s\n", path.c_str());
+        return 2;
+    }
+
+    MultiCore machine(bus.get(), cores, privatePages, quantum);
+    cores = machine.count();
+    bus->write(0x30FF, cores);
+    machine.reset();
+    for(unsigned n = 0; n < cores; n++)
+        machine.core(n).PC = entry;
+
+    // Between two runs only this thread touches the bus
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long end = bus->clockCount + cycles;
+    while(bus->clockCount < end && !(check && bus->cpu.PC == CHECK_DONE))
+        machine.run(std::min<unsigned long long>(quantum, end - bus->clockCount));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned long long instructions = 0;
+    for(unsigned n = 0; n < cores; n++){
+        emu6502& cpu = machine.core(n);
+        instructions += cpu.instructions;
+        printf("core %u: PC %04X, %llu instructions\n", n, cpu.PC, cpu.instructions);
+    }
+    printf("%llu cycles on %u cores, quantum %lu, %.2f M instructions/s\n",
+        bus->clockCount, cores, quantum, instructions / seconds / 1e6);
+
+    if(!check)
+        return 0;
+    unsigned failed = 0;
+    for(unsigned n = 0; n < cores; n++){
+        if(bus->read(0x3000 + n) != (0x80 | n)){
+            printf("Core %u stored %02X instead of its number\n", n, bus->read(0x3000 + n));
+            failed++;
+        }
+        if(n > 0 && bus->read(0x3100 + n) != (0x40 | n)){
+            printf("Core %u received %02X instead of its message\n", n, bus->read(0x3100 + n));
+            failed++;
+        }
+    }
+    printf(failed ? "Failed\n" : "Passed\n");
+    return failed ? 1 : 0;
+}
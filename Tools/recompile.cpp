@@ -0,0 +1,588 @@
+// Ahead-of-time recompiler, translates a 6502 program image into C++.
+// Starting at the entry points (0xFFFC, where reset() starts executing, and the ones given
+// with -e) the code is followed through all branches, jumps and subroutine calls. Every basic
+// block becomes one C++ function which uses the same Bus read/write interface and counts the
+// same cycles as emu6502. JMP (ind), RTS, RTI, BRK and the illegal opcodes end a block and are
+// left to the interpreter. So are blocks whose bytes don't match the image any more, this
+// catches self-modifying code.
+//
+// The output is a standalone program, built against the headless objects:
+//     recompile program.bin -l 2000 -e 2000 -o program.cpp
+//     g++ -std=c++20 -O2 -DHEADLESS -ISource program.cpp Build/headless/Source/*.o -o program
+// It runs the image for a number of cycles (-c) and prints the final state, with -i the same
+// run is done by the interpreter alone for comparison.
+//
+// Usage: recompile <image.bin> [-l load] [-e entry]... [-f] [-o output.cpp]   (addresses in hex)
+//        -f: the program uses Bus::Layout::Flat instead of the device layout
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include "datatypes.h"
+#include "cpuVariants.h"
+
+
+static BYTE memory[0x10000];
+static unsigned long imageStart = 0, imageEnd = 0;
+
+static unsigned length(BYTE mode){
+    return MODE_LENGTH[mode];
+}
+
+static bool inImage(unsigned long addr, unsigned long len){
+    return addr >= imageStart && addr + len <= imageEnd;
+}
+
+// The official opcodes except the ones which are left to the interpreter. In builds of another
+// CPU variant so are the opcodes which behave differently there, the translation is NMOS.
+static bool translatable(BYTE op){
+    // Blocks run atomically, the cycle accurate build interprets everything
+    if(CPU_TIMING::accurate)
+        return false;
+    std::string name = OPCODES[op].name;
+    if(!OPCODES[op].legal || name != CPU_OPCODES[op].name || OPCODES[op].cycles != CPU_OPCODES[op].cycles)
+        return false;
+    if(CPU_VARIANT::cmos && (name == "ADC" || name == "SBC"))
+        return false;
+    return name != "RTS" && name != "RTI" && name != "BRK" && OPCODES[op].mode != ModeIND;
+}
+
+static bool isBranch(BYTE op){
+    return OPCODES[op].mode == ModeREL;
+}
+
+static WORD operand(WORD addr){
+    return memory[(WORD)(addr + 1)] | (memory[(WORD)(addr + 2)] << 8);
+}
+
+static WORD branchTarget(WORD addr){
+    return addr + 2 + (signed char) memory[(WORD)(addr + 1)];
+}
+
+static std::string hex(unsigned value, int digits){
+    char text[16];
+    snprintf(text, sizeof(text), "0x%0*X", digits, value);
+    return text;
+}
+
+// Finds the first address of every basic block
+static std::set<WORD> findLeaders(std::vector<WORD> entries){
+    std::set<WORD> leaders;
+    std::vector<WORD> work;
+    auto add = [&](WORD addr){
+        if(inImage(addr, 1) && leaders.insert(addr).second)
+            work.push_back(addr);
+    };
+    for(WORD entry : entries)
+        add(entry);
+
+    while(!work.empty()){
+        WORD addr = work.back();
+        work.pop_back();
+        while(true){
+            BYTE op = memory[addr];
+            unsigned len = length(OPCODES[op].mode);
+            if(!inImage(addr, len) || !translatable(op))
+                break;
+            std::string name = OPCODES[op].name;
+            if(isBranch(op)){
+                add(branchTarget(addr));
+                add(addr + 2);
+                break;
+            }
+            if(name == "JMP"){
+                add(operand(addr));
+                break;
+            }
+            if(name == "JSR"){
+                add(operand(addr));
+                add(addr + 3);     // Where RTS returns to
+                break;
+            }
+            addr += len;
+        }
+    }
+    return leaders;
+}
+
+struct BLOCK{
+    WORD start;
+    WORD length;
+    std::string code;
+};
+
+static std::vector<bool> codeMap(0x10000);
+
+// Address of the operand and the extra cycle of a page crossing
+static std::string address(WORD addr, BYTE mode, std::string& cross){
+    BYTE lo = memory[(WORD)(addr + 1)];
+    WORD abs = operand(addr);
+    switch(mode){
+        case ModeZP0: return hex(lo, 2);
+        case ModeZPX: return "(BYTE)(" + hex(lo, 2) + " + r.X)";
+        case ModeZPY: return "(BYTE)(" + hex(lo, 2) + " + r.Y)";
+        case ModeABS: return hex(abs, 4);
+        case ModeABX:
+            cross = "(" + hex(lo, 2) + " + r.X > 0xFF)";
+            return "(WORD)(" + hex(abs, 4) + " + r.X)";
+        case ModeABY:
+            cross = "(" + hex(lo, 2) + " + r.Y > 0xFF)";
+            return "(WORD)(" + hex(abs, 4) + " + r.Y)";
+        case ModeIZX:
+            return "(WORD)(rd((BYTE)(" + hex(lo, 2) + " + r.X)) | (rd((BYTE)(" + hex(lo, 2) + " + r.X + 1)) << 8))";
+        case ModeIZY:
+            cross = "((base & 0xFF) + r.Y > 0xFF)";
+            return "(WORD)(base + r.Y)";
+        default: return "";
+    }
+}
+
+// Translates one instruction. Returns false if it ends the block.
+static bool translate(WORD addr, std::string& out){
+    BYTE op = memory[addr];
+    const OPCODE& info = OPCODES[op];
+    std::string name = info.name;
+    WORD next = addr + length(info.mode);
+    std::string done = "pc = " + hex(next, 4) + "; return cycles;";
+
+    char comment[64];
+    snprintf(comment, sizeof(comment), "    // %04X  %s\n", addr, info.name);
+    out += comment;
+    out += "    cycles += " + std::to_string(info.cycles) + ";\n";
+
+    // Control flow, the cycles of a taken branch are known at this point
+    if(isBranch(op)){
+        static const char* conditions[8] = { "!r.N", "r.N", "!r.V", "r.V", "!r.C", "r.C", "!r.Z", "r.Z" };
+        WORD target = branchTarget(addr);
+        int taken = 1 + ((target & 0xFF00) != (next & 0xFF00));
+        out += std::string("    if(") + conditions[op >> 5] + "){ cycles += " + std::to_string(taken) + "; ";
+        if(target == addr)
+            out += "trapped = true; ";
+        out += "pc = " + hex(target, 4) + "; return cycles; }\n";
+        out += "    " + done + "\n";
+        return false;
+    }
+    if(name == "JMP" || name == "JSR"){
+        WORD target = operand(addr);
+        if(name == "JSR"){
+            WORD ret = addr + 2;
+            out += "    push(r, " + hex(ret >> 8, 2) + "); push(r, " + hex(ret & 0xFF, 2) + ");\n";
+        }
+        else if(target == addr)
+            out += "    trapped = true;\n";
+        out += "    pc = " + hex(target, 4) + "; return cycles;\n";
+        return false;
+    }
+
+    std::string cross;
+    std::string a = address(addr, info.mode, cross);
+    std::string value = info.mode == ModeIMM ? hex(memory[(WORD)(addr + 1)], 2) : "rd(a)";
+    bool accumulator = info.mode == ModeACC;
+
+    // Writes to a constant address which isn't code can't modify the program
+    bool constant = info.mode == ModeZP0 || info.mode == ModeABS;
+    bool checked = !constant || codeMap[info.mode == ModeZP0 ? memory[(WORD)(addr + 1)] : operand(addr)];
+    std::string write = checked ? "wr" : "bus->write";
+    bool writes = false;
+
+    std::string body;
+    if(name == "LDA" || name == "LDX" || name == "LDY"){
+        std::string reg = std::string("r.") + name[2];
+        body = reg + " = " + value + "; nz(r, " + reg + ");";
+    }
+    else if(name == "STA" || name == "STX" || name == "STY"){
+        body = write + "(a, r." + name[2] + ");";
+        writes = true;
+    }
+    else if(name == "ADC")  body = "adc(r, " + value + ");";
+    else if(name == "SBC")  body = "sbc(r, " + value + ");";
+    else if(name == "AND")  body = "r.A &= " + value + "; nz(r, r.A);";
+    else if(name == "ORA")  body = "r.A |= " + value + "; nz(r, r.A);";
+    else if(name == "EOR")  body = "r.A ^= " + value + "; nz(r, r.A);";
+    else if(name == "CMP")  body = "cmp(r, r.A, " + value + ");";
+    else if(name == "CPX")  body = "cmp(r, r.X, " + value + ");";
+    else if(name == "CPY")  body = "cmp(r, r.Y, " + value + ");";
+    else if(name == "BIT")  body = "BYTE v = " + value + "; r.Z = (r.A & v) == 0; r.N = v & 0x80; r.V = v & 0x40;";
+    else if(name == "INC" || name == "DEC"){
+        body = "BYTE v = rd(a) " + std::string(name == "INC" ? "+" : "-") + " 1; " + write + "(a, v); nz(r, v);";
+        writes = true;
+    }
+    else if(name == "ASL" || name == "LSR" || name == "ROL" || name == "ROR"){
+        std::string shift = name;
+        for(char& c : shift)
+            c = tolower(c);
+        if(accumulator)
+            body = "r.A = " + shift + "(r, r.A);";
+        else{
+            body = "BYTE v = " + shift + "(r, rd(a)); " + write + "(a, v);";
+            writes = true;
+        }
+    }
+    else if(name == "INX" || name == "INY" || name == "DEX" || name == "DEY"){
+        std::string reg = std::string("r.") + name[2];
+        body = reg + (name[0] == 'I' ? "++" : "--") + "; nz(r, " + reg + ");";
+    }
+    else if(name == "TAX")  body = "r.X = r.A; nz(r, r.X);";
+    else if(name == "TAY")  body = "r.Y = r.A; nz(r, r.Y);";
+    else if(name == "TSX")  body = "r.X = r.SP; nz(r, r.X);";
+    else if(name == "TXA")  body = "r.A = r.X; nz(r, r.A);";
+    else if(name == "TYA")  body = "r.A = r.Y; nz(r, r.A);";
+    else if(name == "TXS")  body = "r.SP = r.X;";
+    else if(name == "CLC")  body = "r.C = 0;";
+    else if(name == "SEC")  body = "r.C = 1;";
+    else if(name == "CLD")  body = "r.D = 0;";
+    else if(name == "SED")  body = "r.D = 1;";
+    else if(name == "CLI")  body = "r.I = 0;";
+    else if(name == "SEI")  body = "r.I = 1;";
+    else if(name == "CLV")  body = "r.V = 0;";
+    else if(name == "PHA"){ body = "push(r, r.A);"; writes = true; }
+    else if(name == "PHP"){ body = "push(r, status(r) | 0x30);"; writes = true; }
+    else if(name == "PLA")  body = "r.A = pull(r); nz(r, r.A);";
+    else if(name == "PLP")  body = "setStatus(r, pull(r));";
+
+    if(!body.empty()){
+        std::string setup;
+        if(info.mode == ModeIZY){
+            BYTE lo = memory[(WORD)(addr + 1)];
+            setup = "WORD base = rd(" + hex(lo, 2) + ") | (rd((BYTE)(" + hex(lo, 2) + " + 1)) << 8); ";
+        }
+        if(!a.empty() && info.mode != ModeIMM && !accumulator)
+            setup += "WORD a = " + a + "; ";
+        // Only the operations which return 1 in emu6502 pay for a page crossing
+        bool extra = name == "ADC" || name == "SBC" || name == "AND" || name == "ORA" || name == "EOR"
+            || name == "LDA" || name == "LDX" || name == "LDY" || name == "CMP";
+        if(extra && !cross.empty())
+            setup += "cycles += " + cross + "; ";
+        out += "    { " + setup + body + " }\n";
+    }
+    if(writes && (checked || name == "PHA" || name == "PHP"))
+        out += "    if(smc){ " + done + " }\n";
+    return true;
+}
+
+static BLOCK translateBlock(WORD start, const std::set<WORD>& leaders){
+    BLOCK block;
+    block.start = start;
+    WORD addr = start;
+    while(true){
+        BYTE op = memory[addr];
+        unsigned len = length(OPCODES[op].mode);
+        if(!inImage(addr, len) || !translatable(op) || (addr != start && leaders.count(addr))){
+            block.code += "    pc = " + hex(addr, 4) + "; return cycles;\n";
+            break;
+        }
+        bool more = translate(addr, block.code);
+        addr += len;
+        if(!more)
+            break;
+    }
+    block.length = addr - start;
+    return block;
+}
+
+// Code shared by all generated programs
+static const char* prologue = R"(
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+
+#include "bus.h"
+
+namespace{
+
+struct REGS{
+    BYTE A, X, Y, SP;
+    bool C, Z, I, D, B, U, V, N;
+};
+
+Bus* bus = nullptr;
+bool smc = false;       // A block wrote into translated code or switched a bank
+bool trapped = false;   // A jump or branch onto itself
+BYTE codeMap[0x10000];
+
+inline BYTE rd(WORD a){ return bus->read(a); }
+inline void wr(WORD a, BYTE v){ bus->write(a, v); if(codeMap[a] || (a >= MmuDevice::START && a <= MmuDevice::END)) smc = true; }
+inline void nz(REGS& r, BYTE v){ r.Z = v == 0; r.N = v & 0x80; }
+inline void push(REGS& r, BYTE v){ wr(0x0100 + r.SP, v); r.SP--; }
+inline BYTE pull(REGS& r){ r.SP++; return rd(0x0100 + r.SP); }
+inline void cmp(REGS& r, BYTE reg, BYTE v){ r.C = reg >= v; nz(r, reg - v); }
+
+inline BYTE status(const REGS& r){
+    return (r.N << 7) | (r.V << 6) | (r.U << 5) | (r.B << 4) | (r.D << 3) | (r.I << 2) | (r.Z << 1) | r.C;
+}
+
+inline void setStatus(REGS& r, BYTE p){
+    r.C = p & 0x01; r.Z = p & 0x02; r.I = p & 0x04; r.D = p & 0x08;
+    r.B = p & 0x10; r.U = p & 0x20; r.V = p & 0x40; r.N = p & 0x80;
+}
+
+inline BYTE asl(REGS& r, BYTE v){ r.C = v & 0x80; v <<= 1; nz(r, v); return v; }
+inline BYTE lsr(REGS& r, BYTE v){ r.C = v & 0x01; v >>= 1; nz(r, v); return v; }
+inline BYTE rol(REGS& r, BYTE v){ BYTE t = (v << 1) | r.C; r.C = v & 0x80; nz(r, t); return t; }
+inline BYTE ror(REGS& r, BYTE v){ BYTE t = (v >> 1) | (r.C << 7); r.C = v & 0x01; nz(r, t); return t; }
+
+// ADC and SBC including the decimal mode, the same as in emu6502
+inline void adc(REGS& r, BYTE v){
+    WORD t;
+    if(r.D){
+        WORD lo = (r.A & 0x0F) + (v & 0x0F) + r.C;
+        if(lo >= 0x0A)
+            lo = ((lo + 0x06) & 0x0F) + 0x10;
+        t = (r.A & 0xF0) + (v & 0xF0) + lo;
+        r.Z = ((r.A + v + r.C) & 0xFF) == 0;
+        r.N = t & 0x80;
+        r.V = (~(r.A ^ v) & (r.A ^ t)) & 0x80;
+        if(t >= 0xA0)
+            t += 0x60;
+        r.C = t > 0xFF;
+        r.A = t & 0xFF;
+        return;
+    }
+    t = r.A + v + r.C;
+    r.C = t > 0xFF;
+    r.Z = (t & 0xFF) == 0;
+    r.V = (~(r.A ^ v) & (r.A ^ t)) & 0x80;
+    r.N = t & 0x80;
+    r.A = t & 0xFF;
+}
+
+inline void sbc(REGS& r, BYTE v){
+    WORD value = v ^ 0x00FF;
+    WORD t = r.A + value + r.C;
+    BYTE result = t & 0xFF;
+    if(r.D){
+        int lo = (r.A & 0x0F) - (v & 0x0F) + r.C - 1;
+        if(lo < 0)
+            lo = ((lo - 0x06) & 0x0F) - 0x10;
+        int sum = (r.A & 0xF0) - (v & 0xF0) + lo;
+        if(sum < 0)
+            sum -= 0x60;
+        result = sum & 0xFF;
+    }
+    r.C = t & 0xFF00;
+    r.Z = (t & 0xFF) == 0;
+    r.V = (t ^ r.A) & (t ^ value) & 0x80;
+    r.N = t & 0x80;
+    r.A = result;
+}
+
+)";
+
+static const char* epilogue = R"(
+// Translated blocks by start address
+SLOT* table[0x10000];
+// Incremented whenever code may have been overwritten, blocks are checked against the image again
+unsigned long long epoch = 1;
+
+void init(){
+    for(SLOT& s : slots){
+        table[s.start] = &s;
+        for(unsigned i = 0; i < s.length; i++)
+            codeMap[(WORD)(s.start + i)] = 1;
+    }
+}
+
+bool verify(SLOT& s){
+    for(unsigned i = 0; i < s.length; i++)
+        if(bus->read(s.start + i) != image[s.start - LOAD + i])
+            return false;
+    s.verified = epoch;
+    return true;
+}
+
+void load(REGS& r, emu6502& cpu){
+    r.A = cpu.A; r.X = cpu.X; r.Y = cpu.Y; r.SP = cpu.SP;
+    setStatus(r, cpu.getStatus());
+}
+
+void store(const REGS& r, emu6502& cpu){
+    cpu.A = r.A; cpu.X = r.X; cpu.Y = r.Y; cpu.SP = r.SP;
+    cpu.setStatus(status(r));
+}
+
+// Runs at least the given number of cycles. Blocks are executed while the CPU is between
+// instructions and no stall or interrupt is pending, everything else goes through Bus::clock().
+// Returns the number of cycles spent in translated blocks.
+unsigned long long run(Bus& b, unsigned long long cycles, bool interpret){
+    bus = &b;
+    emu6502& cpu = b.cpu;
+    unsigned long long end = b.clockCount + cycles;
+    unsigned long long translated = 0;
+
+    while(b.clockCount < end && !b.shouldTerminate() && !trapped){
+        bool interrupt = b.irqPending() && cpu.getFlag(emu6502::I) == 0;
+        if(!interpret && cpu.completed() && !b.stalled() && !interrupt){
+            SLOT* s = table[cpu.PC];
+            if(s && (s->verified == epoch || verify(*s))){
+                REGS r;
+                load(r, cpu);
+                smc = false;
+                unsigned long n = s->run(r, cpu.PC);
+                store(r, cpu);
+                if(smc)
+                    epoch++;
+
+                unsigned long long changes = b.changes;
+                b.tick(n);
+                if(b.changes != changes)
+                    epoch++;
+                translated += n;
+                continue;
+            }
+        }
+
+        // Interpreter, a completed instruction which didn't move the PC is a trap
+        bool starts = cpu.completed() && !b.stalled() && !interrupt;
+        WORD last = cpu.PC;
+        unsigned long long changes = b.changes;
+        b.clock();
+        if(b.changes != changes)
+            epoch++;
+        if(starts && cpu.PC == last){
+            trapped = true;
+            while(!cpu.completed())
+                b.clock();
+        }
+    }
+    return translated;
+}
+
+}
+
+int main(int argc, char** argv){
+    unsigned long long cycles = 100000000;
+    bool interpret = false;
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-c") && i + 1 < argc)
+            cycles = strtoull(argv[++i], nullptr, 10);
+        else if(!strcmp(argv[i], "-i"))
+            interpret = true;
+        else{
+            printf("Usage: %s [-c cycles] [-i]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::unique_ptr<Bus> b = std::make_unique<Bus>(LAYOUT);
+    for(unsigned long i = 0; i < sizeof(image); i++)
+        b->write(LOAD + i, image[i]);
+    b->cpu.reset();
+    b->cpu.PC = ENTRY;
+    init();
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long translated = run(*b, cycles, interpret);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    emu6502& cpu = b->cpu;
+    printf("%s at %04X after %llu cycles, A=%02X X=%02X Y=%02X SP=%02X P=%02X\n", trapped ? "Trapped" : "Stopped",
+        cpu.PC, b->clockCount, cpu.A, cpu.X, cpu.Y, cpu.SP, cpu.getStatus());
+    printf("%.1f%% of the cycles in translated code, %.3fs, %.2f MHz\n",
+        b->clockCount ? 100.0 * translated / b->clockCount : 0.0, seconds, b->clockCount / seconds / 1e6);
+    return 0;
+}
+)";
+
+int main(int argc, char** argv){
+    std::string path, outPath;
+    WORD load = 0x0000;
+    std::vector<WORD> entries;
+    bool flat = false;
+
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-l") && i + 1 < argc)
+            load = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-e") && i + 1 < argc)
+            entries.push_back(strtoul(argv[++i], nullptr, 16));
+        else if(!strcmp(argv[i], "-o") && i + 1 < argc)
+            outPath = argv[++i];
+        else if(!strcmp(argv[i], "-f"))
+            flat = true;
+        else
+            path = argv[i];
+    }
+    if(path.empty()){
+        printf("Usage: %s <image.bin> [-l load] [-e entry]... [-f] [-o output.cpp]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file){
+        printf("Can't read %s\n", path.c_str());
+        return 2;
+    }
+    long size = fread(memory + load, 1, 0x10000 - load, file);
+    fclose(file);
+    imageStart = load;
+    imageEnd = load + size;
+
+    // reset() executes the code at 0xFFFC, the interrupt vectors are entries as well
+    std::vector<WORD> roots = entries;
+    WORD entry = entries.empty() ? 0xFFFC : entries[0];
+    if(inImage(0xFFFC, 1))
+        roots.push_back(0xFFFC);
+    if(inImage(0xFFFA, 6)){
+        roots.push_back(memory[0xFFFA] | (memory[0xFFFB] << 8));
+        roots.push_back(memory[0xFFFE] | (memory[0xFFFF] << 8));
+    }
+    if(!inImage(entry, 1)){
+        printf("The entry %04X isn't part of the image, use -e\n", entry);
+        return 2;
+    }
+
+    std::set<WORD> leaders = findLeaders(roots);
+    std::vector<BLOCK> blocks;
+    // Code bytes are known before translating, writes to them have to be checked
+    for(WORD leader : leaders){
+        BLOCK block = translateBlock(leader, leaders);
+        for(unsigned i = 0; i < block.length; i++)
+            codeMap[(WORD)(leader + i)] = true;
+        blocks.push_back(block);
+    }
+    blocks.clear();
+    for(WORD leader : leaders){
+        BLOCK block = translateBlock(leader, leaders);
+        if(block.length > 0)
+            blocks.push_back(block);
+    }
+
+    FILE* out = outPath.empty() ? stdout : fopen(outPath.c_str(), "w");
+    if(!out){
+        printf("Can't write %s\n", outPath.c_str());
+        return 2;
+    }
+    fprintf(out, "// Generated by recompile from %s, %zu blocks\n", path.c_str(), blocks.size());
+    fputs(prologue, out);
+
+    fprintf(out, "const WORD LOAD = 0x%04X;\nconst WORD ENTRY = 0x%04X;\n", load, entry);
+    fprintf(out, "const Bus::Layout LAYOUT = Bus::Layout::%s;\n\n", flat ? "Flat" : "Devices");
+    fprintf(out, "const BYTE image[%ld] = {", size);
+    for(long i = 0; i < size; i++)
+        fprintf(out, "%s0x%02X,", i % 16 ? " " : "\n    ", memory[load + i]);
+    fprintf(out, "\n};\n\n");
+
+    for(const BLOCK& block : blocks){
+        fprintf(out, "unsigned long b%04X(REGS& r, WORD& pc){\n    unsigned long cycles = 0;\n", block.start);
+        fputs(block.code.c_str(), out);
+        fprintf(out, "}\n\n");
+    }
+
+    fprintf(out, "struct SLOT{\n    WORD start;\n    WORD length;\n    unsigned long (*run)(REGS&, WORD&);\n"
+                 "    unsigned long long verified;\n};\n\nSLOT slots[] = {\n");
+    for(const BLOCK& block : blocks)
+        fprintf(out, "    { 0x%04X, %u, b%04X, 0 },\n", block.start, block.length, block.start);
+    fprintf(out, "};\n");
+    fputs(epilogue, out);
+
+    if(out != stdout)
+        fclose(out);
+    fprintf(stderr, "%zu blocks, %zu bytes of code\n", blocks.size(), (size_t) std::count(codeMap.begin(), codeMap.end(), true));
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Runs a program on a headless bus and renders the output of DrawingDevice with
+// the software rasterizer. Frames can be dumped as PPM files or as a hash stream,
+// which can be compared against a golden run.
+// With -t the run stops at an illegal opcode, a BRK, a jump onto itself or a stack wrap,
+// with -x at a write to the given exit address.
+//
+// Usage: render (-a program.asm | -b image.bin [-l load]) [-e entry] [-c cycles] [-f frames]
+//               [-o frame%05u.ppm] [-h hashes.txt] [-W width] [-H height] [-t] [-x exit]
+//               (addresses in hex)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include "bus.h"
+#include "assembler.h"
+#include "softRasterizer.h"
+
+int main(int argc, char** argv){
+    std::string asmPath, binPath, pattern, hashPath;
+    WORD load = 0x2000;
+    WORD entry = 0x2000;
+    unsigned long long cycles = 1000000;
+    unsigned long long frames = 0;
+    unsigned int width = 800, height = 600;
+    emu6502::TRAPS traps;
+
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-t")){
+            traps.illegalOpcode = traps.brk = traps.selfLoop = traps.stackWrap = true;
+            continue;
+        }
+        if(i + 1 == argc)
+            break;
+        if(!strcmp(argv[i], "-a"))      asmPath = argv[++i];
+        else if(!strcmp(argv[i], "-b")) binPath = argv[++i];
+        else if(!strcmp(argv[i], "-l")) load = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-e")) entry = strtoul(argv[++i], nullptr, 16);
+        else if(!strcmp(argv[i], "-c")) cycles = strtoull(argv[++i], nullptr, 10);
+        else if(!strcmp(argv[i], "-f")) frames = strtoull(argv[++i], nullptr, 10);
+        else if(!strcmp(argv[i], "-o")) pattern = argv[++i];
+        else if(!strcmp(argv[i], "-h")) hashPath = argv[++i];
+        else if(!strcmp(argv[i], "-W")) width = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-H")) height = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-x")){
+            traps.exitWrite = true;
+            traps.exitAddress = strtoul(argv[++i], nullptr, 16);
+        }
+    }
+    if(asmPath.empty() == binPath.empty()){
+        printf("Usage: %s (-a program.asm | -b image.bin [-l load]) [-e entry] [-c cycles] [-f frames]\n"
+               "       [-o frame%%05u.ppm] [-h hashes.txt] [-W width] [-H height] [-t] [-x exit]\n", argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<Bus> bus = std::make_unique<Bus>();
+    SoftRasterizer raster(width, height);
+    bus->dd.attachRasterizer(&raster);
+
+    if(!asmPath.empty()){
+        std::ifstream file(asmPath);
+        if(!file){
+            printf("Can't read %s\n", asmPath.c_str());
+            return 2;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        try{
+            Assembler assembler(text.str());
+            bus->loadProgram(assembler.convert());
+        }
+        catch(const std::invalid_argument& e){
+            printf("%s\n", e.what());
+            return 2;
+        }
+    }
+    else if(bus->loadBinary(binPath, load) < 0){
+        printf("Can't read %s\n", binPath.c_str());
+        return 2;
+    }
+
+    if(!pattern.empty() && !raster.dumpFrames(pattern)){
+        printf("%s needs one conversion of the frame number like %%05u\n", pattern.c_str());
+        return 2;
+    }
+
+    FILE* hashFile = nullptr;
+    if(!hashPath.empty()){
+        hashFile = hashPath == "-" ? stdout : fopen(hashPath.c_str(), "w");
+        if(!hashFile){
+            printf("Can't write %s\n", hashPath.c_str());
+            return 2;
+        }
+        raster.hashFrames(hashFile);
+    }
+
+    bus->cpu.PC = entry;
+    bus->cpu.SP = 0xFD;
+    bus->cpu.setTraps(traps);
+
+    auto start = std::chrono::steady_clock::now();
+    while(bus->clockCount < cycles && (frames == 0 || raster.frames() < frames) && bus->cpu.stop == emu6502::Stop::None)
+        bus->clock();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(hashFile && hashFile != stdout)
+        fclose(hashFile);
+
+    fprintf(stderr, "%llu frames, %llu cycles in %.3fs (%.0f frames/s), last frame %016llx\n",
+        raster.frames(), bus->clockCount, seconds, raster.frames() / seconds, (unsigned long long) raster.hash());
+    if(bus->cpu.stop != emu6502::Stop::None){
+        fprintf(stderr, "Stopped at %04X: %s\n", bus->cpu.PC, emu6502::describe(bus->cpu.stop));
+        return 1;
+    }
+    return 0;
+}
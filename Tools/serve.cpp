@@ -0,0 +1,270 @@
+// Job service: runs short programs for clients on a Unix domain socket.
+// Every worker thread keeps a headless bus per layout, which is reset between two jobs with
+// Bus::restore(), so a job only pays for the pages it wrote. Jobs of a connection are spread
+// over all workers, the results are sent back as soon as they are done, tagged with the job id.
+//
+// All numbers are little endian. A job:
+//   u32 size of the rest of the job
+//   u32 id
+//   u8  layout, 0 devices, 1 flat
+//   u16 PC, u8 A, X, Y, SP, P
+//   u64 cycle budget, u64 instruction budget   (0: the default budget of the service)
+//   u8  traps, bit 0 illegal opcode, 1 BRK, 2 jump onto itself, 3 stack wrap, 4 exit write
+//   u16 exit address
+//   u8  number of memory blocks, each: u16 address, u16 length, data
+//   u8  number of memory ranges to return, each: u16 address, u16 length
+// A result:
+//   u32 size of the rest of the result
+//   u32 id
+//   u8  stop reason (emu6502::Stop), 0xFF if the job was malformed
+//   u16 PC, u8 A, X, Y, SP, P, u8 exit value
+//   u64 cycles, u64 instructions
+//   the requested ranges, each: u16 address, u16 length, data
+//
+// Usage: serve [-s socket] [-j workers] [-m cycles]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "bus.h"
+
+struct CONNECTION{
+    int fd;
+    std::mutex writeLock;
+    ~CONNECTION() { close(fd); }
+};
+
+struct JOB{
+    std::shared_ptr<CONNECTION> connection;
+    std::vector<BYTE> data;
+};
+
+static unsigned long long defaultCycles = 100000000;
+
+static std::mutex queueLock;
+static std::condition_variable queueReady;
+static std::deque<JOB> queue;
+
+// Reads the fields of a job, stops at the end of the data
+struct READER{
+    const std::vector<BYTE>& data;
+    size_t at = 0;
+    bool failed = false;
+
+    unsigned long long get(unsigned bytes){
+        if(at + bytes > data.size()){
+            failed = true;
+            return 0;
+        }
+        unsigned long long value = 0;
+        for(unsigned i = 0; i < bytes; i++)
+            value |= (unsigned long long) data[at++] << (8 * i);
+        return value;
+    }
+    const BYTE* block(size_t len){
+        if(at + len > data.size()){
+            failed = true;
+            return nullptr;
+        }
+        at += len;
+        return data.data() + at - len;
+    }
+};
+
+static void put(std::vector<BYTE>& out, unsigned long long value, unsigned bytes){
+    for(unsigned i = 0; i < bytes; i++)
+        out.push_back(value >> (8 * i));
+}
+
+static bool readAll(int fd, void* buffer, size_t len){
+    BYTE* at = (BYTE*) buffer;
+    while(len > 0){
+        ssize_t n = read(fd, at, len);
+        if(n <= 0)
+            return false;
+        at += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void writeAll(CONNECTION& connection, const std::vector<BYTE>& data){
+    std::lock_guard<std::mutex> lock(connection.writeLock);
+    size_t at = 0;
+    while(at < data.size()){
+        ssize_t n = send(connection.fd, data.data() + at, data.size() - at, MSG_NOSIGNAL);
+        if(n <= 0)
+            return;
+        at += n;
+    }
+}
+
+static std::vector<BYTE> execute(Bus& bus, READER& job, unsigned id){
+    emu6502::STATE state = {};
+    state.PC = job.get(2);
+    state.A = job.get(1);
+    state.X = job.get(1);
+    state.Y = job.get(1);
+    state.SP = job.get(1);
+    state.status = job.get(1);
+
+    emu6502::TRAPS traps;
+    traps.maxCycles = job.get(8);
+    traps.maxInstructions = job.get(8);
+    if(traps.maxCycles == 0 || traps.maxCycles > defaultCycles)
+        traps.maxCycles = defaultCycles;
+    BYTE flags = job.get(1);
+    traps.illegalOpcode = flags & 0x01;
+    traps.brk           = flags & 0x02;
+    traps.selfLoop      = flags & 0x04;
+    traps.stackWrap     = flags & 0x08;
+    traps.exitWrite     = flags & 0x10;
+    traps.exitAddress = job.get(2);
+
+    unsigned blocks = job.get(1);
+    for(unsigned i = 0; i < blocks && !job.failed; i++){
+        WORD addr = job.get(2);
+        WORD len = job.get(2);
+        const BYTE* data = job.block(len);
+        if(data)
+            bus.load(addr, data, len);
+    }
+
+    std::vector<BYTE> out;
+    put(out, 0, 4);
+    put(out, id, 4);
+    if(job.failed){
+        out.push_back(0xFF);
+        put(out, 0, 2 + 6 + 16);
+    }
+    else{
+        bus.cpu.load(state);
+        bus.cpu.setTraps(traps);
+        Bus::STOPINFO info = bus.runUntilStop();
+
+        out.push_back((BYTE) info.reason);
+        put(out, info.state.PC, 2);
+        put(out, info.state.A, 1);
+        put(out, info.state.X, 1);
+        put(out, info.state.Y, 1);
+        put(out, info.state.SP, 1);
+        put(out, info.state.status, 1);
+        put(out, info.value, 1);
+        put(out, info.cycles, 8);
+        put(out, info.instructions, 8);
+
+        unsigned ranges = job.get(1);
+        for(unsigned i = 0; i < ranges && !job.failed; i++){
+            WORD addr = job.get(2);
+            WORD len = job.get(2);
+            put(out, addr, 2);
+            put(out, len, 2);
+            for(unsigned j = 0; j < len; j++)
+                out.push_back(bus.read(addr + j));
+        }
+    }
+
+    unsigned size = out.size() - 4;
+    for(unsigned i = 0; i < 4; i++)
+        out[i] = size >> (8 * i);
+    return out;
+}
+
+static void worker(){
+    // Pre-reset machines, restore() brings them back to the checkpoint taken here
+    std::unique_ptr<Bus> machines[2] = { std::make_unique<Bus>(Bus::Layout::Devices), std::make_unique<Bus>(Bus::Layout::Flat) };
+    for(std::unique_ptr<Bus>& bus : machines){
+        // Output of the jobs doesn't belong on the console of the service
+        bus->od.discard = true;
+        bus->checkpoint();
+    }
+
+    while(true){
+        JOB job;
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueReady.wait(lock, []{ return !queue.empty(); });
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        READER reader{ job.data };
+        unsigned id = reader.get(4);
+        Bus& bus = *machines[reader.get(1) == 1 ? 1 : 0];
+        std::vector<BYTE> result = execute(bus, reader, id);
+        bus.restore();
+        bus.cpu.setTraps(emu6502::TRAPS());
+        writeAll(*job.connection, result);
+    }
+}
+
+static void serve(std::shared_ptr<CONNECTION> connection){
+    while(true){
+        BYTE header[4];
+        if(!readAll(connection->fd, header, 4))
+            return;
+        unsigned size = header[0] | (header[1] << 8) | (header[2] << 16) | ((unsigned) header[3] << 24);
+        // The largest job has 255 blocks of 64kB
+        if(size > 256 * 0x10004 + 2048)
+            return;
+        JOB job{ connection, std::vector<BYTE>(size) };
+        if(!readAll(connection->fd, job.data.data(), size))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            queue.push_back(std::move(job));
+        }
+        queueReady.notify_one();
+    }
+}
+
+int main(int argc, char** argv){
+    std::string path = "/tmp/emu6502.sock";
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 1; i + 1 < argc; i++){
+        if(!strcmp(argv[i], "-s"))      path = argv[++i];
+        else if(!strcmp(argv[i], "-j")) workers = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if(!strcmp(argv[i], "-m")) defaultCycles = strtoull(argv[++i], nullptr, 10);
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if(server < 0 || path.size() >= sizeof(addr.sun_path)){
+        printf("Can't create the socket %s\n", path.c_str());
+        return 2;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if(bind(server, (sockaddr*) &addr, sizeof(addr)) < 0 || listen(server, 64) < 0){
+        printf("Can't listen on %s\n", path.c_str());
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    for(unsigned i = 0; i < workers; i++)
+        std::thread(worker).detach();
+    printf("Serving on %s with %u workers\n", path.c_str(), workers);
+    fflush(stdout);
+
+    while(true){
+        int fd = accept(server, nullptr, nullptr);
+        if(fd < 0)
+            continue;
+        std::shared_ptr<CONNECTION> connection(new CONNECTION{ fd, {} });
+        std::thread(serve, connection).detach();
+    }
+}
@@ -0,0 +1,464 @@
+// Conformance runner for the per-opcode JSON single-step test vectors
+// (https://github.com/SingleStepTests/ProcessorTests, folder 6502/v1).
+// Each file holds thousands of vectors for one opcode, consisting of the
+// initial state, the final state and the bus activity of every cycle.
+//
+// Usage: singlestep <directory> [-j threads] [-v] [--allow-missing]
+//
+// Exits with 1 if a vector failed, with 3 if an opcode file is missing (unless --allow-missing
+// is given, for running a partial set) and with 2 if nothing could be run.
+//
+// The files are mapped into memory and parsed in place, the opcode files are
+// shared out to one worker per core. Every worker owns a headless Bus with
+// the flat memory layout.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bus.h"
+
+// The opcodes the CPU variant of the build defines, the 151 official ones for the NMOS 6502.
+// Each variant has its own folder of vectors (6502/v1, synertek65c02/v1, ...).
+static std::vector<BYTE> definedOpcodes(){
+    std::vector<BYTE> opcodes;
+    for(int op = 0; op < 256; op++){
+        if(CPU_OPCODES[op].legal)
+            opcodes.push_back(op);
+    }
+    return opcodes;
+}
+
+// A file mapped read only into memory
+class MappedFile{
+public:
+    MappedFile(const std::string& path){
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return;
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0){
+            void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(ptr != MAP_FAILED){
+                madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+                data = (const char*) ptr;
+                size = st.st_size;
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile(){
+        if(data)
+            munmap((void*) data, size);
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+struct STATE{
+    WORD pc = 0;
+    BYTE s = 0, a = 0, x = 0, y = 0, p = 0;
+    std::vector<std::pair<WORD, BYTE>> ram;
+};
+
+struct VECTOR{
+    std::string_view name;
+    STATE initial;
+    STATE final;
+    std::vector<Bus::ACCESS> cycles;
+};
+
+// Minimal JSON reader which only understands what the vector files use.
+// Strings are returned as views into the mapped file.
+class Parser{
+public:
+    Parser(const char* begin, const char* end) : p(begin), end(end) {}
+
+    // Moves to the first vector of the top level array
+    void begin(){
+        expect('[');
+    }
+
+    // Reads the next vector, returns false at the end of the array
+    bool next(VECTOR& vec){
+        skipWhitespace();
+        if(p < end && *p == ']')
+            return false;
+        if(p < end && *p == ',')
+            p++;
+
+        vec.initial.ram.clear();
+        vec.final.ram.clear();
+        vec.cycles.clear();
+
+        expect('{');
+        do{
+            std::string_view key = string();
+            expect(':');
+            if(key == "name")
+                vec.name = string();
+            else if(key == "initial")
+                state(vec.initial);
+            else if(key == "final")
+                state(vec.final);
+            else if(key == "cycles")
+                cycles(vec.cycles);
+            else
+                skipValue();
+        } while(consume(','));
+        expect('}');
+        return true;
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    void skipWhitespace(){
+        while(p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+            p++;
+    }
+
+    bool consume(char c){
+        skipWhitespace();
+        if(p < end && *p == c){
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c){
+        if(!consume(c))
+            throw std::invalid_argument{std::string("Expected '") + c + "' in vector file"};
+    }
+
+    unsigned number(){
+        skipWhitespace();
+        if(p >= end || *p < '0' || *p > '9')
+            throw std::invalid_argument{"Expected number in vector file"};
+        unsigned value = 0;
+        while(p < end && *p >= '0' && *p <= '9')
+            value = value * 10 + (*p++ - '0');
+        return value;
+    }
+
+    std::string_view string(){
+        expect('"');
+        const char* start = p;
+        while(p < end && *p != '"')
+            p++;
+        std::string_view result(start, p - start);
+        expect('"');
+        return result;
+    }
+
+    void state(STATE& st){
+        expect('{');
+        do{
+            std::string_view key = string();
+            expect(':');
+            if(key == "pc")       st.pc = number();
+            else if(key == "s")   st.s  = number();
+            else if(key == "a")   st.a  = number();
+            else if(key == "x")   st.x  = number();
+            else if(key == "y")   st.y  = number();
+            else if(key == "p")   st.p  = number();
+            else if(key == "ram"){
+                expect('[');
+                if(!consume(']')){
+                    do{
+                        expect('[');
+                        WORD addr = number();
+                        expect(',');
+                        BYTE data = number();
+                        expect(']');
+                        st.ram.push_back({addr, data});
+                    } while(consume(','));
+                    expect(']');
+                }
+            }
+            else
+                skipValue();
+        } while(consume(','));
+        expect('}');
+    }
+
+    void cycles(std::vector<Bus::ACCESS>& list){
+        expect('[');
+        if(consume(']'))
+            return;
+        do{
+            expect('[');
+            WORD addr = number();
+            expect(',');
+            BYTE data = number();
+            expect(',');
+            std::string_view type = string();
+            expect(']');
+            list.push_back({addr, data, type == "write"});
+        } while(consume(','));
+        expect(']');
+    }
+
+    // Skips any value, stops at the next ',' or closing bracket outside of it
+    void skipValue(){
+        int depth = 0;
+        while(p < end){
+            char c = *p;
+            if(c == '"'){
+                string();
+                continue;
+            }
+            if(c == '[' || c == '{')
+                depth++;
+            else if(c == ']' || c == '}'){
+                if(depth == 0)
+                    return;
+                depth--;
+            }
+            else if(c == ',' && depth == 0)
+                return;
+            p++;
+        }
+    }
+};
+
+// Keeps only the last of consecutive writes to the same address. The atomic CPU
+// doesn't perform the dummy write of read-modify-write instructions.
+static std::vector<Bus::ACCESS> collapsedWrites(const std::vector<Bus::ACCESS>& list){
+    std::vector<Bus::ACCESS> result;
+    for(const Bus::ACCESS& a : list){
+        if(!a.write)
+            continue;
+        if(!result.empty() && result.back().addr == a.addr)
+            result.back() = a;
+        else
+            result.push_back(a);
+    }
+    return result;
+}
+
+struct RESULT{
+    unsigned long passed = 0;
+    unsigned long failed = 0;
+    bool missing = false;
+};
+
+struct OPTIONS{
+    std::string directory;
+    unsigned threads = 0;
+    bool verbose = false;
+    bool allowMissing = false;
+    unsigned maxReports = 3;    // Failures printed per opcode
+};
+
+static std::mutex printMutex;
+
+// Runs a single vector, returns an empty string on success or a description of the first mismatch
+static std::string runVector(Bus& bus, std::vector<Bus::ACCESS>& log, const VECTOR& vec){
+    char buffer[128];
+
+    // Setting up the initial state without recording it
+    bus.accessLog = nullptr;
+    for(const auto& [addr, data] : vec.initial.ram)
+        bus.write(addr, data);
+    bus.cpu.PC = vec.initial.pc;
+    bus.cpu.SP = vec.initial.s;
+    bus.cpu.A  = vec.initial.a;
+    bus.cpu.X  = vec.initial.x;
+    bus.cpu.Y  = vec.initial.y;
+    bus.cpu.setStatus(vec.initial.p);
+
+    // Executing one instruction
+    log.clear();
+    bus.accessLog = &log;
+    unsigned cycles = 0;
+    do{
+        bus.cpu.clock();
+        cycles++;
+    } while(!bus.cpu.completed());
+    bus.accessLog = nullptr;
+
+    // Registers, B and U are no real flags and are therefore ignored
+    const STATE& f = vec.final;
+    if(bus.cpu.PC != f.pc){
+        snprintf(buffer, sizeof(buffer), "PC expected %04X got %04X", f.pc, bus.cpu.PC);
+        return buffer;
+    }
+    const struct { const char* name; BYTE expected; BYTE got; } regs[] = {
+        {"SP", f.s, bus.cpu.SP}, {"A", f.a, bus.cpu.A}, {"X", f.x, bus.cpu.X}, {"Y", f.y, bus.cpu.Y},
+        {"P", (BYTE)(f.p & ~0x30), (BYTE)(bus.cpu.getStatus() & ~0x30)}
+    };
+    for(const auto& r : regs){
+        if(r.expected != r.got){
+            snprintf(buffer, sizeof(buffer), "%s expected %02X got %02X", r.name, r.expected, r.got);
+            return buffer;
+        }
+    }
+
+    // Memory
+    for(const auto& [addr, data] : f.ram){
+        BYTE got = bus.read(addr);
+        if(got != data){
+            snprintf(buffer, sizeof(buffer), "memory %04X expected %02X got %02X", addr, data, got);
+            return buffer;
+        }
+    }
+
+    // Bus activity, the cycle accurate CPU has to match every cycle
+    if constexpr(emu6502::accurate){
+        for(size_t i = 0; i < vec.cycles.size() && i < log.size(); i++){
+            const Bus::ACCESS& e = vec.cycles[i];
+            const Bus::ACCESS& g = log[i];
+            if(e.addr != g.addr || e.data != g.data || e.write != g.write){
+                snprintf(buffer, sizeof(buffer), "cycle %zu expected %s %02X at %04X got %s %02X at %04X", i,
+                    e.write ? "write" : "read", e.data, e.addr, g.write ? "write" : "read", g.data, g.addr);
+                return buffer;
+            }
+        }
+    }
+    std::vector<Bus::ACCESS> expected = collapsedWrites(vec.cycles);
+    std::vector<Bus::ACCESS> written = collapsedWrites(log);
+    if(expected.size() != written.size()){
+        snprintf(buffer, sizeof(buffer), "%zu writes expected got %zu", expected.size(), written.size());
+        return buffer;
+    }
+    for(size_t i = 0; i < expected.size(); i++){
+        if(expected[i].addr != written[i].addr || expected[i].data != written[i].data){
+            snprintf(buffer, sizeof(buffer), "write %zu expected %02X to %04X got %02X to %04X", i,
+                expected[i].data, expected[i].addr, written[i].data, written[i].addr);
+            return buffer;
+        }
+    }
+
+    // Cycles
+    if(cycles != vec.cycles.size()){
+        snprintf(buffer, sizeof(buffer), "%zu cycles expected got %u", vec.cycles.size(), cycles);
+        return buffer;
+    }
+
+    return "";
+}
+
+static RESULT runFile(Bus& bus, const OPTIONS& options, BYTE opcode){
+    RESULT result;
+
+    char name[16];
+    snprintf(name, sizeof(name), "/%02x.json", opcode);
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>(options.directory + name);
+    if(!file->data){
+        snprintf(name, sizeof(name), "/%02X.json", opcode);
+        file = std::make_unique<MappedFile>(options.directory + name);
+    }
+    if(!file->data){
+        result.missing = true;
+        return result;
+    }
+
+    std::vector<Bus::ACCESS> log;
+    log.reserve(16);
+    VECTOR vec;
+
+    Parser parser(file->data, file->data + file->size);
+    try{
+        parser.begin();
+        while(parser.next(vec)){
+            std::string error = runVector(bus, log, vec);
+            if(error.empty()){
+                result.passed++;
+                continue;
+            }
+            result.failed++;
+            if(result.failed <= options.maxReports){
+                std::lock_guard<std::mutex> lock(printMutex);
+                printf("%02X \"%.*s\": %s\n", opcode, (int) vec.name.size(), vec.name.data(), error.c_str());
+            }
+        }
+    }
+    catch(const std::invalid_argument& e){
+        std::lock_guard<std::mutex> lock(printMutex);
+        printf("%02X: %s\n", opcode, e.what());
+        result.failed++;
+    }
+    return result;
+}
+
+int main(int argc, char** argv){
+    OPTIONS options;
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "-j") && i + 1 < argc)
+            options.threads = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-v"))
+            options.verbose = true;
+        else if(!strcmp(argv[i], "--allow-missing"))
+            options.allowMissing = true;
+        else
+            options.directory = argv[i];
+    }
+    if(options.directory.empty()){
+        printf("Usage: %s <directory> [-j threads] [-v] [--allow-missing]\n", argv[0]);
+        return 2;
+    }
+    if(options.threads == 0)
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const std::vector<BYTE> opcodes = definedOpcodes();
+    const size_t count = opcodes.size();
+    std::vector<RESULT> results(count);
+    std::atomic<size_t> nextFile{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Each worker takes the next opcode file until all are done
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < options.threads; t++){
+        workers.emplace_back([&](){
+            std::unique_ptr<Bus> bus = std::make_unique<Bus>(Bus::Layout::Flat);
+            for(size_t i = nextFile++; i < count; i = nextFile++)
+                results[i] = runFile(*bus, options, opcodes[i]);
+        });
+    }
+    for(std::thread& w : workers)
+        w.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned long passed = 0, failed = 0;
+    unsigned missing = 0, failedOpcodes = 0;
+    for(size_t i = 0; i < count; i++){
+        const RESULT& r = results[i];
+        passed += r.passed;
+        failed += r.failed;
+        missing += r.missing;
+        failedOpcodes += (r.failed > 0);
+        if(r.missing && options.verbose)
+            printf("%02X: no vector file\n", opcodes[i]);
+        else if(r.failed > 0 || options.verbose)
+            printf("%02X: %lu passed, %lu failed\n", opcodes[i], r.passed, r.failed);
+    }
+
+    printf("%lu passed, %lu failed (%u opcodes failing, %u files missing) in %.2fs, %.0f vectors/s on %u threads\n",
+        passed, failed, failedOpcodes, missing, seconds, (passed + failed) / seconds, options.threads);
+
+    if(passed + failed == 0)
+        return 2;
+    if(failed > 0)
+        return 1;
+    return missing > 0 && !options.allowMissing ? 3 : 0;
+}
@@ -0,0 +1,128 @@
+// Shows the statistics a running emulator publishes with Metrics, without stopping it.
+// The page is read under its seqlock, the rates are computed between two reads.
+//
+// Usage: stats [-n name] [-i milliseconds] [-c count] [-o opcodes]
+//        -n: shared memory object, by default the only /emu6502-<pid> there is
+//        -c: number of reports, 0 (default) until the emulator exits
+//        -o: number of the most executed opcodes to list, 8 by default
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+#include "metrics.h"
+
+// The object of the only emulator which runs, empty if there is none or several
+static std::string findObject(){
+    std::vector<std::string> found;
+    if(DIR* dir = opendir("/dev/shm")){
+        while(struct dirent* entry = readdir(dir)){
+            if(!strncmp(entry->d_name, "emu6502-", 8))
+                found.push_back(std::string("/") + entry->d_name);
+        }
+        closedir(dir);
+    }
+    if(found.size() > 1){
+        for(const std::string& name : found)
+            printf("%s\n", name.c_str());
+    }
+    return found.size() == 1 ? found[0] : std::string();
+}
+
+int main(int argc, char** argv){
+    const char* name = nullptr;
+    unsigned interval = 1000;
+    unsigned long count = 0;
+    unsigned opcodes = 8;
+
+    for(int i = 1; i + 1 < argc; i++){
+        if(!strcmp(argv[i], "-n"))      name = argv[++i];
+        else if(!strcmp(argv[i], "-i")) interval = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if(!strcmp(argv[i], "-c")) count = strtoul(argv[++i], nullptr, 10);
+        else if(!strcmp(argv[i], "-o")) opcodes = std::min(256ul, strtoul(argv[++i], nullptr, 10));
+    }
+
+    std::string object;
+    if(!name){
+        object = findObject();
+        if(object.empty()){
+            printf("No single emulator found, choose one with -n\n");
+            return 2;
+        }
+        name = object.c_str();
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if(fd < 0){
+        printf("No emulator publishes to %s\n", name);
+        return 2;
+    }
+    void* data = mmap(nullptr, sizeof(Metrics::PAGE), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED){
+        printf("Can't map %s\n", name);
+        return 2;
+    }
+    const Metrics::PAGE* page = (const Metrics::PAGE*) data;
+    if(page->magic != Metrics::MAGIC || page->version != Metrics::VERSION){
+        printf("%s isn't a page of this version\n", name);
+        return 2;
+    }
+
+    std::unique_ptr<Metrics::PAGE> last = std::make_unique<Metrics::PAGE>();
+    std::unique_ptr<Metrics::PAGE> now = std::make_unique<Metrics::PAGE>();
+    if(!Metrics::read(page, *last))
+        return 1;
+
+    for(unsigned long n = 0; count == 0 || n < count; n++){
+        usleep(interval * 1000);
+        // The emulator removes the object when it exits, the mapping stays valid
+        struct stat info;
+        if(stat((std::string("/dev/shm") + name).c_str(), &info) != 0)
+            break;
+        if(!Metrics::read(page, *now)){
+            printf("The page is busy\n");
+            continue;
+        }
+
+        double seconds = (now->hostNs - last->hostNs) / 1e9;
+        if(seconds <= 0)
+            seconds = interval / 1000.0;
+        printf("%.1fs: %llu instructions (%.2f M/s), %llu cycles (%.2f MHz), %.0f ns per emulated second\n",
+            now->hostNs / 1e9, (unsigned long long) now->instructions, (now->instructions - last->instructions) / seconds / 1e6,
+            (unsigned long long) now->cycles, (now->cycles - last->cycles) / seconds / 1e6, (double) now->hostNsPerSecond);
+        printf("  draw commands %llu (%.0f/s), frames %llu (%.1f/s), bitmap rows %llu (%.0f/s), input events %llu, device resumes %llu\n",
+            (unsigned long long) now->drawCommands, (now->drawCommands - last->drawCommands) / seconds,
+            (unsigned long long) now->frames, (now->frames - last->frames) / seconds,
+            (unsigned long long) now->bitmapRows, (now->bitmapRows - last->bitmapRows) / seconds,
+            (unsigned long long) now->inputEvents, (unsigned long long) now->deviceResumes);
+
+        printf("  %-10s %14s %14s\n", "region", "reads", "writes");
+        for(unsigned r = 0; r < REGION_COUNT; r++){
+            if(now->reads[r] || now->writes[r])
+                printf("  %-10s %14llu %14llu\n", Metrics::regionName(r), (unsigned long long) now->reads[r], (unsigned long long) now->writes[r]);
+        }
+
+        unsigned order[256];
+        for(unsigned op = 0; op < 256; op++)
+            order[op] = op;
+        std::sort(order, order + 256, [&](unsigned a, unsigned b){ return now->opcodes[a] > now->opcodes[b]; });
+        printf("  opcodes:");
+        for(unsigned i = 0; i < opcodes && now->opcodes[order[i]]; i++)
+            printf(" %02X %llu", order[i], (unsigned long long) now->opcodes[order[i]]);
+        printf("\n");
+        fflush(stdout);
+
+        std::swap(last, now);
+    }
+    return 0;
+}